@@ -1,29 +1,20 @@
 #version 460
 
 layout (location = 0) in vec2 fragOffset;
+layout (location = 1) in vec3 fragColor;
 
 layout (location = 0) out vec4 outColor;
 
-struct PointLight{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
 layout(set = 0, binding = 0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
+	uvec4 clusterCount; // light cluster grid, w unused
+	vec4 clusterParams; // xy pixels per tile, slice = log(viewZ) * z - w
 	int numLights;
 } ubo;
 
-layout(push_constant) uniform Push{
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
-
 const float M_PI = 3.1415926538;
 
 void main(){
@@ -34,5 +25,5 @@ void main(){
 	}
 
 	float cosDis = 0.5 * (cos(dis * M_PI) + 1.0);
-	outColor = vec4(push.color.xyz + cosDis, cosDis);
+	outColor = vec4(fragColor + cosDis, cosDis);
 }
\ No newline at end of file
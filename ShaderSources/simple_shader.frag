@@ -8,7 +8,7 @@ layout (location = 3) in vec2 fragTexCoord;
 layout (location = 0) out vec4 outColor;
 
 struct PointLight{
-	vec4 position; // ignore w
+	vec4 position; // w is the range, the light is cut off past it
 	vec4 color; // w is intensity
 };
 
@@ -17,10 +17,24 @@ layout(set = 0, binding = 0) uniform GlobalUbo{
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
+	uvec4 clusterCount; // light cluster grid, w unused
+	vec4 clusterParams; // xy pixels per tile, slice = log(viewZ) * z - w
 	int numLights;
 } ubo;
 
+layout(std430, set = 0, binding = 1) readonly buffer Lights{
+	PointLight pointLights[];
+};
+
+// lights of cluster i are clusterLightIndices[clusters[i].x .. clusters[i].x + clusters[i].y)
+layout(std430, set = 0, binding = 2) readonly buffer Clusters{
+	uvec2 clusters[];
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer ClusterLights{
+	uint clusterLightIndices[];
+};
+
 layout(set = 1, binding = 0) uniform sampler2D texSampler;
 
 layout(push_constant) uniform Push{
@@ -36,12 +50,24 @@ void main(){
 	vec3 cameraPosWorld = ubo.invView[3].xyz;
 	vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-	for(int i = 0; i < ubo.numLights; i++)
+	float viewZ = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+	uvec3 cluster = uvec3(
+		uvec2(gl_FragCoord.xy / ubo.clusterParams.xy),
+		uint(max(log(viewZ) * ubo.clusterParams.z - ubo.clusterParams.w, 0.0))
+	);
+	cluster = min(cluster, ubo.clusterCount.xyz - 1);
+	uvec2 lightRange = clusters[cluster.x + ubo.clusterCount.x * (cluster.y + ubo.clusterCount.y * cluster.z)];
+
+	for(uint i = 0; i < lightRange.y; i++)
 	{
-		PointLight light = ubo.pointLights[i];
+		PointLight light = pointLights[clusterLightIndices[lightRange.x + i]];
 
 		vec3 directionToLight = light.position.xyz - fragPosWorld;
-		float attenuation = 1.0 / dot(directionToLight, directionToLight);
+		float distanceSquared = dot(directionToLight, directionToLight);
+		// fades to zero at the range, so dropping the light outside of its clusters leaves no edge
+		float window = distanceSquared / (light.position.w * light.position.w);
+		window = clamp(1.0 - window * window, 0.0, 1.0);
+		float attenuation = window * window / distanceSquared;
 		directionToLight = normalize(directionToLight);
 
 		float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
@@ -54,7 +80,7 @@ void main(){
 		float blinnTerm = dot(surfaceNormal, halfAngle);
 		blinnTerm = clamp(blinnTerm, 0, 1);
 		blinnTerm = pow(blinnTerm, 512.0); // higher values -> sharper highlight
-		specularLight = intensity * blinnTerm;
+		specularLight += intensity * blinnTerm;
 	}
 
 	vec4 textColor = texture(texSampler, fragTexCoord);
@@ -10,17 +10,13 @@ layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragTexCoord;
 
-struct PointLight{
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
 layout(set = 0, binding = 0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
+	uvec4 clusterCount; // light cluster grid, w unused
+	vec4 clusterParams; // xy pixels per tile, slice = log(viewZ) * z - w
 	int numLights;
 } ubo;
 
@@ -0,0 +1,46 @@
+#version 460
+
+// LveModel::VertexFormat::Compact
+layout(location = 0) in vec4 position; // unorm16 in mesh bounds, modelMatrix dequantizes
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 normal; // oct snorm16
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragTexCoord;
+
+layout(set = 0, binding = 0) uniform GlobalUbo{
+	mat4 projection;
+	mat4 view;
+	mat4 invView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterCount; // light cluster grid, w unused
+	vec4 clusterParams; // xy pixels per tile, slice = log(viewZ) * z - w
+	int numLights;
+} ubo;
+
+layout(push_constant) uniform Push{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+} push;
+
+// octahedral normal, same as LveVertexQuantizer
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+void main() {
+	vec4 positionWorld = push.modelMatrix * vec4(position.xyz, 1.0);
+	gl_Position  = ubo.projection * ubo.view * positionWorld;
+
+	fragNormalWorld = normalize(mat3(push.normalMatrix) * octDecode(normal));
+	fragPosWorld = positionWorld.xyz;
+	fragColor = color.rgb;
+	fragTexCoord = uv;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#version 460
+
+// LveModel::VertexFormat::Compact16
+layout(location = 0) in vec4 position; // xyz unorm16 in mesh bounds, modelMatrix dequantizes; w packs the oct normal
+layout(location = 1) in vec4 color;
+layout(location = 3) in vec2 uv;
+
+// SimpleRenderSystem InstanceData, one per instance from binding 1
+layout(location = 4) in mat4 instanceModelMatrix;
+layout(location = 8) in mat3 instanceNormalMatrix;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragTexCoord;
+
+layout(set = 0, binding = 0) uniform GlobalUbo{
+	mat4 projection;
+	mat4 view;
+	mat4 invView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterCount; // light cluster grid, w unused
+	vec4 clusterParams; // xy pixels per tile, slice = log(viewZ) * z - w
+	int numLights;
+} ubo;
+
+// octahedral normal, same as LveVertexQuantizer
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+// two oct snorm8 values stored as 0..254 in the 16 bits of position.w
+vec3 unpackNormal(float packedNormal) {
+	uint bits = uint(round(packedNormal * 65535.0));
+	vec2 e = (vec2(bits & 0xFFu, bits >> 8) - 127.0) / 127.0;
+	return octDecode(e);
+}
+
+void main() {
+	vec4 positionWorld = instanceModelMatrix * vec4(position.xyz, 1.0);
+	gl_Position  = ubo.projection * ubo.view * positionWorld;
+
+	fragNormalWorld = normalize(instanceNormalMatrix * unpackNormal(position.w));
+	fragPosWorld = positionWorld.xyz;
+	fragColor = color.rgb;
+	fragTexCoord = uv;
+}
\ No newline at end of file
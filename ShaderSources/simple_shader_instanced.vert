@@ -0,0 +1,35 @@
+#version 460
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 uv;
+
+// SimpleRenderSystem InstanceData, one per instance from binding 1
+layout(location = 4) in mat4 instanceModelMatrix;
+layout(location = 8) in mat3 instanceNormalMatrix;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragTexCoord;
+
+layout(set = 0, binding = 0) uniform GlobalUbo{
+	mat4 projection;
+	mat4 view;
+	mat4 invView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterCount; // light cluster grid, w unused
+	vec4 clusterParams; // xy pixels per tile, slice = log(viewZ) * z - w
+	int numLights;
+} ubo;
+
+void main() {
+	vec4 positionWorld = instanceModelMatrix * vec4(position, 1.0);
+	gl_Position  = ubo.projection * ubo.view * positionWorld;
+
+	fragNormalWorld = normalize(instanceNormalMatrix * normal);
+	fragPosWorld = positionWorld.xyz;
+	fragColor = color;
+	fragTexCoord = uv;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace lve
+{
+	/// <returns>the fastest of repeats runs of function in seconds, the others lost time to caches and the scheduler</returns>
+	template<typename F>
+	double bestSeconds(uint32_t repeats, F&& function)
+	{
+		double best = 1e30;
+		for (uint32_t i = 0; i < repeats; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double>(end - start).count());
+		}
+		return best;
+	}
+}
@@ -0,0 +1,35 @@
+#include "Benchmarks.hpp"
+
+#include <iostream>
+#include <map>
+
+namespace lve
+{
+	int runBenchmark(const std::string& name, const std::vector<std::string>& args)
+	{
+		using BenchmarkFunction = int (*)(const std::vector<std::string>&);
+		static const std::map<std::string, BenchmarkFunction> benchmarks{
+			{ "obj_parse", runObjParseBenchmark },
+			{ "vertex_dedup", runVertexDedupBenchmark },
+			{ "mesh_optimize", runMeshOptimizeBenchmark },
+			{ "vertex_formats", runVertexFormatBenchmark },
+			{ "meshlets", runMeshletBenchmark },
+			{ "frustum_cull", runFrustumCullBenchmark },
+			{ "transforms", runTransformBenchmark },
+		};
+
+		auto it = benchmarks.find(name);
+		if (it == benchmarks.end())
+		{
+			std::cerr << "unknown benchmark: " << name << "\navailable:";
+			for (const auto& [benchmarkName, function] : benchmarks)
+			{
+				std::cerr << ' ' << benchmarkName;
+			}
+			std::cerr << '\n';
+			return 1;
+		}
+
+		return it->second(args);
+	}
+}
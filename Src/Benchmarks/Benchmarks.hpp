@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	// CPU side benchmarks, started with `--bench <name> [args...]`.
+	// They need no window or Vulkan device and print their results to stdout.
+
+	/// <returns>process exit code</returns>
+	int runBenchmark(const std::string& name, const std::vector<std::string>& args);
+
+	/// <summary>
+	/// Multithreaded OBJ parsing against tinyobj. args: [path to .obj], a synthetic mesh is generated otherwise
+	/// </summary>
+	int runObjParseBenchmark(const std::vector<std::string>& args);
+
+	/// <summary>
+	/// Vertex deduplication, std::unordered_map against the flat table. args: [grid size]
+	/// </summary>
+	int runVertexDedupBenchmark(const std::vector<std::string>& args);
+
+	/// <summary>
+	/// ACMR/ATVR before and after every LveMeshOptimizer stage. args: [path to .obj]
+	/// </summary>
+	int runMeshOptimizeBenchmark(const std::vector<std::string>& args);
+
+	/// <summary>
+	/// Size and measured quantization error of every LveModel::VertexFormat. args: [paths to .obj]
+	/// </summary>
+	int runVertexFormatBenchmark(const std::vector<std::string>& args);
+
+	/// <summary>
+	/// LveMeshlets on a grid and a closed sphere: meshlet limits, triangle coverage, sphere and normal cone culling.
+	/// args: [grid size]
+	/// </summary>
+	int runMeshletBenchmark(const std::vector<std::string>& args);
+
+	/// <summary>
+	/// Frustum culling of world space boxes, scalar against LveFrustum::cullAabbs. args: [box count]
+	/// </summary>
+	int runFrustumCullBenchmark(const std::vector<std::string>& args);
+
+	/// <summary>
+	/// TransformComponent::mat4 and normalMatrix per object against TransformSystem, all and some transforms dirty.
+	/// args: [object count] [dirty percent]
+	/// </summary>
+	int runTransformBenchmark(const std::vector<std::string>& args);
+}
@@ -0,0 +1,64 @@
+#include "Benchmarks.hpp"
+#include "BenchmarkUtils.hpp"
+
+#include "../lve_frustum.hpp"
+
+//libs
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdio>
+#include <random>
+
+namespace lve
+{
+	int runFrustumCullBenchmark(const std::vector<std::string>& args)
+	{
+		constexpr uint32_t repeats = 20;
+
+		uint32_t count = args.empty() ? 100000 : static_cast<uint32_t>(std::stoul(args[0]));
+
+		// boxes scattered around a camera at the origin, roughly a third of them in view
+		std::mt19937 random{ 42 };
+		std::uniform_real_distribution<float> position{ -50.f, 50.f };
+		std::uniform_real_distribution<float> size{ 0.1f, 2.f };
+		LveAabbBatch boxes;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			boxes.push({ position(random), position(random) * 0.2f, position(random) }, { size(random), size(random), size(random) });
+		}
+
+		auto projection = glm::perspective(glm::radians(50.f), 16.f / 9.f, 0.1f, 100.f);
+		auto view = glm::lookAt(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, 1.f }, glm::vec3{ 0.f, -1.f, 0.f });
+		auto frustum = LveFrustum::fromMatrix(projection * view);
+
+		std::vector<uint8_t> scalarVisible(count);
+		uint32_t scalarCount = 0;
+		auto scalarTime = bestSeconds(repeats, [&]() {
+			scalarCount = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				scalarVisible[i] = frustum.intersectsAabb(
+					{ boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i] },
+					{ boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i] }
+				) ? 1 : 0;
+				scalarCount += scalarVisible[i];
+			}
+		});
+
+		std::vector<uint8_t> simdVisible;
+		uint32_t simdCount = 0;
+		auto simdTime = bestSeconds(repeats, [&]() {
+			simdCount = frustum.cullAabbs(boxes, simdVisible);
+		});
+
+		bool identical = scalarVisible == simdVisible && scalarCount == simdCount;
+
+		auto perBox = [&](double seconds) { return seconds * 1e9 / static_cast<double>(count); };
+		std::printf("frustum_cull: %u boxes, %u visible, %u culled\n", count, simdCount, count - simdCount);
+		std::printf("  scalar         %8.3f ms %6.2f ns/box\n", scalarTime * 1000.0, perBox(scalarTime));
+		std::printf("  simd %u wide    %8.3f ms %6.2f ns/box  x%.2f  %s\n",
+			LveFrustum::SIMD_WIDTH, simdTime * 1000.0, perBox(simdTime), scalarTime / simdTime, identical ? "identical" : "MISMATCH");
+
+		return identical ? 0 : 1;
+	}
+}
@@ -0,0 +1,204 @@
+#include "Benchmarks.hpp"
+
+#include "../lve_model.hpp"
+#include "../lve_mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../../../" 
+#endif // !ENGINE_DIR
+
+namespace lve
+{
+	namespace
+	{
+		// size x size grid with triangles in random order, the worst case for the post-transform cache
+		LveModel::Builder makeShuffledGrid(uint32_t size)
+		{
+			LveModel::Builder builder{};
+			for (uint32_t y = 0; y < size; y++)
+			{
+				for (uint32_t x = 0; x < size; x++)
+				{
+					LveModel::Vertex vertex{};
+					vertex.position = { static_cast<float>(x), 0.f, static_cast<float>(y) };
+					vertex.normal = { 0.f, 1.f, 0.f };
+					builder.vertices.push_back(vertex);
+				}
+			}
+
+			std::vector<std::array<uint32_t, 3>> triangles;
+			for (uint32_t y = 0; y + 1 < size; y++)
+			{
+				for (uint32_t x = 0; x + 1 < size; x++)
+				{
+					uint32_t a = y * size + x;
+					triangles.push_back({ a, a + 1, a + size + 1 });
+					triangles.push_back({ a, a + size + 1, a + size });
+				}
+			}
+
+			std::shuffle(triangles.begin(), triangles.end(), std::mt19937{ 42 });
+			for (const auto& triangle : triangles)
+			{
+				builder.indices.insert(builder.indices.end(), triangle.begin(), triangle.end());
+			}
+
+			builder.computeBounds();
+			return builder;
+		}
+
+		void printStats(const char* stage, const LveModel::Builder& builder, double milliseconds)
+		{
+			auto stats = LveMeshOptimizer::analyzeVertexCache(builder.indices.data(), builder.indices.size(), builder.vertices.size());
+			auto stats32 = LveMeshOptimizer::analyzeVertexCache(builder.indices.data(), builder.indices.size(), builder.vertices.size(), 32);
+			std::printf("  %-14s ACMR %.3f ATVR %.3f | cache 32: ACMR %.3f ATVR %.3f | %8.2f ms\n",
+				stage, stats.acmr, stats.atvr, stats32.acmr, stats32.atvr, milliseconds);
+		}
+
+		// same stages as Builder::optimize, timed one by one
+		void optimizeAndReport(const char* name, LveModel::Builder builder)
+		{
+			std::printf("%s: %zu vertices, %zu triangles\n", name, builder.vertices.size(), builder.indices.size() / 3);
+			printStats("input", builder, 0.0);
+
+			auto timed = [](auto&& function) {
+				auto start = std::chrono::high_resolution_clock::now();
+				function();
+				auto end = std::chrono::high_resolution_clock::now();
+				return std::chrono::duration<double, std::milli>(end - start).count();
+			};
+
+			auto time = timed([&]() {
+				LveMeshOptimizer::optimizeVertexCache(builder.indices.data(), builder.indices.size(), builder.vertices.size());
+			});
+			printStats("vertex cache", builder, time);
+
+			time = timed([&]() {
+				LveMeshOptimizer::optimizeOverdraw(
+					builder.indices.data(),
+					builder.indices.size(),
+					&builder.vertices[0].position.x,
+					sizeof(LveModel::Vertex),
+					builder.vertices.size()
+				);
+			});
+			printStats("overdraw", builder, time);
+
+			time = timed([&]() {
+				auto vertexCount = LveMeshOptimizer::optimizeVertexFetch(
+					builder.vertices.data(),
+					builder.vertices.size(),
+					sizeof(LveModel::Vertex),
+					builder.indices.data(),
+					builder.indices.size()
+				);
+				builder.vertices.resize(vertexCount);
+			});
+			printStats("vertex fetch", builder, time);
+		}
+
+		// a grid above the 16 bit limit with lods, split the way createModelFromFile does it: the lods have to reuse
+		// the vertex ranges of the full detail level instead of copying their vertices
+		bool splitAndReport(uint32_t size)
+		{
+			auto builder = makeShuffledGrid(size);
+			builder.optimize();
+			builder.generateLods();
+			auto source = builder;
+			builder.splitForShortIndices();
+
+			bool fits = true;
+			bool same = true;
+			for (const auto& lod : builder.lods)
+			{
+				for (auto s = lod.firstSubmesh; s < lod.firstSubmesh + lod.submeshCount; s++)
+				{
+					const auto& submesh = builder.submeshes[s];
+					for (auto i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++)
+					{
+						fits &= builder.indices[i] < LveModel::MAX_SHORT_INDEX_VERTICES &&
+							submesh.vertexOffset + builder.indices[i] < builder.vertices.size();
+					}
+				}
+			}
+			// every lod draws the same triangles, split keeps the index positions
+			for (size_t lod = 0; fits && lod < builder.lods.size(); lod++)
+			{
+				const auto& range = source.submeshes[source.lods[lod].firstSubmesh];
+				const auto& split = builder.lods[lod];
+				for (auto s = split.firstSubmesh; s < split.firstSubmesh + split.submeshCount; s++)
+				{
+					const auto& submesh = builder.submeshes[s];
+					same &= submesh.firstIndex >= range.firstIndex && submesh.firstIndex + submesh.indexCount <= range.firstIndex + range.indexCount;
+				}
+				std::vector<std::array<float, 9>> expected, actual;
+				for (auto i = range.firstIndex; i < range.firstIndex + range.indexCount; i += 3)
+				{
+					std::array<float, 9> triangle{};
+					for (uint32_t corner = 0; corner < 3; corner++)
+					{
+						auto position = source.vertices[source.indices[i + corner]].position;
+						triangle[corner * 3] = position.x;
+						triangle[corner * 3 + 1] = position.y;
+						triangle[corner * 3 + 2] = position.z;
+					}
+					expected.push_back(triangle);
+				}
+				for (auto s = split.firstSubmesh; s < split.firstSubmesh + split.submeshCount; s++)
+				{
+					const auto& submesh = builder.submeshes[s];
+					for (auto i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i += 3)
+					{
+						std::array<float, 9> triangle{};
+						for (uint32_t corner = 0; corner < 3; corner++)
+						{
+							auto position = builder.vertices[submesh.vertexOffset + builder.indices[i + corner]].position;
+							triangle[corner * 3] = position.x;
+							triangle[corner * 3 + 1] = position.y;
+							triangle[corner * 3 + 2] = position.z;
+						}
+						actual.push_back(triangle);
+					}
+				}
+				std::sort(expected.begin(), expected.end());
+				std::sort(actual.begin(), actual.end());
+				same &= expected == actual;
+			}
+
+			// the windows only repeat the vertices along their borders
+			double growth = static_cast<double>(builder.vertices.size()) / static_cast<double>(source.vertices.size());
+			bool close = growth <= 1.1;
+			std::printf("split %ux%u grid: %zu lods, %zu -> %zu vertices (%.3fx) in %zu submeshes\n",
+				size, size, builder.lods.size(), source.vertices.size(), builder.vertices.size(), growth, builder.submeshes.size());
+			std::printf("  indices fit 16 bit  %s\n", fits ? "ok" : "MISMATCH");
+			std::printf("  lods draw the same triangles  %s\n", same ? "ok" : "MISMATCH");
+			std::printf("  vertex count close to the source  %s\n", close ? "ok" : "MISMATCH");
+			return fits && same && close && builder.lods.size() > 1;
+		}
+	}
+
+	int runMeshOptimizeBenchmark(const std::vector<std::string>& args)
+	{
+		if (!args.empty())
+		{
+			LveModel::Builder builder{};
+			builder.loadModel(args[0]);
+			optimizeAndReport(args[0].c_str(), std::move(builder));
+			return 0;
+		}
+
+		optimizeAndReport("shuffled grid", makeShuffledGrid(512));
+
+		LveModel::Builder vase{};
+		vase.loadModel(ENGINE_DIR + std::string("Models/smooth_vase.obj"));
+		optimizeAndReport("smooth_vase.obj", std::move(vase));
+
+		return splitAndReport(400) ? 0 : 1;
+	}
+}
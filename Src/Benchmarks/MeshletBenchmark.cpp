@@ -0,0 +1,270 @@
+#include "Benchmarks.hpp"
+#include "BenchmarkUtils.hpp"
+
+#include "../lve_meshlets.hpp"
+
+//libs
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <unordered_set>
+
+namespace lve
+{
+	namespace
+	{
+		struct Mesh
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+		};
+
+		// size x size vertices in the xz plane, open
+		Mesh makeGrid(uint32_t size)
+		{
+			Mesh mesh{};
+			for (uint32_t y = 0; y < size; y++)
+			{
+				for (uint32_t x = 0; x < size; x++)
+				{
+					mesh.positions.push_back({ static_cast<float>(x), 0.f, static_cast<float>(y) });
+				}
+			}
+			for (uint32_t y = 0; y + 1 < size; y++)
+			{
+				for (uint32_t x = 0; x + 1 < size; x++)
+				{
+					uint32_t a = y * size + x;
+					mesh.indices.insert(mesh.indices.end(), { a, a + 1, a + size + 1 });
+					mesh.indices.insert(mesh.indices.end(), { a, a + size + 1, a + size });
+				}
+			}
+			return mesh;
+		}
+
+		// unit sphere around the origin, closed: one vertex per pole and no seam
+		Mesh makeSphere(uint32_t rings, uint32_t segments)
+		{
+			Mesh mesh{};
+			mesh.positions.push_back({ 0.f, 1.f, 0.f });
+			for (uint32_t r = 1; r < rings; r++)
+			{
+				float theta = glm::pi<float>() * static_cast<float>(r) / static_cast<float>(rings);
+				for (uint32_t s = 0; s < segments; s++)
+				{
+					float phi = glm::two_pi<float>() * static_cast<float>(s) / static_cast<float>(segments);
+					mesh.positions.push_back({ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+				}
+			}
+			auto south = static_cast<uint32_t>(mesh.positions.size());
+			mesh.positions.push_back({ 0.f, -1.f, 0.f });
+
+			auto ring = [&](uint32_t r, uint32_t s) { return 1 + (r - 1) * segments + s % segments; };
+			for (uint32_t s = 0; s < segments; s++)
+			{
+				mesh.indices.insert(mesh.indices.end(), { 0, ring(1, s + 1), ring(1, s) });
+				for (uint32_t r = 1; r + 1 < rings; r++)
+				{
+					mesh.indices.insert(mesh.indices.end(), { ring(r, s), ring(r, s + 1), ring(r + 1, s + 1) });
+					mesh.indices.insert(mesh.indices.end(), { ring(r, s), ring(r + 1, s + 1), ring(r + 1, s) });
+				}
+				mesh.indices.insert(mesh.indices.end(), { ring(rings - 1, s), ring(rings - 1, s + 1), south });
+			}
+			return mesh;
+		}
+
+		// triangles rotated to start at their smallest index, winding kept, sorted
+		std::vector<std::array<uint32_t, 3>> sortedTriangles(const std::vector<uint32_t>& indices)
+		{
+			std::vector<std::array<uint32_t, 3>> triangles;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				std::array<uint32_t, 3> triangle{ indices[i], indices[i + 1], indices[i + 2] };
+				std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+				triangles.push_back(triangle);
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		struct Partition
+		{
+			std::vector<uint32_t> indices;
+			std::vector<LveModel::Meshlet> meshlets;
+			LveModel::Lod lod{};
+			float orientation = 0.f;
+		};
+
+		// build and computeBounds the way LveModel::Builder::buildMeshlets calls them, checks the limits and coverage
+		bool buildPartition(const char* name, const Mesh& mesh, Partition& result)
+		{
+			const float* positions = &mesh.positions[0].x;
+			result.indices = mesh.indices;
+			result.orientation = LveMeshlets::surfaceOrientation(
+				result.indices.data(), result.indices.size(), positions, sizeof(glm::vec3), mesh.positions.size());
+
+			double seconds = bestSeconds(1, [&]() {
+				result.meshlets = LveMeshlets::build(
+					result.indices.data(), result.indices.size(), positions, sizeof(glm::vec3), mesh.positions.size());
+			});
+			for (auto& meshlet : result.meshlets)
+			{
+				LveMeshlets::computeBounds(meshlet, result.indices.data(), positions, sizeof(glm::vec3),
+					result.orientation != 0.f ? result.orientation : 1.f);
+			}
+			result.lod = { 0, 1, 0.f, 0, static_cast<uint32_t>(result.meshlets.size()) };
+
+			bool withinLimits = true;
+			bool contiguous = true;
+			uint32_t maxVertices = 0;
+			uint32_t maxTriangles = 0;
+			uint32_t nextIndex = 0;
+			std::unordered_set<uint32_t> vertices;
+			for (const auto& meshlet : result.meshlets)
+			{
+				vertices.clear();
+				vertices.insert(result.indices.begin() + meshlet.firstIndex, result.indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+				maxVertices = std::max(maxVertices, static_cast<uint32_t>(vertices.size()));
+				maxTriangles = std::max(maxTriangles, meshlet.indexCount / 3);
+				withinLimits &= vertices.size() <= LveMeshlets::MAX_VERTICES && meshlet.indexCount / 3 <= LveMeshlets::MAX_TRIANGLES;
+				contiguous &= meshlet.firstIndex == nextIndex && meshlet.indexCount % 3 == 0 && meshlet.indexCount > 0;
+				nextIndex = meshlet.firstIndex + meshlet.indexCount;
+			}
+			contiguous &= nextIndex == result.indices.size();
+			bool covered = contiguous && sortedTriangles(result.indices) == sortedTriangles(mesh.indices);
+
+			std::printf("meshlets %s: %zu vertices, %zu triangles, orientation %+.0f, built in %.2f ms\n",
+				name, mesh.positions.size(), mesh.indices.size() / 3, result.orientation, seconds * 1000.0);
+			std::printf("  %zu meshlets, at most %u vertices and %u triangles  %s\n",
+				result.meshlets.size(), maxVertices, maxTriangles, withinLimits ? "ok" : "OVER LIMIT");
+			std::printf("  every triangle in exactly one meshlet  %s\n", covered ? "ok" : "MISMATCH");
+			return withinLimits && covered;
+		}
+
+		glm::vec3 triangleCorner(const Partition& partition, const Mesh& mesh, uint32_t index)
+		{
+			return mesh.positions[partition.indices[index]];
+		}
+
+		double cullTime(const Partition& partition, const LveMeshlets::CullContext& context, std::vector<uint32_t>& visible)
+		{
+			LveMeshlets::CullStats stats{};
+			return bestSeconds(20, [&]() {
+				LveMeshlets::cull(partition.meshlets, partition.lod, context, visible, stats);
+			});
+		}
+	}
+
+	int runMeshletBenchmark(const std::vector<std::string>& args)
+	{
+		uint32_t gridSize = args.empty() ? 256 : static_cast<uint32_t>(std::stoul(args[0]));
+		bool passed = true;
+
+		// grid: open, so only the sphere test. The camera stands in the middle of it looking along +x,
+		// the half behind it has to go
+		{
+			auto grid = makeGrid(gridSize);
+			Partition partition{};
+			passed &= buildPartition("grid", grid, partition);
+			if (partition.orientation != 0.f)
+			{
+				std::printf("  grid reported as closed  MISMATCH\n");
+				passed = false;
+			}
+
+			float half = static_cast<float>(gridSize - 1) * 0.5f;
+			glm::vec3 camera{ half, 2.f, half };
+			auto projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 1000.f);
+			auto view = glm::lookAt(camera, camera + glm::vec3{ 1.f, -0.2f, 0.f }, glm::vec3{ 0.f, -1.f, 0.f });
+			LveMeshlets::CullContext context{ LveFrustum::fromMatrix(projection * view), camera, false };
+
+			std::vector<uint32_t> visible;
+			auto seconds = cullTime(partition, context, visible);
+			std::vector<bool> isVisible(partition.meshlets.size(), false);
+			for (auto i : visible)
+			{
+				isVisible[i] = true;
+			}
+
+			// behind: the whole bounding sphere lies behind the camera, in front: a corner is inside the frustum
+			uint32_t behind = 0;
+			uint32_t wrong = 0;
+			for (uint32_t m = 0; m < partition.meshlets.size(); m++)
+			{
+				const auto& meshlet = partition.meshlets[m];
+				float maxX = -1e30f;
+				bool cornerInside = false;
+				for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+				{
+					auto p = triangleCorner(partition, grid, i);
+					maxX = std::max(maxX, p.x);
+					cornerInside |= std::all_of(context.frustum.planes.begin(), context.frustum.planes.end(),
+						[&](const glm::vec4& plane) { return glm::dot(glm::vec3(plane), p) + plane.w >= 0.f; });
+				}
+				bool isBehind = maxX + meshlet.radius < camera.x;
+				behind += isBehind ? 1 : 0;
+				wrong += (isBehind && isVisible[m]) || (cornerInside && !isVisible[m]) ? 1 : 0;
+			}
+			std::printf("  sphere test: %zu visible, %zu culled, %u behind the camera, %u wrong  %s | %.2f ns/meshlet\n",
+				visible.size(), partition.meshlets.size() - visible.size(), behind, wrong,
+				wrong == 0 && behind > 0 ? "ok" : "MISMATCH", seconds * 1e9 / static_cast<double>(partition.meshlets.size()));
+			passed &= wrong == 0 && behind > 0;
+		}
+
+		// sphere: closed and fully inside the frustum, so only the normal cone test culls
+		{
+			auto sphere = makeSphere(64, 128);
+			Partition partition{};
+			passed &= buildPartition("sphere", sphere, partition);
+			if (partition.orientation == 0.f)
+			{
+				std::printf("  sphere reported as open  MISMATCH\n");
+				passed = false;
+			}
+
+			glm::vec3 camera{ 0.f, 0.5f, -4.f };
+			auto projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 100.f);
+			auto view = glm::lookAt(camera, glm::vec3{ 0.f }, glm::vec3{ 0.f, -1.f, 0.f });
+			LveMeshlets::CullContext context{ LveFrustum::fromMatrix(projection * view), camera, true };
+
+			std::vector<uint32_t> visible;
+			auto seconds = cullTime(partition, context, visible);
+			std::vector<bool> isVisible(partition.meshlets.size(), false);
+			for (auto i : visible)
+			{
+				isVisible[i] = true;
+			}
+
+			// a culled meshlet must not hold a single triangle facing the camera
+			uint32_t wrong = 0;
+			for (uint32_t m = 0; m < partition.meshlets.size(); m++)
+			{
+				if (isVisible[m])
+					continue;
+
+				const auto& meshlet = partition.meshlets[m];
+				for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+				{
+					auto a = triangleCorner(partition, sphere, i);
+					auto normal = glm::cross(triangleCorner(partition, sphere, i + 1) - a, triangleCorner(partition, sphere, i + 2) - a);
+					if (glm::dot(normal * partition.orientation, camera - a) > 0.f)
+					{
+						wrong++;
+						break;
+					}
+				}
+			}
+			auto culled = partition.meshlets.size() - visible.size();
+			std::printf("  cone test: %zu visible, %zu back facing culled, %u wrong  %s | %.2f ns/meshlet\n",
+				visible.size(), culled, wrong, wrong == 0 && culled > 0 ? "ok" : "MISMATCH",
+				seconds * 1e9 / static_cast<double>(partition.meshlets.size()));
+			passed &= wrong == 0 && culled > 0;
+		}
+
+		return passed ? 0 : 1;
+	}
+}
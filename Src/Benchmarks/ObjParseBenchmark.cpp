@@ -0,0 +1,146 @@
+#include "Benchmarks.hpp"
+#include "BenchmarkUtils.hpp"
+
+#include "../lve_job_system.hpp"
+#include "../lve_obj_parser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve
+{
+	namespace
+	{
+		// grid of size x size vertices with positions, normals and uvs, rows alternate quads and triangle pairs
+		std::string writeSyntheticObj(uint32_t size)
+		{
+			auto path = (std::filesystem::temp_directory_path() / "lve_obj_parse_benchmark.obj").string();
+			std::ofstream out(path, std::ios::binary);
+			if (!out)
+			{
+				throw std::runtime_error("failed to create " + path);
+			}
+
+			char line[256];
+			auto write = [&](int length) { out.write(line, length); };
+			for (uint32_t y = 0; y < size; y++)
+			{
+				for (uint32_t x = 0; x < size; x++)
+				{
+					float u = static_cast<float>(x) / static_cast<float>(size - 1);
+					float v = static_cast<float>(y) / static_cast<float>(size - 1);
+					float height = 0.25f * std::sin(u * 17.0f) * std::cos(v * 13.0f);
+					write(std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", u * 10.0f - 5.0f, height, v * 10.0f - 5.0f));
+					write(std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", u, v));
+					write(std::snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", -height, 1.0f, height));
+				}
+			}
+
+			for (uint32_t y = 0; y + 1 < size; y++)
+			{
+				for (uint32_t x = 0; x + 1 < size; x++)
+				{
+					uint32_t a = y * size + x + 1;
+					uint32_t b = a + 1;
+					uint32_t c = a + size + 1;
+					uint32_t d = a + size;
+					if (y % 2 == 0)
+					{
+						write(std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d));
+					}
+					else
+					{
+						write(std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c));
+						write(std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, c, c, c, d, d, d));
+					}
+				}
+			}
+
+			return path;
+		}
+
+		std::vector<tinyobj::index_t> concatIndices(const std::vector<tinyobj::shape_t>& shapes)
+		{
+			std::vector<tinyobj::index_t> indices;
+			for (const auto& shape : shapes)
+			{
+				indices.insert(indices.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+			}
+			return indices;
+		}
+
+		template<typename T>
+		bool sameBytes(const std::vector<T>& a, const std::vector<T>& b)
+		{
+			return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+		}
+	}
+
+	int runObjParseBenchmark(const std::vector<std::string>& args)
+	{
+		constexpr uint32_t repeats = 3;
+
+		bool generated = args.empty();
+		std::string path = generated ? writeSyntheticObj(1024) : args[0];
+		double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+		std::cout << "obj_parse: " << path << " (" << megabytes << " MB)\n";
+
+		tinyobj::attrib_t referenceAttrib;
+		std::vector<tinyobj::shape_t> referenceShapes;
+		std::string warn, err;
+		auto referenceTime = bestSeconds(repeats, [&]() {
+			referenceShapes.clear();
+			if (!LveObjParser::loadReference(path, referenceAttrib, referenceShapes, warn, err))
+			{
+				throw std::runtime_error(warn + err);
+			}
+		});
+		auto referenceIndices = concatIndices(referenceShapes);
+		std::printf("  tinyobj        %8.1f ms %8.1f MB/s\n", referenceTime * 1000.0, megabytes / referenceTime);
+
+		int result = 0;
+		uint32_t maxThreads = LveJobSystem::shared().getWorkerCount();
+		for (uint32_t threads = 1; ; threads = std::min(threads * 2, maxThreads))
+		{
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			auto time = bestSeconds(repeats, [&]() {
+				shapes.clear();
+				if (!LveObjParser::load(path, attrib, shapes, warn, err, threads))
+				{
+					throw std::runtime_error(warn + err);
+				}
+			});
+
+			bool identical =
+				sameBytes(attrib.vertices, referenceAttrib.vertices) &&
+				sameBytes(attrib.colors, referenceAttrib.colors) &&
+				sameBytes(attrib.normals, referenceAttrib.normals) &&
+				sameBytes(attrib.texcoords, referenceAttrib.texcoords) &&
+				sameBytes(concatIndices(shapes), referenceIndices);
+			if (!identical)
+			{
+				result = 1;
+			}
+
+			std::printf("  %2u thread(s)   %8.1f ms %8.1f MB/s  x%.2f  %s\n",
+				threads, time * 1000.0, megabytes / time, referenceTime / time, identical ? "identical" : "MISMATCH");
+
+			if (threads == maxThreads)
+				break;
+		}
+
+		if (generated)
+		{
+			std::filesystem::remove(path);
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,148 @@
+#include "Benchmarks.hpp"
+#include "BenchmarkUtils.hpp"
+
+#include "../lve_ecs.hpp"
+#include "../lve_game_object.hpp"
+#include "../lve_job_system.hpp"
+#include "../Systems/transform_system.hpp"
+
+//libs
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace lve
+{
+	int runTransformBenchmark(const std::vector<std::string>& args)
+	{
+		constexpr uint32_t repeats = 20;
+
+		uint32_t count = args.empty() ? 100000 : static_cast<uint32_t>(std::stoul(args[0]));
+		float dirtyPercent = args.size() < 2 ? 1.f : std::stof(args[1]);
+
+		std::mt19937 random{ 42 };
+		std::uniform_real_distribution<float> position{ -50.f, 50.f };
+		std::uniform_real_distribution<float> angle{ -glm::pi<float>(), glm::pi<float>() };
+		std::uniform_real_distribution<float> size{ 0.1f, 4.f };
+		std::uniform_real_distribution<float> chance{ 0.f, 100.f };
+
+		LveRegistry registry;
+		std::vector<LveEntity> entities;
+		entities.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto entity = registry.create();
+			auto& transform = registry.add<TransformComponent>(entity);
+			transform.translation = { position(random), position(random), position(random) };
+			transform.rotation = { angle(random), angle(random), angle(random) };
+			transform.scale = { size(random), size(random), size(random) };
+			registry.add<WorldTransformComponent>(entity);
+			entities.push_back(entity);
+		}
+
+		// what renderGameObjects did for every object every frame
+		std::vector<WorldTransformComponent> reference(count);
+		auto& transforms = registry.pool<TransformComponent>().getComponents();
+		auto perObjectTime = bestSeconds(repeats, [&]() {
+			for (uint32_t i = 0; i < count; i++)
+			{
+				reference[i].world = transforms[i].mat4();
+				reference[i].normal = transforms[i].normalMatrix();
+			}
+		});
+
+		TransformSystem transformSystem{ LveJobSystem::shared() };
+		auto allDirtyTime = bestSeconds(repeats, [&]() {
+			for (auto& transform : transforms)
+			{
+				transform.dirty = true;
+			}
+			transformSystem.update(registry);
+		});
+
+		// entities were created in pool order, reference[i] belongs to entities[i]
+		float maxError = 0.f;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto& cached = registry.get<WorldTransformComponent>(entities[i]);
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					maxError = std::max(maxError, std::abs(cached.world[column][row] - reference[i].world[column][row]));
+				}
+			}
+			for (int column = 0; column < 3; column++)
+			{
+				for (int row = 0; row < 3; row++)
+				{
+					maxError = std::max(maxError, std::abs(cached.normal[column][row] - reference[i].normal[column][row]));
+				}
+			}
+		}
+
+		std::vector<uint32_t> moving;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (chance(random) < dirtyPercent)
+			{
+				moving.push_back(i);
+			}
+		}
+		auto partialTime = bestSeconds(repeats, [&]() {
+			for (auto i : moving)
+			{
+				transforms[i].dirty = true;
+			}
+			transformSystem.update(registry);
+		});
+
+		// translations reach 50 and normal matrices divide by scales down to 0.1, a few float ulps of those
+		bool accurate = maxError < 1e-3f;
+
+		// entities leaving the scene graph, by detaching and by remove, must get their own world matrix back
+		bool leavesGraph = true;
+		{
+			LveRegistry graphRegistry;
+			TransformSystem graphSystem{ LveJobSystem::shared() };
+			auto& graph = graphSystem.getSceneGraph();
+			auto makeEntity = [&](float x) {
+				auto entity = graphRegistry.create();
+				graphRegistry.add<TransformComponent>(entity).translation = { x, 0.f, 0.f };
+				graphRegistry.add<WorldTransformComponent>(entity);
+				return entity;
+			};
+			auto worldX = [&](LveEntity entity) { return graphRegistry.get<WorldTransformComponent>(entity).world[3].x; };
+
+			auto parent = makeEntity(10.f);
+			auto child = makeEntity(1.f);
+			graph.setParent(child, parent);
+			graphSystem.update(graphRegistry);
+			leavesGraph &= worldX(child) == 11.f;
+
+			graph.setParent(child, {});
+			graphSystem.update(graphRegistry);
+			leavesGraph &= worldX(child) == 1.f;
+
+			graph.setParent(child, parent);
+			graphSystem.update(graphRegistry);
+			graph.remove(parent);
+			graphSystem.update(graphRegistry);
+			leavesGraph &= worldX(child) == 1.f && worldX(parent) == 10.f;
+		}
+
+		auto perObject = [&](double seconds) { return seconds * 1e9 / static_cast<double>(count); };
+		std::printf("transforms: %u objects, %s batches of %u, max error %g\n", count, TransformSystem::SIMD_NAME, TransformSystem::BATCH_SIZE, maxError);
+		std::printf("  per object mat4 + normalMatrix %8.3f ms %6.2f ns/object\n", perObjectTime * 1000.0, perObject(perObjectTime));
+		std::printf("  batched, all dirty             %8.3f ms %6.2f ns/object  x%.2f  %s\n",
+			allDirtyTime * 1000.0, perObject(allDirtyTime), perObjectTime / allDirtyTime, accurate ? "accurate" : "MISMATCH");
+		std::printf("  batched, %5.1f%% dirty (%u)    %8.3f ms %6.2f ns/object  x%.2f\n",
+			dirtyPercent, static_cast<uint32_t>(moving.size()), partialTime * 1000.0, perObject(partialTime), perObjectTime / partialTime);
+		std::printf("  scene graph detach and remove  %s\n", leavesGraph ? "ok" : "STALE WORLD MATRIX");
+
+		return accurate && leavesGraph ? 0 : 1;
+	}
+}
@@ -0,0 +1,113 @@
+#include "Benchmarks.hpp"
+#include "BenchmarkUtils.hpp"
+
+#include "../lve_model.hpp"
+#include "../lve_utils.hpp"
+#include "../Helpers/VertexDeduplicator.hpp"
+
+//libs
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace lve
+{
+	namespace
+	{
+		// hash LveModel::Builder used with std::unordered_map before
+		struct NodeMapVertexHash
+		{
+			size_t operator()(const LveModel::Vertex& vertex) const
+			{
+				size_t seed = 0;
+				hash_combine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+				return seed;
+			}
+		};
+
+		// index expanded grid of size x size vertices like loadModel sees it: every vertex shows up ~6 times
+		std::vector<LveModel::Vertex> makeVertexStream(uint32_t size)
+		{
+			auto gridVertex = [size](uint32_t x, uint32_t y) {
+				LveModel::Vertex vertex{};
+				vertex.uv = { static_cast<float>(x) / size, static_cast<float>(y) / size };
+				vertex.position = { vertex.uv.x * 10.0f, 0.0f, vertex.uv.y * 10.0f };
+				vertex.normal = { 0.0f, 1.0f, 0.0f };
+				vertex.color = { 1.0f, 1.0f, 1.0f };
+				return vertex;
+			};
+
+			std::vector<LveModel::Vertex> stream;
+			stream.reserve(static_cast<size_t>(size) * size * 6);
+			for (uint32_t y = 0; y + 1 < size; y++)
+			{
+				for (uint32_t x = 0; x + 1 < size; x++)
+				{
+					stream.push_back(gridVertex(x, y));
+					stream.push_back(gridVertex(x + 1, y));
+					stream.push_back(gridVertex(x + 1, y + 1));
+					stream.push_back(gridVertex(x, y));
+					stream.push_back(gridVertex(x + 1, y + 1));
+					stream.push_back(gridVertex(x, y + 1));
+				}
+			}
+			return stream;
+		}
+	}
+
+	int runVertexDedupBenchmark(const std::vector<std::string>& args)
+	{
+		constexpr uint32_t repeats = 5;
+
+		uint32_t size = args.empty() ? 1024 : static_cast<uint32_t>(std::stoul(args[0]));
+		auto stream = makeVertexStream(size);
+		std::printf("vertex_dedup: %zu indices\n", stream.size());
+
+		std::vector<LveModel::Vertex> nodeVertices;
+		std::vector<uint32_t> nodeIndices;
+		auto nodeTime = bestSeconds(repeats, [&]() {
+			nodeVertices.clear();
+			nodeIndices.clear();
+			std::unordered_map<LveModel::Vertex, uint32_t, NodeMapVertexHash> uniqueVertices{};
+			for (const auto& vertex : stream)
+			{
+				if (uniqueVertices.count(vertex) == 0)
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(nodeVertices.size());
+					nodeVertices.push_back(vertex);
+				}
+				nodeIndices.push_back(uniqueVertices[vertex]);
+			}
+		});
+
+		std::vector<LveModel::Vertex> flatVertices;
+		std::vector<uint32_t> flatIndices;
+		auto flatTime = bestSeconds(repeats, [&]() {
+			flatVertices.clear();
+			flatIndices.clear();
+			flatIndices.reserve(stream.size());
+			VertexDeduplicator<LveModel::Vertex> uniqueVertices{ stream.size() };
+			for (const auto& vertex : stream)
+			{
+				flatIndices.push_back(uniqueVertices.insert(vertex, flatVertices));
+			}
+		});
+
+		bool identical =
+			nodeIndices == flatIndices &&
+			nodeVertices.size() == flatVertices.size() &&
+			std::memcmp(nodeVertices.data(), flatVertices.data(), nodeVertices.size() * sizeof(LveModel::Vertex)) == 0;
+
+		auto perIndex = [&](double seconds) { return seconds * 1e9 / static_cast<double>(stream.size()); };
+		std::printf("  unordered_map   %8.1f ms %6.1f ns/index\n", nodeTime * 1000.0, perIndex(nodeTime));
+		std::printf("  open addressing %8.1f ms %6.1f ns/index  x%.2f  %s\n",
+			flatTime * 1000.0, perIndex(flatTime), nodeTime / flatTime, identical ? "identical" : "MISMATCH");
+		std::printf("  unique vertices %zu\n", flatVertices.size());
+
+		return identical ? 0 : 1;
+	}
+}
@@ -0,0 +1,68 @@
+#include "Benchmarks.hpp"
+
+#include "../lve_model.hpp"
+#include "../lve_vertex_quantizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../../../" 
+#endif // !ENGINE_DIR
+
+namespace lve
+{
+	namespace
+	{
+		void reportFormats(const std::string& path)
+		{
+			LveModel::Builder builder{};
+			builder.loadModel(path);
+
+			auto extent = builder.boundsMax - builder.boundsMin;
+			std::printf("%s: %zu vertices, bounds %.3f x %.3f x %.3f\n", path.c_str(), builder.vertices.size(), extent.x, extent.y, extent.z);
+
+			const char* names[LveModel::VERTEX_FORMAT_COUNT] = { "full", "compact", "compact16" };
+			for (uint32_t format = 0; format < LveModel::VERTEX_FORMAT_COUNT; format++)
+			{
+				auto vertexFormat = static_cast<LveModel::VertexFormat>(format);
+				auto stride = LveVertexQuantizer::vertexStride(vertexFormat);
+
+				auto start = std::chrono::high_resolution_clock::now();
+				auto encoded = LveVertexQuantizer::encode(vertexFormat, builder.vertices.data(), builder.vertices.size(), builder.boundsMin, builder.boundsMax);
+				auto end = std::chrono::high_resolution_clock::now();
+
+				auto error = LveVertexQuantizer::measureError(vertexFormat, builder.vertices.data(), builder.vertices.size(), builder.boundsMin, builder.boundsMax);
+				std::printf("  %-9s %2u B/vertex %9zu B | max error: position %.2e (%.4f%% of extent) normal %.3f deg color %.4f uv %.2e | encode %.2f ms\n",
+					names[format],
+					stride,
+					encoded.size(),
+					error.position,
+					100.0 * error.position / std::max({ extent.x, extent.y, extent.z, 1e-30f }),
+					error.normalDegrees,
+					error.color,
+					error.uv,
+					std::chrono::duration<double, std::milli>(end - start).count());
+			}
+		}
+	}
+
+	int runVertexFormatBenchmark(const std::vector<std::string>& args)
+	{
+		if (!args.empty())
+		{
+			for (const auto& path : args)
+			{
+				reportFormats(path);
+			}
+			return 0;
+		}
+
+		for (const char* model : { "Models/flat_vase.obj", "Models/smooth_vase.obj", "Models/quad.obj", "Models/colored_cube.obj" })
+		{
+			reportFormats(ENGINE_DIR + std::string(model));
+		}
+		return 0;
+	}
+}
@@ -0,0 +1,144 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lve
+{
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(data_, other.data_);
+			std::swap(size_, other.size_);
+#ifdef _WIN32
+			std::swap(file, other.file);
+			std::swap(mapping, other.mapping);
+#endif
+		}
+
+		return *this;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			file = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data_ == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		size_ = static_cast<size_t>(fileSize.QuadPart);
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data_ != nullptr)
+		{
+			UnmapViewOfFile(data_);
+		}
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+		if (file != nullptr)
+		{
+			CloseHandle(file);
+		}
+
+		data_ = nullptr;
+		size_ = 0;
+		mapping = nullptr;
+		file = nullptr;
+	}
+#else
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		// the mapping keeps its own reference to the file
+		::close(fd);
+		if (mapped == MAP_FAILED)
+		{
+			return false;
+		}
+
+		data_ = static_cast<const char*>(mapped);
+		size_ = static_cast<size_t>(fileStat.st_size);
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data_ != nullptr)
+		{
+			munmap(const_cast<char*>(data_), size_);
+		}
+
+		data_ = nullptr;
+		size_ = 0;
+	}
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace lve
+{
+	// Read-only memory mapping of a whole file
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		/// <returns>false if the file does not exist, is empty or can`t be mapped</returns>
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return data_ != nullptr; }
+		const char* data() const { return data_; }
+		size_t size() const { return size_; }
+
+	private:
+		const char* data_ = nullptr;
+		size_t size_ = 0;
+
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace lve
+{
+	// LSD radix sort of 64 or 32 bit keys carrying a 32 bit value, one byte per pass.
+	// The sort is stable. Passes where every key has the same byte are skipped, so keys that
+	// only use their low bits (or are mostly equal) cost fewer passes.
+	// Callers keep the scratch vector between sorts, once it reached the peak size nothing is allocated.
+	namespace RadixSort
+	{
+		struct Entry
+		{
+			uint64_t key;
+			uint32_t value;
+		};
+
+		// half the size of Entry and at most 4 passes, for keys that fit 32 bits (e.g. FloatKey)
+		struct Entry32
+		{
+			uint32_t key;
+			uint32_t value;
+		};
+
+		/// <summary>
+		/// Sort entries by key, ascending. Equal keys keep their order
+		/// </summary>
+		/// <param name="scratch">any content, resized to entries.size(). Swapped with entries when the passes end in it</param>
+		template<typename TEntry>
+		inline void Sort(std::vector<TEntry>& entries, std::vector<TEntry>& scratch)
+		{
+			constexpr uint32_t PASSES = sizeof(TEntry::key);
+			auto count = entries.size();
+			if (count < 2)
+				return;
+
+			scratch.resize(count);
+
+			std::array<std::array<uint32_t, 256>, PASSES> histograms{};
+			for (const auto& entry : entries)
+			{
+				for (uint32_t pass = 0; pass < PASSES; pass++)
+				{
+					histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+				}
+			}
+
+			TEntry* source = entries.data();
+			TEntry* destination = scratch.data();
+			for (uint32_t pass = 0; pass < PASSES; pass++)
+			{
+				auto& histogram = histograms[pass];
+				auto shift = pass * 8;
+				if (histogram[(source[0].key >> shift) & 0xFF] == count)
+					continue;
+
+				uint32_t offset = 0;
+				for (auto& bucket : histogram)
+				{
+					auto bucketCount = bucket;
+					bucket = offset;
+					offset += bucketCount;
+				}
+
+				for (size_t i = 0; i < count; i++)
+				{
+					destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+				}
+				std::swap(source, destination);
+			}
+
+			if (source != entries.data())
+			{
+				entries.swap(scratch);
+			}
+		}
+
+		/// <summary>
+		/// Map a float to a key with the same order: ascending keys sort floats ascending, -0 before +0.
+		/// Invert the result (~key) for a descending order
+		/// </summary>
+		inline uint32_t FloatKey(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			// negative: flip all bits so larger magnitudes come first, positive: set the sign bit to sort above negatives
+			return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+		}
+	}
+}
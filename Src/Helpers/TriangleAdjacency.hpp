@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace lve
+{
+	// triangles around every vertex, compressed: triangles[offsets[v]..offsets[v + 1])
+	struct TriangleAdjacency
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		TriangleAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+		{
+			offsets.assign(vertexCount + 1, 0);
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				offsets[indices[i] + 1]++;
+			}
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			triangles.resize(indexCount);
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+	};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../lve_utils.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace lve
+{
+	// Flat open addressing table (linear probing) that maps vertices to their index in a vertex array.
+	// Vertices are compared and hashed bytewise, so V must be tightly packed: no padding bytes.
+	// Slots keep 32 bits of the hash next to the index, most probes never touch the vertex array.
+	template<typename V>
+	class VertexDeduplicator
+	{
+		static_assert(std::is_trivially_copyable_v<V>, "vertices are compared bytewise");
+
+	public:
+		/// <param name="expectedVertices">upper bound of unique vertices, the table only grows past it</param>
+		explicit VertexDeduplicator(size_t expectedVertices)
+		{
+			size_t capacity = 16;
+			while (capacity < expectedVertices * 2)
+			{
+				capacity *= 2;
+			}
+			slots.assign(capacity, Slot{});
+		}
+
+		/// <summary>
+		/// Index of vertex in vertices, vertex is appended when seen for the first time
+		/// </summary>
+		uint32_t insert(const V& vertex, std::vector<V>& vertices)
+		{
+			if ((count + 1) * 2 > slots.size())
+			{
+				grow(vertices);
+			}
+
+			auto hash = hashBytes(&vertex, sizeof(V));
+			auto tag = static_cast<uint32_t>(hash >> 32);
+			auto mask = slots.size() - 1;
+			for (size_t i = static_cast<size_t>(hash) & mask; ; i = (i + 1) & mask)
+			{
+				auto& slot = slots[i];
+				if (slot.index == EMPTY)
+				{
+					slot.tag = tag;
+					slot.index = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(vertex);
+					count++;
+					return slot.index;
+				}
+
+				if (slot.tag == tag && std::memcmp(&vertices[slot.index], &vertex, sizeof(V)) == 0)
+				{
+					return slot.index;
+				}
+			}
+		}
+
+	private:
+		static constexpr uint32_t EMPTY = UINT32_MAX;
+
+		struct Slot
+		{
+			uint32_t tag = 0;
+			uint32_t index = EMPTY;
+		};
+
+		// only reached when expectedVertices was too small, hashes are recomputed from the vertices
+		void grow(const std::vector<V>& vertices)
+		{
+			std::vector<Slot> old(slots.size() * 2, Slot{});
+			old.swap(slots);
+
+			auto mask = slots.size() - 1;
+			for (const auto& slot : old)
+			{
+				if (slot.index == EMPTY)
+					continue;
+
+				auto i = static_cast<size_t>(hashBytes(&vertices[slot.index], sizeof(V))) & mask;
+				while (slots[i].index != EMPTY)
+				{
+					i = (i + 1) & mask;
+				}
+				slots[i] = slot;
+			}
+		}
+
+		std::vector<Slot> slots;
+		size_t count = 0;
+	};
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "point_light_system.hpp"
+#include "lve_light_clusters.hpp"
 
 //libs
 #define GLM_FORCE_RADIANSE
@@ -8,19 +9,11 @@
 #include <glm/gtc/constants.hpp>
 
 #include <stdexcept>
-#include <map>
 #include <array>
 #include <Helpers/VulkanHelpers.hpp>
 
 namespace lve {
 
-	struct  PointLightPushConstant
-	{
-		glm::vec4 position{};
-		glm::vec4 color{};
-		float radius;
-	};
-
 	PointLightSystem::PointLightSystem(
 		LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) 
 		: lveDevice{ device } 
@@ -36,19 +29,14 @@ namespace lve {
 
 	void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) 
 	{
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(PointLightPushConstant);
-
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		auto vkResult = vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
 		if (vkResult != VK_SUCCESS)
@@ -64,8 +52,12 @@ namespace lve {
 		LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
 		LvePipeline::enableAlphaBlending(pipelineConfig);
 
-		pipelineConfig.attributeDescriptions.clear();
-		pipelineConfig.bindingDescriptions.clear();
+		// one billboard per instance, the quad corners come from gl_VertexIndex
+		pipelineConfig.bindingDescriptions = { { 0, sizeof(PointLightInstance), VK_VERTEX_INPUT_RATE_INSTANCE } };
+		pipelineConfig.attributeDescriptions = {
+			{ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(PointLightInstance, position)) },
+			{ 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(PointLightInstance, color)) }
+		};
 
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
@@ -78,42 +70,77 @@ namespace lve {
 			);
 	}
 
-	void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
+	void PointLightSystem::update(FrameInfo& frameInfo) {
 		auto rotateLight = glm::rotate(glm::mat4(1.f), frameInfo.frameTime, { 0.f, -1.f, 0.f });
-		int lightIndex = 0;
-		for (auto& kv: frameInfo.gameObjects)
-		{
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
-
-			assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specifed");
+		frameInfo.registry.each<TransformComponent, PointLightComponent>(
+			[&](LveEntity, TransformComponent& transform, PointLightComponent&) {
+				//update light position, relative to the parent for lights in the scene graph
+				transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
+				transform.dirty = true;
+			});
+	}
 
-			//update light position
-			obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
+	void PointLightSystem::gatherLights(FrameInfo& frameInfo, std::vector<PointLight>& lights) {
+		lights.clear();
+		frameInfo.registry.each<WorldTransformComponent, PointLightComponent>(
+			[&](LveEntity, WorldTransformComponent& world, PointLightComponent& pointLight) {
+				auto& light = lights.emplace_back();
+				light.position = glm::vec4(glm::vec3(world.world[3]), LveLightClusters::lightRange(pointLight.color, pointLight.lightIntensity));
+				light.color = glm::vec4(pointLight.color, pointLight.lightIntensity);
+			});
+	}
 
-			//copy light to ubo
-			ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-			ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-			
-			lightIndex += 1;
+	void PointLightSystem::uploadInstances(int frameIndex) {
+		auto& buffer = instanceBuffers[frameIndex];
+		if (buffer == nullptr || buffer->getInstanceCount() < instances.size())
+		{
+			// the previous use of this frame index has finished, replacing the buffer is safe
+			uint32_t capacity = 64;
+			while (capacity < instances.size())
+			{
+				capacity *= 2;
+			}
+
+			buffer = std::make_unique<LveBuffer>(
+				lveDevice,
+				sizeof(PointLightInstance),
+				capacity,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+			buffer->map();
 		}
 
-		ubo.numLights = lightIndex;
+		VkDeviceSize size = instances.size() * sizeof(PointLightInstance);
+		buffer->writeToBuffer(instances.data(), size);
+		buffer->flush();
 	}
 
 	void PointLightSystem::render(FrameInfo& frameInfo) {
-		//sort lights
-		std::map<float, LveGameObject::id_t> sorted;
-		for (auto& kv : frameInfo.gameObjects)
+		//sort lights, blended billboards are drawn back to front
+		lightInstances.clear();
+		depthSorter.clear();
+		frameInfo.registry.each<WorldTransformComponent, PointLightComponent>(
+			[&](LveEntity, WorldTransformComponent& world, PointLightComponent& pointLight) {
+				glm::vec3 position{ world.world[3] };
+				// the x scale with the scale of the parents applied
+				float radius = glm::length(glm::vec3(world.world[0]));
+				auto& light = lightInstances.emplace_back();
+				light.position = glm::vec4(position, radius);
+				light.color = glm::vec4(pointLight.color, pointLight.lightIntensity);
+				depthSorter.push(position);
+			});
+		depthSorter.sortBackToFront(frameInfo.camera.getView());
+
+		instances.clear();
+		for (auto index : depthSorter.getOrder())
 		{
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
-
-			//calculate distance
-			auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
-			float disSquared = glm::dot(offset, offset);
-			sorted[disSquared] = obj.getId();
+			instances.push_back(lightInstances[index]);
 		}
+		if (instances.empty())
+			return;
+
+		uploadInstances(frameInfo.frameIndex);
 
 		lvePipeline->bind(frameInfo.commandBuffer);
 
@@ -128,27 +155,10 @@ namespace lve {
 			nullptr
 		);
 
-		//iterat through sorted light in reverse order
-		for (auto it = sorted.rbegin(); it != sorted.rend(); it++)
-		{
-			//use game obj id to find light object
-			auto& obj = frameInfo.gameObjects.at(it->second);
-
-			PointLightPushConstant push{};
-			push.position = glm::vec4(obj.transform.translation, 1.f);
-			push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-			push.radius = obj.transform.scale.x;
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PointLightPushConstant),
-				&push
-				);
+		VkBuffer buffers[] = { instanceBuffers[frameInfo.frameIndex]->getBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, buffers, offsets);
 
-			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-		}
+		vkCmdDraw(frameInfo.commandBuffer, 6, static_cast<uint32_t>(instances.size()), 0, 0);
 	}
 }
\ No newline at end of file
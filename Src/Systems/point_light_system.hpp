@@ -1,16 +1,27 @@
 #pragma once
 
+#include "lve_buffer.hpp"
 #include "lve_camera.hpp"
+#include "lve_depth_sorter.hpp"
 #include "lve_device.hpp"
 #include "lve_game_object.hpp"
 #include "lve_pipeline.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_swap_chain.hpp"
 
+#include <array>
 #include <memory>
 #include <vector>
 
 namespace lve {
 
+	// per instance input of point_light.vert
+	struct PointLightInstance
+	{
+		glm::vec4 position{};// w is the billboard radius
+		glm::vec4 color{};// w is intensity
+	};
+
 	class PointLightSystem {
 
 	public:
@@ -21,15 +32,33 @@ namespace lve {
 		PointLightSystem(const PointLightSystem&) = delete;
 		void operator=(const PointLightSystem&) = delete;
 
-		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+		/// <summary>
+		/// Animate the local transforms of the lights, before TransformSystem::update
+		/// </summary>
+		void update(FrameInfo& frameInfo);
+		/// <summary>
+		/// Gather the lights for the light clusters, after TransformSystem::update
+		/// </summary>
+		/// <param name="lights">cleared and filled with the lights in world space</param>
+		void gatherLights(FrameInfo& frameInfo, std::vector<PointLight>& lights);
 		void render(FrameInfo& frameInfo);
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
+		/// <summary>
+		/// Write instances into the instance buffer of the frame, growing it when needed
+		/// </summary>
+		void uploadInstances(int frameIndex);
 
 		LveDevice& lveDevice;
 
 		std::unique_ptr<LvePipeline> lvePipeline;
 		VkPipelineLayout pipelineLayout;
+
+		std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+		LveDepthSorter depthSorter;
+		// per frame scratch: lights in object order, then sorted back to front
+		std::vector<PointLightInstance> lightInstances;
+		std::vector<PointLightInstance> instances;
 	};
 }
\ No newline at end of file
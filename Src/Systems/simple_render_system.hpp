@@ -7,12 +7,29 @@
 #include "lve_frame_info.hpp"
 #include "lve_texture_storage.hpp"
 #include "lve_descriptors.hpp"
+#include "lve_meshlets.hpp"
+#include "lve_buffer.hpp"
+#include "lve_swap_chain.hpp"
+#include "lve_render_queue.hpp"
+#include "lve_gpu_culling.hpp"
+#include "lve_parallel_recorder.hpp"
+#include "Helpers/RadixSort.hpp"
 
+#include <array>
 #include <memory>
 #include <vector>
 
 namespace lve {
 
+	// per instance vertex attributes of the instanced pipelines, locations 4..10
+	struct InstanceData
+	{
+		// position decode of the model included
+		glm::mat4 modelMatrix;
+		// mat3 columns padded to vec4
+		glm::vec4 normalMatrix[3];
+	};
+
 	class SimpleRenderSystem {
 
 	public:
@@ -28,15 +45,125 @@ namespace lve {
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		void operator=(const SimpleRenderSystem&) = delete;
 
-		void renderGameObjects(FrameInfo& frameInfo);
+		struct ObjectCullStats
+		{
+			uint32_t visible = 0;
+			uint32_t culled = 0;
+			// visible objects drawn as part of an instanced group
+			uint32_t instanced = 0;
+		};
+
+		/// <summary>
+		/// Work recorded before the render pass: the culling dispatch when GPU driven
+		/// </summary>
+		void prepareFrame(FrameInfo& frameInfo);
+		/// <summary>
+		/// Cull, sort and record the draws of all objects
+		/// </summary>
+		/// <param name="recorder">null - record into frameInfo.commandBuffer. Otherwise the sorted draws are split
+		/// into chunks, each recorded into a secondary command buffer on a job system worker</param>
+		void renderGameObjects(FrameInfo& frameInfo, LveParallelRecorder* recorder = nullptr);
+
+		/// <summary>
+		/// Cull and select lods in a compute pass and draw with vkCmdDrawIndexedIndirectCount, see LveGpuCulling.
+		/// Ignored when the device lacks drawIndirectCount
+		/// </summary>
+		void setGpuDriven(bool enable);
+		bool isGpuDriven() const { return gpuCulling != nullptr && gpuDriven; }
+
+		// objects and meshlets of the last renderGameObjects call
+		const ObjectCullStats& getObjectStats() const { return objectStats; }
+		const LveMeshlets::CullStats& getMeshletStats() const { return meshletStats; }
+		// packets and binds issued or avoided in the last renderGameObjects call
+		const LveRenderQueue::Stats& getQueueStats() const { return renderQueue.getStats(); }
 	private:
+		// projected error of the drawn lod, in pixels
+		static constexpr float LOD_PIXEL_ERROR = 1.f;
+		// relative band around LOD_PIXEL_ERROR where the current lod is kept, stops flicker at the switch distance
+		static constexpr float LOD_HYSTERESIS = 0.25f;
+		// fewer packets than this are not worth a secondary command buffer of their own
+		static constexpr uint32_t MIN_PACKETS_PER_CHUNK = 256;
+
+		/// <summary>
+		/// Coarsest lod whose error projects to at most LOD_PIXEL_ERROR pixels, with hysteresis around current
+		/// </summary>
+		static uint32_t selectLod(const LveModel& model, const glm::mat4& modelMatrix, const FrameInfo& frameInfo, uint32_t current);
+
+		// objects sharing model and lod, drawn with one instanced draw when there is more than one.
+		// The texture belongs to the model, so a group also shares its texture
+		struct DrawGroup
+		{
+			uint32_t firstItem;
+			uint32_t itemCount;
+			uint32_t firstInstance;
+			VkDescriptorSet descriptorSet;
+		};
+
+		// what a thread recording packets writes to, one per recorder chunk
+		struct RecordState
+		{
+			LveBindCache binds;
+			LveMeshlets::CullStats meshletStats;
+			std::vector<uint32_t> visibleMeshlets;
+		};
+
+		/// <summary>
+		/// Cull the objects and sort one packet per DrawGroup into the render queue, upload the instances
+		/// </summary>
+		void buildPackets(FrameInfo& frameInfo);
+		/// <summary>
+		/// Record packets [begin, end) of the queue into commandBuffer. Only reads the system, safe to call concurrently
+		/// </summary>
+		void recordPackets(RecordState& state, const FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end);
+		/// <summary>
+		/// One packet per mesh draw of the culling pass
+		/// </summary>
+		void buildGpuDrivenPackets();
+		/// <summary>
+		/// One indirect count draw per packet of [begin, end), safe to call concurrently
+		/// </summary>
+		void recordGpuDrivenPackets(RecordState& state, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end);
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
+		void createPipelines(VkRenderPass renderPass);
+		/// <summary>
+		/// Copy instance data into the instance buffer of frameIndex, growing it when it is too small
+		/// </summary>
+		void uploadInstances(int frameIndex);
 
 		LveDevice& lveDevice;
 		LveTextureStorage& lveTextureStorage;
 
-		std::unique_ptr<LvePipeline> lvePipeline;
+		// one per LveModel::VertexFormat
+		std::array<std::unique_ptr<LvePipeline>, LveModel::VERTEX_FORMAT_COUNT> lvePipelines;
+		// same with per instance matrices from the instance buffer instead of push constants
+		std::array<std::unique_ptr<LvePipeline>, LveModel::VERTEX_FORMAT_COUNT> instancedPipelines;
 		VkPipelineLayout pipelineLayout;
+
+		// written every frame, one per frame in flight so the CPU never overwrites data the GPU still reads
+		std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+
+		// one packet per DrawGroup, or per mesh when GPU driven
+		LveRenderQueue renderQueue;
+
+		std::unique_ptr<LveGpuCulling> gpuCulling;
+		bool gpuDriven = false;
+
+		ObjectCullStats objectStats{};
+		LveMeshlets::CullStats meshletStats{};
+
+		// per frame scratch, kept to reuse the allocations
+		// components of the objects with a model, stable until the registry adds or removes one
+		std::vector<ModelComponent*> candidateModels;
+		std::vector<WorldTransformComponent*> candidateWorlds;
+		LveAabbBatch worldBounds;
+		std::vector<uint8_t> objectVisibility;
+		std::vector<RecordState> recordStates;
+		// visible objects, key of mesh, lod and depth, value indexes the candidates
+		std::vector<RadixSort::Entry> drawItems;
+		std::vector<RadixSort::Entry> drawItemScratch;
+		std::vector<DrawGroup> drawGroups;
+		std::vector<InstanceData> instances;
+		// texture of every LveGpuCulling mesh draw
+		std::vector<VkDescriptorSet> meshDrawDescriptorSets;
 	};
 }
\ No newline at end of file
@@ -9,11 +9,14 @@
 #include <glm/gtc/constants.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <Helpers/VulkanHelpers.hpp>
 
 namespace lve {
 
+	static_assert(sizeof(InstanceData) == LveGpuCulling::INSTANCE_SIZE, "the culling pass writes InstanceData");
+
 	struct SimplePushConstantData {
 		glm::mat4 modelMatrix{ 1.f };
 		glm::mat4 normalMatrix{ 1.f };
@@ -27,7 +30,7 @@ namespace lve {
 	) : lveDevice{ device }, lveTextureStorage{ lveTextureStorage }
 	{
 		createPipelineLayout(globalSetLayout.getDescriptorSetLayout());
-		createPipeline(renderPass);
+		createPipelines(renderPass);
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem() {
@@ -60,68 +63,413 @@ namespace lve {
 		}
 	}
 
-	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+	void SimpleRenderSystem::createPipelines(VkRenderPass renderPass) {
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+		// vertex shader variant decoding each LveModel::VertexFormat
+		const std::array<const char*, LveModel::VERTEX_FORMAT_COUNT> vertexShaders{
+			"shaders/simple_shader.vert.spv",
+			"shaders/simple_shader_compact.vert.spv",
+			"shaders/simple_shader_compact16.vert.spv"
+		};
+		const std::array<const char*, LveModel::VERTEX_FORMAT_COUNT> instancedVertexShaders{
+			"shaders/simple_shader_instanced.vert.spv",
+			"shaders/simple_shader_compact_instanced.vert.spv",
+			"shaders/simple_shader_compact16_instanced.vert.spv"
+		};
 
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
+		for (uint32_t format = 0; format < LveModel::VERTEX_FORMAT_COUNT; format++)
+		{
+			PipelineConfigInfo pipelineConfig{};
+			LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+			pipelineConfig.bindingDescriptions = LveModel::Vertex::getBindingDescriptions(static_cast<LveModel::VertexFormat>(format));
+			pipelineConfig.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions(static_cast<LveModel::VertexFormat>(format));
 
-		lvePipeline = std::make_unique<LvePipeline>(
-			lveDevice,
-			"shaders/simple_shader.vert.spv",
-			"shaders/simple_shader.frag.spv",
-			pipelineConfig
-			);
+			pipelineConfig.renderPass = renderPass;
+			pipelineConfig.pipelineLayout = pipelineLayout;
+
+			lvePipelines[format] = std::make_unique<LvePipeline>(
+				lveDevice,
+				vertexShaders[format],
+				"shaders/simple_shader.frag.spv",
+				pipelineConfig
+				);
+
+			// instance buffer at binding 1, a mat4 and a mat3 take one location per column
+			pipelineConfig.bindingDescriptions.push_back({ 1, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE });
+			for (uint32_t column = 0; column < 4; column++)
+			{
+				pipelineConfig.attributeDescriptions.push_back({
+					4 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT,
+					static_cast<uint32_t>(offsetof(InstanceData, modelMatrix) + column * sizeof(glm::vec4))
+				});
+			}
+			for (uint32_t column = 0; column < 3; column++)
+			{
+				pipelineConfig.attributeDescriptions.push_back({
+					8 + column, 1, VK_FORMAT_R32G32B32_SFLOAT,
+					static_cast<uint32_t>(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec4))
+				});
+			}
+
+			instancedPipelines[format] = std::make_unique<LvePipeline>(
+				lveDevice,
+				instancedVertexShaders[format],
+				"shaders/simple_shader.frag.spv",
+				pipelineConfig
+				);
+		}
+	}
+
+	void SimpleRenderSystem::uploadInstances(int frameIndex) {
+		if (instances.empty())
+			return;
+
+		auto& buffer = instanceBuffers[frameIndex];
+		if (buffer == nullptr || buffer->getInstanceCount() < instances.size())
+		{
+			// the previous use of this frame index has finished, replacing the buffer is safe
+			uint32_t capacity = 64;
+			while (capacity < instances.size())
+			{
+				capacity *= 2;
+			}
+
+			buffer = std::make_unique<LveBuffer>(
+				lveDevice,
+				sizeof(InstanceData),
+				capacity,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+			buffer->map();
+		}
+
+		VkDeviceSize size = instances.size() * sizeof(InstanceData);
+		buffer->writeToBuffer(instances.data(), size);
+		buffer->flush();
+	}
+
+	void SimpleRenderSystem::setGpuDriven(bool enable) {
+		gpuDriven = enable && lveDevice.supportsIndirectCount();
+		if (gpuDriven && gpuCulling == nullptr)
+		{
+			gpuCulling = std::make_unique<LveGpuCulling>(lveDevice, LOD_PIXEL_ERROR, LOD_HYSTERESIS);
+		}
 	}
 
-	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
-		lvePipeline->bind(frameInfo.commandBuffer);
-
-		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0,
-			1,
-			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
-		);
-
-		for (auto& kv : frameInfo.gameObjects) 
-		{
-			auto& obj = kv.second;
-			if (obj.model == nullptr) continue;
-
-			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+	void SimpleRenderSystem::prepareFrame(FrameInfo& frameInfo) {
+		if (isGpuDriven())
+		{
+			gpuCulling->cull(frameInfo);
+		}
+	}
+
+	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo, LveParallelRecorder* recorder) {
+		meshletStats = {};
+		if (isGpuDriven())
+		{
+			buildGpuDrivenPackets();
+		}
+		else
+		{
+			buildPackets(frameInfo);
+		}
+
+		// packets are recorded in sorted order, split into contiguous ranges when recording in parallel
+		auto recordRange = [&](RecordState& state, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+			state.binds.begin(commandBuffer);
+			state.binds.bindDescriptorSet(pipelineLayout, 0, frameInfo.globalDescriptorSet);
+			if (isGpuDriven())
+			{
+				recordGpuDrivenPackets(state, commandBuffer, begin, end);
+			}
+			else
+			{
+				recordPackets(state, frameInfo, commandBuffer, begin, end);
+			}
+		};
+
+		auto packetCount = static_cast<uint32_t>(renderQueue.getPackets().size());
+		recordStates.resize(recorder != nullptr ? recorder->getMaxChunks() : 1);
+		for (auto& state : recordStates)
+		{
+			state.binds = {};
+			state.meshletStats = {};
+		}
+
+		if (recorder != nullptr)
+		{
+			recorder->record(packetCount, MIN_PACKETS_PER_CHUNK, [&](uint32_t chunk, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+				recordRange(recordStates[chunk], commandBuffer, begin, end);
+			});
+		}
+		else if (packetCount > 0)
+		{
+			recordRange(recordStates[0], frameInfo.commandBuffer, 0, packetCount);
+		}
+
+		renderQueue.resetBindStats();
+		for (const auto& state : recordStates)
+		{
+			renderQueue.addBindStats(state.binds.getStats());
+			meshletStats.visible += state.meshletStats.visible;
+			meshletStats.culled += state.meshletStats.culled;
+			meshletStats.drawCalls += state.meshletStats.drawCalls;
+		}
+	}
+
+	void SimpleRenderSystem::buildGpuDrivenPackets() {
+		// visibility is only known on the GPU
+		objectStats = {};
+		meshletStats = {};
+
+		renderQueue.clear();
+		meshDrawDescriptorSets.clear();
+		const auto& meshDraws = gpuCulling->getMeshDraws();
+		for (uint32_t i = 0; i < meshDraws.size(); i++)
+		{
+			auto& model = *meshDraws[i].model;
+			auto descriptorSet = lveTextureStorage.getDescriptorSet(model.getTextureName(), defaultSamplerName);
+			meshDrawDescriptorSets.push_back(descriptorSet);
+			auto key = LveRenderQueue::makeKey(
+				static_cast<uint32_t>(model.getVertexFormat()),
+				renderQueue.materialId(descriptorSet),
+				renderQueue.meshId(&model),
 				0,
-				sizeof(SimplePushConstantData),
-				&push
+				0.f
 			);
+			renderQueue.push(key, i);
+		}
+		renderQueue.sort();
+	}
 
-			auto descriptorTextureSet = lveTextureStorage.getDescriptorSet(obj.model->getTextureName(), defaultSamplerName);
-			vkCmdBindDescriptorSets(
-				frameInfo.commandBuffer,
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				pipelineLayout,
-				1,
-				1,
-				&descriptorTextureSet,
-				0,
-				nullptr
+	void SimpleRenderSystem::recordGpuDrivenPackets(RecordState& state, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+		VkBuffer buffers[] = { gpuCulling->getInstanceBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+
+		const auto& meshDraws = gpuCulling->getMeshDraws();
+		const auto& packets = renderQueue.getPackets();
+		for (auto i = begin; i < end; i++)
+		{
+			const auto& draw = meshDraws[packets[i].value];
+			auto& model = *draw.model;
+
+			state.binds.bindPipeline(*instancedPipelines[static_cast<uint32_t>(model.getVertexFormat())]);
+			state.binds.bindDescriptorSet(pipelineLayout, 1, meshDrawDescriptorSets[packets[i].value]);
+			state.binds.bindMesh(model);
+			vkCmdDrawIndexedIndirectCount(
+				commandBuffer,
+				gpuCulling->getDrawCommandBuffer(),
+				draw.commandOffset,
+				gpuCulling->getDrawCountBuffer(),
+				draw.countOffset,
+				draw.maxDrawCount,
+				sizeof(VkDrawIndexedIndirectCommand)
+			);
+			state.meshletStats.drawCalls++;
+		}
+	}
+
+	void SimpleRenderSystem::buildPackets(FrameInfo& frameInfo) {
+		auto viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		auto frustum = LveFrustum::fromMatrix(viewProjection);
+
+		// world space boxes of all models, culled in SIMD batches before anything is recorded
+		candidateModels.clear();
+		candidateWorlds.clear();
+		worldBounds.clear();
+		frameInfo.registry.each<WorldTransformComponent, ModelComponent>(
+			[&](LveEntity, WorldTransformComponent& world, ModelComponent& model) {
+				const auto& modelMatrix = world.world;
+				auto center = (model.model->getBoundsMin() + model.model->getBoundsMax()) * 0.5f;
+				auto extent = (model.model->getBoundsMax() - model.model->getBoundsMin()) * 0.5f;
+				// box around the transformed box (Arvo)
+				glm::mat3 absolute{
+					glm::abs(glm::vec3(modelMatrix[0])),
+					glm::abs(glm::vec3(modelMatrix[1])),
+					glm::abs(glm::vec3(modelMatrix[2]))
+				};
+				worldBounds.push(glm::vec3(modelMatrix * glm::vec4(center, 1.f)), absolute * extent);
+				candidateModels.push_back(&model);
+				candidateWorlds.push_back(&world);
+			});
+		objectStats = {};
+		objectStats.visible = frustum.cullAabbs(worldBounds, objectVisibility);
+		objectStats.culled = static_cast<uint32_t>(candidateModels.size()) - objectStats.visible;
+
+		// group visible objects by model and lod, front to back inside a group
+		renderQueue.clear();
+		drawItems.clear();
+		auto cameraPosition = frameInfo.camera.getPosition();
+		for (uint32_t i = 0; i < candidateModels.size(); i++)
+		{
+			if (!objectVisibility[i]) continue;
+
+			auto& obj = *candidateModels[i];
+			obj.lod = selectLod(*obj.model, candidateWorlds[i]->world, frameInfo, obj.lod);
+			auto center = glm::vec3(candidateWorlds[i]->world * glm::vec4(obj.model->getSphereCenter(), 1.f));
+			auto key = LveRenderQueue::makeKey(0, 0, renderQueue.meshId(obj.model.get()), obj.lod, glm::distance(center, cameraPosition));
+			drawItems.push_back({ key, i });
+		}
+		RadixSort::Sort(drawItems, drawItemScratch);
+
+		drawGroups.clear();
+		instances.clear();
+		renderQueue.clear();
+		for (uint32_t first = 0; first < drawItems.size();)
+		{
+			auto& firstObj = *candidateModels[drawItems[first].value];
+			uint32_t end = first + 1;
+			// mesh ids can collide in the key, groups compare the models themselves
+			while (end < drawItems.size() &&
+				candidateModels[drawItems[end].value]->model == firstObj.model &&
+				candidateModels[drawItems[end].value]->lod == firstObj.lod)
+			{
+				end++;
+			}
+
+			auto& model = *firstObj.model;
+			DrawGroup group{ first, end - first, static_cast<uint32_t>(instances.size()), nullptr };
+			if (group.itemCount > 1)
+			{
+				for (auto i = first; i < end; i++)
+				{
+					auto normalMatrix = candidateWorlds[drawItems[i].value]->normal;
+
+					InstanceData instance{};
+					instance.modelMatrix = candidateWorlds[drawItems[i].value]->world * model.getPositionDecode();
+					for (int column = 0; column < 3; column++)
+					{
+						instance.normalMatrix[column] = glm::vec4(normalMatrix[column], 0.f);
+					}
+					instances.push_back(instance);
+				}
+				objectStats.instanced += group.itemCount;
+			}
+			group.descriptorSet = lveTextureStorage.getDescriptorSet(model.getTextureName(), defaultSamplerName);
+
+			// pipelines ordered by vertex format, the instanced variant after the plain one
+			auto pipeline = static_cast<uint32_t>(model.getVertexFormat()) * 2 + (group.itemCount > 1 ? 1 : 0);
+			// the group is as near as its nearest object, the first one
+			auto nearest = glm::vec3(candidateWorlds[drawItems[first].value]->world * glm::vec4(model.getSphereCenter(), 1.f));
+			auto key = LveRenderQueue::makeKey(
+				pipeline,
+				renderQueue.materialId(group.descriptorSet),
+				renderQueue.meshId(&model),
+				firstObj.lod,
+				glm::distance(nearest, cameraPosition)
 			);
-			
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+			renderQueue.push(key, static_cast<uint32_t>(drawGroups.size()));
+
+			drawGroups.push_back(group);
+			first = end;
+		}
+		uploadInstances(frameInfo.frameIndex);
+		renderQueue.sort();
+	}
+
+	void SimpleRenderSystem::recordPackets(RecordState& state, const FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+		auto viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		auto cameraPosition = frameInfo.camera.getPosition();
+		const auto& packets = renderQueue.getPackets();
+		bool instanceBufferBound = false;
+		for (auto i = begin; i < end; i++)
+		{
+			const auto& group = drawGroups[packets[i].value];
+			auto candidate = drawItems[group.firstItem].value;
+			auto& model = *candidateModels[candidate]->model;
+			auto lod = candidateModels[candidate]->lod;
+			auto format = static_cast<uint32_t>(model.getVertexFormat());
+
+			// instances of a group don`t share their visible meshlets, only single objects cull them
+			bool instanced = group.itemCount > 1;
+			bool useMeshlets = !instanced && !model.getMeshlets().empty();
+			if (useMeshlets)
+			{
+				auto cullContext = LveMeshlets::makeCullContext(
+					viewProjection,
+					candidateWorlds[candidate]->world,
+					cameraPosition,
+					model
+				);
+				LveMeshlets::cull(model.getMeshlets(), model.getLods()[lod], cullContext, state.visibleMeshlets, state.meshletStats);
+				if (state.visibleMeshlets.empty())
+					continue;
+			}
+
+			if (instanced)
+			{
+				state.binds.bindPipeline(*instancedPipelines[format]);
+				if (!instanceBufferBound)
+				{
+					VkBuffer buffers[] = { instanceBuffers[frameInfo.frameIndex]->getBuffer() };
+					VkDeviceSize offsets[] = { 0 };
+					vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+					instanceBufferBound = true;
+				}
+			}
+			else
+			{
+				state.binds.bindPipeline(*lvePipelines[format]);
+
+				SimplePushConstantData push{};
+				push.modelMatrix = candidateWorlds[candidate]->world * model.getPositionDecode();
+				push.normalMatrix = candidateWorlds[candidate]->normal;
+				vkCmdPushConstants(
+					commandBuffer,
+					pipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					0,
+					sizeof(SimplePushConstantData),
+					&push
+				);
+			}
+
+			state.binds.bindDescriptorSet(pipelineLayout, 1, group.descriptorSet);
+			state.binds.bindMesh(model);
+			if (useMeshlets)
+			{
+				state.meshletStats.drawCalls += model.drawMeshlets(commandBuffer, state.visibleMeshlets);
+			}
+			else
+			{
+				model.draw(commandBuffer, lod, group.itemCount, group.firstInstance);
+				state.meshletStats.drawCalls += model.getLods()[lod].submeshCount;
+			}
+		}
+	}
+
+	uint32_t SimpleRenderSystem::selectLod(const LveModel& model, const glm::mat4& modelMatrix, const FrameInfo& frameInfo, uint32_t current) {
+		const auto& lods = model.getLods();
+		if (lods.size() == 1 || frameInfo.extent.height == 0)
+			return 0;
+
+		// errors are object space, the largest axis scale bounds how far they stretch in the world
+		float scale = std::max({
+			glm::length(glm::vec3(modelMatrix[0])),
+			glm::length(glm::vec3(modelMatrix[1])),
+			glm::length(glm::vec3(modelMatrix[2]))
+		});
+		auto center = glm::vec3(modelMatrix * glm::vec4(model.getSphereCenter(), 1.f));
+		float radius = model.getSphereRadius() * scale;
+
+		// distance to the nearest point of the bounding sphere
+		float distance = std::max(glm::length(center - frameInfo.camera.getPosition()) - radius, 1e-3f);
+		float pixelsPerUnit = frameInfo.camera.getProjection()[1][1] * 0.5f * static_cast<float>(frameInfo.extent.height) / distance;
+		auto projectedError = [&](uint32_t lod) { return lods[lod].error * scale * pixelsPerUnit; };
+
+		// lod errors grow monotonically, so walking from the current lod is enough
+		uint32_t lod = std::min(current, static_cast<uint32_t>(lods.size() - 1));
+		while (lod > 0 && projectedError(lod) > LOD_PIXEL_ERROR * (1.f + LOD_HYSTERESIS))
+		{
+			lod--;
+		}
+		while (lod + 1 < lods.size() && projectedError(lod + 1) <= LOD_PIXEL_ERROR * (1.f - LOD_HYSTERESIS))
+		{
+			lod++;
 		}
+		return lod;
 	}
 }
\ No newline at end of file
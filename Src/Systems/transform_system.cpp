@@ -0,0 +1,295 @@
+#include "transform_system.hpp"
+
+//std
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LVE_TRANSFORM_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LVE_TRANSFORM_SSE
+#endif
+
+namespace lve {
+
+	namespace {
+
+		// the few lane wise operations the batch needs, 8 floats wide on every target.
+		// Masks come from the compares only and are only fed to select
+#if defined(LVE_TRANSFORM_AVX)
+		struct Float8
+		{
+			__m256 v;
+
+			static Float8 load(const float* data) { return { _mm256_loadu_ps(data) }; }
+			static Float8 broadcast(float value) { return { _mm256_set1_ps(value) }; }
+			void store(float* data) const { _mm256_storeu_ps(data, v); }
+
+			Float8 operator+(Float8 other) const { return { _mm256_add_ps(v, other.v) }; }
+			Float8 operator-(Float8 other) const { return { _mm256_sub_ps(v, other.v) }; }
+			Float8 operator*(Float8 other) const { return { _mm256_mul_ps(v, other.v) }; }
+			Float8 operator/(Float8 other) const { return { _mm256_div_ps(v, other.v) }; }
+		};
+
+		Float8 roundNearest(Float8 x) { return { _mm256_round_ps(x.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+		Float8 floor(Float8 x) { return { _mm256_floor_ps(x.v) }; }
+		Float8 equal(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+		Float8 greaterEqual(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+		Float8 select(Float8 mask, Float8 a, Float8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+		Float8 either(Float8 maskA, Float8 maskB) { return { _mm256_or_ps(maskA.v, maskB.v) }; }
+
+		const char* const simdName = "avx";
+#elif defined(LVE_TRANSFORM_SSE)
+		struct Float8
+		{
+			__m128 low, high;
+
+			static Float8 load(const float* data) { return { _mm_loadu_ps(data), _mm_loadu_ps(data + 4) }; }
+			static Float8 broadcast(float value) { return { _mm_set1_ps(value), _mm_set1_ps(value) }; }
+			void store(float* data) const { _mm_storeu_ps(data, low); _mm_storeu_ps(data + 4, high); }
+
+			Float8 operator+(Float8 other) const { return { _mm_add_ps(low, other.low), _mm_add_ps(high, other.high) }; }
+			Float8 operator-(Float8 other) const { return { _mm_sub_ps(low, other.low), _mm_sub_ps(high, other.high) }; }
+			Float8 operator*(Float8 other) const { return { _mm_mul_ps(low, other.low), _mm_mul_ps(high, other.high) }; }
+			Float8 operator/(Float8 other) const { return { _mm_div_ps(low, other.low), _mm_div_ps(high, other.high) }; }
+		};
+
+		// SSE2 has no round instruction, the conversion rounds to nearest in the default mode. Angles stay far below 2^31
+		Float8 roundNearest(Float8 x)
+		{
+			return { _mm_cvtepi32_ps(_mm_cvtps_epi32(x.low)), _mm_cvtepi32_ps(_mm_cvtps_epi32(x.high)) };
+		}
+
+		__m128 floor4(__m128 x)
+		{
+			// truncation rounds negative values up, step those back by one
+			auto truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.f)));
+		}
+
+		Float8 floor(Float8 x) { return { floor4(x.low), floor4(x.high) }; }
+		Float8 equal(Float8 a, Float8 b) { return { _mm_cmpeq_ps(a.low, b.low), _mm_cmpeq_ps(a.high, b.high) }; }
+		Float8 greaterEqual(Float8 a, Float8 b) { return { _mm_cmpge_ps(a.low, b.low), _mm_cmpge_ps(a.high, b.high) }; }
+		Float8 select(Float8 mask, Float8 a, Float8 b)
+		{
+			return {
+				_mm_or_ps(_mm_and_ps(mask.low, a.low), _mm_andnot_ps(mask.low, b.low)),
+				_mm_or_ps(_mm_and_ps(mask.high, a.high), _mm_andnot_ps(mask.high, b.high))
+			};
+		}
+		Float8 either(Float8 maskA, Float8 maskB) { return { _mm_or_ps(maskA.low, maskB.low), _mm_or_ps(maskA.high, maskB.high) }; }
+
+		const char* const simdName = "sse2";
+#else
+		struct Float8
+		{
+			float v[8];
+
+			static Float8 load(const float* data)
+			{
+				Float8 result;
+				for (int i = 0; i < 8; i++) result.v[i] = data[i];
+				return result;
+			}
+			static Float8 broadcast(float value)
+			{
+				Float8 result;
+				for (int i = 0; i < 8; i++) result.v[i] = value;
+				return result;
+			}
+			void store(float* data) const
+			{
+				for (int i = 0; i < 8; i++) data[i] = v[i];
+			}
+
+			template<typename Op>
+			Float8 apply(Float8 other, Op op) const
+			{
+				Float8 result;
+				for (int i = 0; i < 8; i++) result.v[i] = op(v[i], other.v[i]);
+				return result;
+			}
+
+			Float8 operator+(Float8 other) const { return apply(other, [](float a, float b) { return a + b; }); }
+			Float8 operator-(Float8 other) const { return apply(other, [](float a, float b) { return a - b; }); }
+			Float8 operator*(Float8 other) const { return apply(other, [](float a, float b) { return a * b; }); }
+			Float8 operator/(Float8 other) const { return apply(other, [](float a, float b) { return a / b; }); }
+		};
+
+		// masks are 1 or 0 per lane
+		Float8 roundNearest(Float8 x) { return x.apply(x, [](float a, float) { return std::nearbyint(a); }); }
+		Float8 floor(Float8 x) { return x.apply(x, [](float a, float) { return std::floor(a); }); }
+		Float8 equal(Float8 a, Float8 b) { return a.apply(b, [](float x, float y) { return x == y ? 1.f : 0.f; }); }
+		Float8 greaterEqual(Float8 a, Float8 b) { return a.apply(b, [](float x, float y) { return x >= y ? 1.f : 0.f; }); }
+		Float8 select(Float8 mask, Float8 a, Float8 b)
+		{
+			Float8 result;
+			for (int i = 0; i < 8; i++) result.v[i] = mask.v[i] != 0.f ? a.v[i] : b.v[i];
+			return result;
+		}
+		Float8 either(Float8 maskA, Float8 maskB) { return maskA.apply(maskB, [](float a, float b) { return a != 0.f || b != 0.f ? 1.f : 0.f; }); }
+
+		const char* const simdName = "scalar";
+#endif
+
+		/// <summary>
+		/// Sine and cosine of 8 angles (Cephes sinf/cosf polynomials). The angle is reduced to [-pi/4, pi/4]
+		/// around the nearest multiple of pi/2 in three parts (Cody-Waite), the quadrant swaps and negates the results.
+		/// About 1e-7 absolute error for the angles transforms use
+		/// </summary>
+		void sinCos(Float8 x, Float8& sine, Float8& cosine)
+		{
+			auto quadrant = roundNearest(x * Float8::broadcast(0.636619772367581f));
+			auto r = x - quadrant * Float8::broadcast(1.5703125f);
+			r = r - quadrant * Float8::broadcast(4.837512969970703125e-4f);
+			r = r - quadrant * Float8::broadcast(7.54978995489188216e-8f);
+
+			auto r2 = r * r;
+			auto s = r + r * r2 * (Float8::broadcast(-1.6666654611e-1f) + r2 * (Float8::broadcast(8.3321608736e-3f) + r2 * Float8::broadcast(-1.9515295891e-4f)));
+			auto c = Float8::broadcast(1.f) - r2 * Float8::broadcast(0.5f)
+				+ r2 * r2 * (Float8::broadcast(4.166664568298827e-2f) + r2 * (Float8::broadcast(-1.388731625493765e-3f) + r2 * Float8::broadcast(2.443315711809948e-5f)));
+
+			// quadrant mod 4: 1 - sin = c, cos = -s; 2 - both negated; 3 - sin = -c, cos = s
+			auto four = Float8::broadcast(4.f);
+			auto q = quadrant - floor(quadrant / four) * four;
+			auto odd = either(equal(q, Float8::broadcast(1.f)), equal(q, Float8::broadcast(3.f)));
+			auto zero = Float8::broadcast(0.f);
+
+			auto sinValue = select(odd, c, s);
+			auto cosValue = select(odd, s, c);
+			sine = select(greaterEqual(q, Float8::broadcast(2.f)), zero - sinValue, sinValue);
+			cosine = select(either(equal(q, Float8::broadcast(1.f)), equal(q, Float8::broadcast(2.f))), zero - cosValue, cosValue);
+		}
+	}
+
+	const char* const TransformSystem::SIMD_NAME = simdName;
+
+	TransformSystem::TransformSystem(LveJobSystem& jobSystem) : jobSystem{ jobSystem }
+	{
+	}
+
+	void TransformSystem::update(LveRegistry& registry)
+	{
+		sceneGraph.updateOrder(registry);
+		auto& worlds = registry.pool<WorldTransformComponent>();
+
+		// room for every transform, so gathering is plain stores without a capacity check each
+		auto capacity = (registry.pool<TransformComponent>().size() + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+		for (auto* channel : { &translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ })
+		{
+			channel->resize(capacity);
+		}
+		targets.resize(capacity);
+
+		stats = {};
+		size_t dirtyCount = 0;
+		registry.each<TransformComponent>(
+			[&](LveEntity entity, TransformComponent& transform) {
+				// nodes of the scene graph get their local matrices, it multiplies in the parents afterwards
+				Target target{};
+				auto node = sceneGraph.nodeOf(entity);
+				if (node != LveSceneGraph::NONE)
+				{
+					target = { &sceneGraph.localMatrix(node), &sceneGraph.localNormalMatrix(node) };
+				}
+				else if (auto* world = worlds.tryGet(entity))
+				{
+					target = { &world->world, &world->normal };
+				}
+				else
+				{
+					return;
+				}
+
+				stats.transforms++;
+				if (!transform.dirty)
+					return;
+
+				transform.dirty = false;
+				if (node != LveSceneGraph::NONE)
+				{
+					sceneGraph.markDirty(node);
+				}
+				translationX[dirtyCount] = transform.translation.x;
+				translationY[dirtyCount] = transform.translation.y;
+				translationZ[dirtyCount] = transform.translation.z;
+				rotationX[dirtyCount] = transform.rotation.x;
+				rotationY[dirtyCount] = transform.rotation.y;
+				rotationZ[dirtyCount] = transform.rotation.z;
+				scaleX[dirtyCount] = transform.scale.x;
+				scaleY[dirtyCount] = transform.scale.y;
+				scaleZ[dirtyCount] = transform.scale.z;
+				targets[dirtyCount] = target;
+				dirtyCount++;
+			});
+		stats.recomputed = static_cast<uint32_t>(dirtyCount);
+
+		// identity padding fills the last batch, its lanes are computed but never written
+		for (auto i = dirtyCount; i % BATCH_SIZE != 0; i++)
+		{
+			translationX[i] = translationY[i] = translationZ[i] = 0.f;
+			rotationX[i] = rotationY[i] = rotationZ[i] = 0.f;
+			scaleX[i] = scaleY[i] = scaleZ[i] = 1.f;
+		}
+
+		for (size_t first = 0; first < dirtyCount; first += BATCH_SIZE)
+		{
+			computeBatch(first, std::min<size_t>(BATCH_SIZE, dirtyCount - first));
+		}
+
+		sceneGraph.propagate(registry, jobSystem);
+		stats.sceneGraphNodes = sceneGraph.getStats().nodes;
+		stats.propagated = sceneGraph.getStats().propagated;
+	}
+
+	void TransformSystem::computeBatch(size_t first, size_t count)
+	{
+		// same matrix as TransformComponent::mat4, Translate * Ry * Rx * Rz * Scale
+		Float8 s1, c1, s2, c2, s3, c3;
+		sinCos(Float8::load(rotationY.data() + first), s1, c1);
+		sinCos(Float8::load(rotationX.data() + first), s2, c2);
+		sinCos(Float8::load(rotationZ.data() + first), s3, c3);
+
+		// rotation[column][row]
+		Float8 rotation[3][3] = {
+			{ c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 },
+			{ c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 },
+			{ c2 * s1, Float8::broadcast(0.f) - s2, c1 * c2 }
+		};
+		Float8 scale[3] = {
+			Float8::load(scaleX.data() + first),
+			Float8::load(scaleY.data() + first),
+			Float8::load(scaleZ.data() + first)
+		};
+		auto one = Float8::broadcast(1.f);
+
+		// lanes of every matrix element, then scattered to the components
+		alignas(32) float world[3][3][BATCH_SIZE];
+		alignas(32) float normal[3][3][BATCH_SIZE];
+		for (int column = 0; column < 3; column++)
+		{
+			auto inverseScale = one / scale[column];
+			for (int row = 0; row < 3; row++)
+			{
+				(scale[column] * rotation[column][row]).store(world[column][row]);
+				(inverseScale * rotation[column][row]).store(normal[column][row]);
+			}
+		}
+
+		for (size_t lane = 0; lane < count; lane++)
+		{
+			auto& target = targets[first + lane];
+			auto& targetWorld = *target.world;
+			auto& targetNormal = *target.normal;
+			for (int column = 0; column < 3; column++)
+			{
+				targetWorld[column] = { world[column][0][lane], world[column][1][lane], world[column][2][lane], 0.f };
+				targetNormal[column] = { normal[column][0][lane], normal[column][1][lane], normal[column][2][lane] };
+			}
+			targetWorld[3] = { translationX[first + lane], translationY[first + lane], translationZ[first + lane], 1.f };
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "lve_ecs.hpp"
+#include "lve_game_object.hpp"
+#include "lve_job_system.hpp"
+#include "lve_scene_graph.hpp"
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Keeps the WorldTransformComponent of every entity that also has a TransformComponent up to date. Only transforms marked
+	// dirty are recomputed: they are gathered into structure of arrays scratch and computed BATCH_SIZE at a time,
+	// sines and cosines of a whole batch in one SIMD polynomial (AVX, two SSE2 halves, or scalar without SIMD).
+	// Static objects cost one flag test per frame instead of six sin/cos and two matrix builds.
+	// Transforms of entities linked in the scene graph are local, their world matrices come out of LveSceneGraph::propagate.
+	class TransformSystem
+	{
+	public:
+		static constexpr uint32_t BATCH_SIZE = 8;
+		// "avx", "sse2" or "scalar"
+		static const char* const SIMD_NAME;
+
+		struct Stats
+		{
+			uint32_t transforms = 0;
+			uint32_t recomputed = 0;
+			uint32_t sceneGraphNodes = 0;
+			// world matrices of scene graph nodes recomputed, the moved nodes and everything below them
+			uint32_t propagated = 0;
+		};
+
+		TransformSystem(LveJobSystem& jobSystem);
+
+		TransformSystem(const TransformSystem&) = delete;
+		void operator=(const TransformSystem&) = delete;
+
+		/// <summary>
+		/// Recompute the matrices of dirty transforms and clear their flags, then propagate the scene graph
+		/// </summary>
+		void update(LveRegistry& registry);
+
+		// parent/child links of the transforms
+		LveSceneGraph& getSceneGraph() { return sceneGraph; }
+
+		// of the last update
+		const Stats& getStats() const { return stats; }
+
+	private:
+		// where the matrices of a scratch entry go
+		struct Target
+		{
+			glm::mat4* world = nullptr;
+			glm::mat3* normal = nullptr;
+		};
+
+		/// <summary>
+		/// Matrices of scratch entries [first, first + BATCH_SIZE), the first count of them written to their targets
+		/// </summary>
+		void computeBatch(size_t first, size_t count);
+
+		// dirty transforms of the update first, padded to whole batches
+		std::vector<float> translationX, translationY, translationZ;
+		std::vector<float> rotationX, rotationY, rotationZ;
+		std::vector<float> scaleX, scaleY, scaleZ;
+		std::vector<Target> targets;
+
+		LveJobSystem& jobSystem;
+		LveSceneGraph sceneGraph;
+		Stats stats{};
+	};
+}
@@ -7,7 +7,12 @@
 #include "lve_camera.hpp"
 #include "Systems/simple_render_system.hpp"
 #include "Systems/point_light_system.hpp"
+#include "Systems/transform_system.hpp"
 #include "lve_buffer.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_job_system.hpp"
+#include "lve_light_clusters.hpp"
+#include "lve_parallel_recorder.hpp"
 #include "Definitions/DefaultSamplersNames.hpp"
 
 //libs
@@ -19,15 +24,33 @@
 #include <stdexcept>
 #include <array>
 #include <chrono>
+#include <fstream>
+#include <iostream>
 #include <numeric>
+#include <random>
 #include "imgui.hpp"
 
 namespace lve {
 
-	FirstApp::FirstApp() {
+	FirstApp::FirstApp(const Settings& settings)
+		:
+		settings{ settings },
+		lveWindow{ settings.headless ? nullptr : std::make_unique<LveWindow>(static_cast<int>(settings.width), static_cast<int>(settings.height), "Vulkan V") },
+		lveDevice{ lveWindow.get() },
+		lveRenderer{ settings.headless
+			? std::make_shared<LveRenderer>(lveDevice, VkExtent2D{ settings.width, settings.height })
+			: std::make_shared<LveRenderer>(*lveWindow, lveDevice) },
+		lveTextureStorage{ lveDevice, lveRenderer }
+	{
+		if (settings.headless && settings.frameLimit == 0)
+		{
+			throw std::invalid_argument("headless mode requires a frame limit");
+		}
+
 		globalPool = LveDescriptorPool::Builder(lveDevice)
 			.setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.build();
 
 		imGuiPool = LveDescriptorPool::Builder(lveDevice)
@@ -46,16 +69,23 @@ namespace lve {
 			.addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.build();
 
-		InitializeImGui(lveWindow, lveDevice, lveRenderer->getSwapChainRenderPass(), imGuiPool->getDescriptorPool(), LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		//imgui is driven by the glfw window
+		if (!settings.headless)
+		{
+			InitializeImGui(*lveWindow, lveDevice, lveRenderer->getSwapChainRenderPass(), imGuiPool->getDescriptorPool(), LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		}
 		loadTextures();
 		loadGameObjects();
 	}
 
 	FirstApp::~FirstApp() 
 	{
-		ImGui_ImplVulkan_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
-		ImGui::DestroyContext();
+		if (!settings.headless)
+		{
+			ImGui_ImplVulkan_Shutdown();
+			ImGui_ImplGlfw_Shutdown();
+			ImGui::DestroyContext();
+		}
 	}
 
 	void FirstApp::run() {
@@ -75,15 +105,27 @@ namespace lve {
 
 		auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
 			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
 			.build()
 			;
 
+		LveLightClusters lightClusters{ lveDevice };
+		std::vector<PointLight> lights;
+
 		std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
 		{
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
+			auto lightsInfo = lightClusters.lightsInfo(i);
+			auto clustersInfo = lightClusters.clustersInfo(i);
+			auto lightIndicesInfo = lightClusters.lightIndicesInfo(i);
 			LveDescriptorWriter(*globalSetLayout, *globalPool)
 				.writeBuffer(0, &bufferInfo)
+				.writeBuffer(1, &lightsInfo)
+				.writeBuffer(2, &clustersInfo)
+				.writeBuffer(3, &lightIndicesInfo)
 				.build(globalDescriptorSets[i]);
 		}
 		
@@ -93,35 +135,55 @@ namespace lve {
 			lveRenderer->getSwapChainRenderPass(),
 			*globalSetLayout
 		};
+		simpleRenderSystem.setGpuDriven(settings.gpuCulling);
+
+		// null - draws are recorded inline into the frame`s primary command buffer
+		std::unique_ptr<LveParallelRecorder> recorder;
+		if (settings.recordThreads > 0)
+		{
+			recorder = std::make_unique<LveParallelRecorder>(lveDevice, LveJobSystem::shared(), settings.recordThreads);
+		}
 
 		PointLightSystem pointLightSystem{
 			lveDevice,
 			lveRenderer->getSwapChainRenderPass(),
 			globalSetLayout->getDescriptorSetLayout()
 		};
+		TransformSystem transformSystem{ LveJobSystem::shared() };
         LveCamera camera{};
 
-        auto viewerObject = LveGameObject::createGameObject();
-		viewerObject.transform.translation.z = -2.5f;
+        TransformComponent viewerTransform{};
+		viewerTransform.translation.z = -2.5f;
         KeyboardMovementController cameraController{};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
+		const auto startTime = currentTime;
+		uint32_t renderedFrames = 0;
 
-		bool c = true;
-		while (!lveWindow.shouldClose()) {
-			glfwPollEvents();
-
+		while (settings.headless ? renderedFrames < settings.frameLimit : !lveWindow->shouldClose()) {
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
-            cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), frameTime, viewerObject);
-            camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+			if (settings.headless)
+			{
+				//fixed step keeps the animation and so the read back image reproducible
+				frameTime = 1.f / 60.f;
+			}
+			else
+			{
+				glfwPollEvents();
+				cameraController.moveInPlaneXZ(lveWindow->getGLFWwindow(), frameTime, viewerTransform);
+			}
+            camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
             
             float aspect = lveRenderer->getAspectRation();
             //camera.setOrthographicProjection(-aspect, aspect, -1, 1, -1, 1);
             camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 100.f);
 
+			//jobs that have to run on this thread, like queue submissions
+			LveJobSystem::shared().runMainThreadJobs();
+
 			if (auto commandBuffer = lveRenderer->beginFrame())
 			{
 				int frameIndex = lveRenderer->getFrameIndex();
@@ -131,7 +193,8 @@ namespace lve {
 					commandBuffer,
 					camera,
 					globalDescriptorSets[frameIndex],
-					gameObjects
+					registry,
+					lveRenderer->getExtent()
 				};
 
 				//update
@@ -139,65 +202,185 @@ namespace lve {
 				ubo.projection = camera.getProjection();
 				ubo.view = camera.getView();
 				ubo.inverseView = camera.getInverseView();
-				pointLightSystem.update(frameInfo, ubo);
+				pointLightSystem.update(frameInfo);
+				transformSystem.update(registry);
+				pointLightSystem.gatherLights(frameInfo, lights);
+				lightClusters.update(frameIndex, camera, frameInfo.extent, lights, ubo);
 				uboBuffers[frameIndex]->writeToBuffer(&ubo);
 				uboBuffers[frameIndex]->flush();
 
 				//render
-				lveRenderer->beginSwapChainRenderPass(commandBuffer);
+				simpleRenderSystem.prepareFrame(frameInfo);
 
 				//order here matters
-				simpleRenderSystem.renderGameObjects(frameInfo);
+				if (recorder != nullptr)
+				{
+					lveRenderer->beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					recorder->beginFrame(frameIndex, lveRenderer->getSwapChainRenderPass(), lveRenderer->getCurrentFramebuffer(), lveRenderer->getExtent());
+					simpleRenderSystem.renderGameObjects(frameInfo, recorder.get());
+					//the pass takes no inline commands, the rest of it goes into one more secondary buffer
+					frameInfo.commandBuffer = recorder->beginSecondary();
+				}
+				else
+				{
+					lveRenderer->beginSwapChainRenderPass(commandBuffer);
+					simpleRenderSystem.renderGameObjects(frameInfo);
+				}
 				pointLightSystem.render(frameInfo);
 
-				ImGuiNewFrame();
-				auto tData = lveTextureStorage.getTextureData("statue");
-				ImGui::SetNextWindowSizeConstraints(
-					{ },
-					{ (float)tData.texWidth, (float)tData.texHeight }
-				);
-				ImGui::Begin("Hello button");
-				auto info = lveTextureStorage.getDescriptorSet("statue", defaultSamplerName);
-				ImGui::Image(info, { (float)tData.texWidth, (float)tData.texHeight });
-				ImGui::End();
-				
-				ImGuiRender(commandBuffer);
-
+				if (!settings.headless)
+				{
+					ImGuiNewFrame();
+					auto tData = lveTextureStorage.getTextureData("statue");
+					ImGui::SetNextWindowSizeConstraints(
+						{ },
+						{ (float)tData.texWidth, (float)tData.texHeight }
+					);
+					ImGui::Begin("Hello button");
+					auto info = lveTextureStorage.getDescriptorSet("statue", defaultSamplerName);
+					ImGui::Image(info, { (float)tData.texWidth, (float)tData.texHeight });
+					ImGui::End();
+
+					auto& objectStats = simpleRenderSystem.getObjectStats();
+					auto& meshletStats = simpleRenderSystem.getMeshletStats();
+					ImGui::Begin("Culling");
+					if (lveDevice.supportsIndirectCount())
+					{
+						bool gpuDriven = simpleRenderSystem.isGpuDriven();
+						if (ImGui::Checkbox("GPU culling", &gpuDriven))
+						{
+							simpleRenderSystem.setGpuDriven(gpuDriven);
+						}
+					}
+					ImGui::Text("objects: %u visible, %u culled", objectStats.visible, objectStats.culled);
+					ImGui::Text("instanced: %u objects", objectStats.instanced);
+					ImGui::Text("meshlets: %u visible, %u culled", meshletStats.visible, meshletStats.culled);
+					ImGui::Text("draw calls: %u", meshletStats.drawCalls);
+					auto& transformStats = transformSystem.getStats();
+					ImGui::Text("transforms: %u, recomputed %u", transformStats.transforms, transformStats.recomputed);
+					ImGui::Text("scene graph: %u nodes, propagated %u", transformStats.sceneGraphNodes, transformStats.propagated);
+					ImGui::End();
+
+					auto& queueStats = simpleRenderSystem.getQueueStats();
+					ImGui::Begin("Render queue");
+					ImGui::Text("packets: %u", queueStats.packets);
+					ImGui::Text("pipeline binds: %u, avoided %u", queueStats.pipelines.issued, queueStats.pipelines.avoided);
+					ImGui::Text("descriptor set binds: %u, avoided %u", queueStats.descriptorSets.issued, queueStats.descriptorSets.avoided);
+					ImGui::Text("mesh binds: %u, avoided %u", queueStats.meshes.issued, queueStats.meshes.avoided);
+					if (recorder != nullptr)
+					{
+						ImGui::Text("secondary command buffers: %u", recorder->getExecutedCount());
+					}
+					ImGui::End();
+
+					auto& lightStats = lightClusters.getStats();
+					ImGui::Begin("Lights");
+					ImGui::Text("lights: %u", lightStats.lights);
+					ImGui::Text("clusters: %u x %u x %u", LveLightClusters::GRID_X, LveLightClusters::GRID_Y, LveLightClusters::GRID_Z);
+					ImGui::Text("light indices: %u, dropped %u", lightStats.lightIndices, lightStats.droppedIndices);
+					ImGui::Text("max lights per cluster: %u", lightStats.maxClusterLights);
+					ImGui::End();
+
+					ImGuiRender(frameInfo.commandBuffer);
+				}
+
+				if (recorder != nullptr)
+				{
+					recorder->endSecondary(frameInfo.commandBuffer);
+					recorder->execute(commandBuffer);
+				}
 				lveRenderer->endSwapChainRenderPass(commandBuffer);
 				lveRenderer->endFrame();
+				renderedFrames++;
+			}
+
+			if (!settings.headless && settings.frameLimit != 0 && renderedFrames >= settings.frameLimit)
+			{
+				break;
 			}
 		}
 
 		vkDeviceWaitIdle(lveDevice.device());
+
+		float totalTime = std::chrono::duration<float, std::chrono::seconds::period>(
+			std::chrono::high_resolution_clock::now() - startTime).count();
+		std::cout << "rendered frames: " << renderedFrames
+			<< "; total: " << totalTime << " s"
+			<< "; avg frame: " << (renderedFrames != 0 ? totalTime * 1000.f / renderedFrames : 0.f) << " ms"
+			<< std::endl;
+
+		auto memoryStats = lveDevice.getAllocator().getStats();
+		std::cout << "device memory: live " << memoryStats.liveBytes / 1024 << " KiB"
+			<< "; reserved " << memoryStats.reservedBytes / 1024 << " KiB"
+			<< "; allocations " << memoryStats.allocationCount
+			<< "; blocks " << memoryStats.blockCount
+			<< "; dedicated " << memoryStats.dedicatedCount
+			<< "; fragmentation " << memoryStats.fragmentation
+			<< std::endl;
+
+		auto geometryStats = lveDevice.getGeometryArena().getStats();
+		std::cout << "geometry arena: live " << geometryStats.liveBytes / 1024 << " KiB"
+			<< "; reserved " << geometryStats.reservedBytes / 1024 << " KiB"
+			<< "; ranges " << geometryStats.rangeCount
+			<< "; buffers " << geometryStats.bufferCount
+			<< std::endl;
+
+		if (settings.headless && !settings.outputPath.empty())
+		{
+			writeLastFrame();
+		}
 	} 
 
+	void FirstApp::writeLastFrame()
+	{
+		auto pixels = lveRenderer->readbackLastFrame();
+		auto extent = lveRenderer->getExtent();
+
+		std::ofstream file{ settings.outputPath, std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + settings.outputPath);
+		}
+
+		//binary PPM, alpha dropped
+		file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+		}
+
+		std::cout << "last frame written to: " << settings.outputPath << std::endl;
+	}
+
 	void FirstApp::loadGameObjects() {
-		std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "Models/flat_vase.obj");
-        auto flatVase = LveGameObject::createGameObject();
-		flatVase.model = lveModel;
-		flatVase.transform.translation = { -.5f, .5f, 0.f };
-		flatVase.transform.scale = { 3.f, 1.5f, 3.f };
-		flatVase.model->setTextureName("statue2");
-        gameObjects.emplace(flatVase.getId(), std::move(flatVase));
-
-		lveModel = LveModel::createModelFromFile(lveDevice, "Models/smooth_vase.obj");
-		auto smoothVase = LveGameObject::createGameObject();
-		smoothVase.model = lveModel;
-		smoothVase.transform.translation = { .5f, .5f, 0.f };
-		smoothVase.transform.scale = { 3.f, 1.5f, 3.f };
-		smoothVase.model->setTextureName("statue3");
-		gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
-
-		lveModel = LveModel::createModelFromFile(lveDevice, "Models/quad.obj");
-		auto floor = LveGameObject::createGameObject();
-		floor.model = lveModel;
-		floor.transform.translation = { 0.f, .5f, 0.f };
-		floor.transform.scale = { 3.f, 1.f, 3.f };
-		floor.model->setTextureName("statue");
-		gameObjects.emplace(floor.getId(), std::move(floor));
-
-		auto pointLight = LveGameObject::makePointLight(0.02f);
-		gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+		std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "Models/flat_vase.obj", settings.vertexFormat);
+		lveModel->setTextureName("statue2");
+		auto flatVase = registry.create();
+		registry.add<ModelComponent>(flatVase, { lveModel });
+		registry.add<WorldTransformComponent>(flatVase);
+		auto& flatVaseTransform = registry.add<TransformComponent>(flatVase);
+		flatVaseTransform.translation = { -.5f, .5f, 0.f };
+		flatVaseTransform.scale = { 3.f, 1.5f, 3.f };
+
+		lveModel = LveModel::createModelFromFile(lveDevice, "Models/smooth_vase.obj", settings.vertexFormat);
+		lveModel->setTextureName("statue3");
+		auto smoothVase = registry.create();
+		registry.add<ModelComponent>(smoothVase, { lveModel });
+		registry.add<WorldTransformComponent>(smoothVase);
+		auto& smoothVaseTransform = registry.add<TransformComponent>(smoothVase);
+		smoothVaseTransform.translation = { .5f, .5f, 0.f };
+		smoothVaseTransform.scale = { 3.f, 1.5f, 3.f };
+
+		lveModel = LveModel::createModelFromFile(lveDevice, "Models/quad.obj", settings.vertexFormat);
+		lveModel->setTextureName("statue");
+		auto floor = registry.create();
+		registry.add<ModelComponent>(floor, { lveModel });
+		registry.add<WorldTransformComponent>(floor);
+		auto& floorTransform = registry.add<TransformComponent>(floor);
+		floorTransform.translation = { 0.f, .5f, 0.f };
+		floorTransform.scale = { 3.f, 1.f, 3.f };
+
+		makePointLight(registry, 0.02f);
 
 		std::vector<glm::vec3> lightColors{
 			{1.f, .1f, .1f},
@@ -210,16 +393,25 @@ namespace lve {
 
 		for (int i = 0; i < lightColors.size(); i++)
 		{
-			auto pointLight = LveGameObject::makePointLight(0.7f);
-			pointLight.color = lightColors[i];
+			auto pointLight = makePointLight(registry, 0.7f, 0.1f, lightColors[i]);
 			auto rotateLight = glm::rotate(
 				glm::mat4(1.f),
 				(i * glm::two_pi<float>()) / lightColors.size(),
 				{ 0.f, -1.f, 0.f }
 			);
-			pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
+			registry.get<TransformComponent>(pointLight).translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
+		}
 
-			gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+		//fixed seed, the same lights every run
+		std::mt19937 random{ 7 };
+		std::uniform_real_distribution<float> position{ -3.f, 3.f };
+		std::uniform_real_distribution<float> height{ -1.5f, .4f };
+		std::uniform_real_distribution<float> channel{ .1f, 1.f };
+		for (uint32_t i = 0; i < settings.extraLights; i++)
+		{
+			glm::vec3 color{ channel(random), channel(random), channel(random) };
+			auto pointLight = makePointLight(registry, 0.02f, 0.02f, color);
+			registry.get<TransformComponent>(pointLight).translation = { position(random), height(random), position(random) };
 		}
 	}
 
@@ -8,6 +8,7 @@
 #include "lve_texture_storage.hpp"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lve {
@@ -18,7 +19,28 @@ namespace lve {
 		static constexpr int WIDTH = 1920;
 		static constexpr int HEIGHT = 1080;
 
-		FirstApp();
+		struct Settings
+		{
+			// render offscreen without a window, for display-less machines (e.g. lavapipe in CI)
+			bool headless = false;
+			uint32_t width = WIDTH;
+			uint32_t height = HEIGHT;
+			// 0 - run until window is closed, headless mode requires a limit
+			uint32_t frameLimit = 0;
+			// headless only: where to write the last frame as binary PPM, empty - don`t write
+			std::string outputPath;
+			// GPU layout of loaded meshes
+			LveModel::VertexFormat vertexFormat = LveModel::VertexFormat::Compact;
+			// cull and select lods in a compute pass, draw indirect. Needs drawIndirectCount
+			bool gpuCulling = false;
+			// small lights scattered around the scene on top of the default ones, to stress the light clusters
+			uint32_t extraLights = 0;
+			// 0 - record draws on the main thread, otherwise split them into up to this many secondary
+			// command buffers recorded on the job system
+			uint32_t recordThreads = 0;
+		};
+
+		FirstApp(const Settings& settings);
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete;
@@ -28,15 +50,19 @@ namespace lve {
 	private:
 		void loadGameObjects();
 		void loadTextures();
-		
-		LveWindow lveWindow{ WIDTH, HEIGHT, "Vulkan V" };
-		LveDevice lveDevice{ lveWindow };
-		std::shared_ptr<LveRenderer> lveRenderer = std::make_shared<LveRenderer>(lveWindow, lveDevice);
-		LveTextureStorage lveTextureStorage{ lveDevice, lveRenderer };
+		void writeLastFrame();
+
+		Settings settings;
+
+		// null in headless mode
+		std::unique_ptr<LveWindow> lveWindow;
+		LveDevice lveDevice;
+		std::shared_ptr<LveRenderer> lveRenderer;
+		LveTextureStorage lveTextureStorage;
 
 		// note: order of declarations matters
 		std::unique_ptr<LveDescriptorPool> globalPool{};
 		std::unique_ptr<LveDescriptorPool> imGuiPool{};
-		LveGameObject::Map gameObjects;
+		LveRegistry registry;
 	};
 }
\ No newline at end of file
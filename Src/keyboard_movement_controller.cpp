@@ -2,7 +2,7 @@
 #include <limits>
 
 namespace lve {
-	void KeyboardMovementController::moveInPlaneXZ(GLFWwindow* window, float dt, LveGameObject& gameObject) {
+	void KeyboardMovementController::moveInPlaneXZ(GLFWwindow* window, float dt, TransformComponent& transform) {
 		
 		glm::vec3 rotate{ 0 };
 
@@ -12,14 +12,15 @@ namespace lve {
 		if (glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.f;
 
 		if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-			gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+			transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+			transform.dirty = true;
 		}
 		
 		//limit pith values between about +/- 85ish degrees
-		gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-		gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+		transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+		transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-		float yaw = gameObject.transform.rotation.y;
+		float yaw = transform.rotation.y;
 		const glm::vec3 forwardDir{ sin(yaw), 0.f, cos(yaw) };
 		const glm::vec3 rightDir{ forwardDir.z, 0.f, -forwardDir.x };
 		const glm::vec3 upDir{ 0.f, -1.f, 0.f };
@@ -33,7 +34,8 @@ namespace lve {
 		if (glfwGetKey(window, keys.moveDown) == GLFW_PRESS) moveDir -= upDir;
 
 		if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-			gameObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+			transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+			transform.dirty = true;
 		}
 	}
 }//namespace lve
\ No newline at end of file
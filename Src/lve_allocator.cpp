@@ -0,0 +1,326 @@
+#include "lve_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <Helpers/VulkanHelpers.hpp>
+
+namespace lve {
+
+	static constexpr VkDeviceSize LARGE_HEAP_BLOCK_SIZE = 64ull * 1024 * 1024;
+	static constexpr VkDeviceSize SMALL_HEAP_MAX_SIZE = 1024ull * 1024 * 1024;
+
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	LveAllocator::LveAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device{ device }
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+		pools.resize(memoryProperties.memoryTypeCount * 2);
+	}
+
+	LveAllocator::~LveAllocator()
+	{
+		assert(allocationCount == 0 && "Not all device memory allocations were freed");
+
+		for (auto& pool : pools)
+		{
+			for (auto& block : pool.blocks)
+			{
+				vkFreeMemory(device, block->memory, nullptr);
+			}
+		}
+	}
+
+	LveAllocation LveAllocator::allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+		return allocate(memRequirements, properties, true, false, VK_NULL_HANDLE);
+	}
+
+	LveAllocation LveAllocator::allocateForImage(VkImage image, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 memRequirements{};
+		memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		memRequirements.pNext = &dedicatedRequirements;
+
+		VkImageMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.image = image;
+
+		vkGetImageMemoryRequirements2(device, &requirementsInfo, &memRequirements);
+
+		auto& requirements = memRequirements.memoryRequirements;
+		auto memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+
+		//render targets and huge textures get their own memory, drivers can place them better
+		bool dedicated =
+			dedicatedRequirements.requiresDedicatedAllocation ||
+			requirements.size >= preferredBlockSize(memoryTypeIndex) / 4;
+
+		return allocate(requirements, properties, false, dedicated, image);
+	}
+
+	LveAllocation LveAllocator::allocate(
+		const VkMemoryRequirements& requirements,
+		VkMemoryPropertyFlags properties,
+		bool linear,
+		bool dedicated,
+		VkImage dedicatedImage
+	)
+	{
+		auto memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+		auto blockSize = preferredBlockSize(memoryTypeIndex);
+
+		if (dedicated || requirements.size > blockSize / 2)
+		{
+			return allocateDedicated(requirements, memoryTypeIndex, dedicated ? dedicatedImage : VK_NULL_HANDLE);
+		}
+
+		VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		VkDeviceSize size = requirements.size;
+		if (isHostVisible(memoryTypeIndex))
+		{
+			//keeps flush/invalidate ranges of neighbouring allocations apart
+			alignment = std::max(alignment, nonCoherentAtomSize);
+			size = alignUp(size, nonCoherentAtomSize);
+		}
+
+		auto poolIndex = memoryTypeIndex * 2 + (linear ? 0 : 1);
+
+		std::lock_guard lock{ mutex };
+		auto& pool = pools[poolIndex];
+
+		Block* target = nullptr;
+		uint64_t offset = 0;
+		uint32_t handle = LveRangeAllocator::INVALID_HANDLE;
+		for (auto& block : pool.blocks)
+		{
+			if (block->ranges.allocate(size, alignment, offset, handle))
+			{
+				target = block.get();
+				break;
+			}
+		}
+
+		if (target == nullptr)
+		{
+			auto block = std::make_unique<Block>(Block{
+				VK_NULL_HANDLE,
+				nullptr,
+				LveRangeAllocator{ blockSize },
+				poolIndex
+				});
+			block->memory = allocateMemory(blockSize, memoryTypeIndex, VK_NULL_HANDLE, &block->mapped);
+
+			bool allocated = block->ranges.allocate(size, alignment, offset, handle);
+			assert(allocated && "Fresh block must fit the allocation");
+			(void)allocated;
+
+			target = block.get();
+			pool.blocks.push_back(std::move(block));
+		}
+
+		liveBytes += size;
+		allocationCount++;
+
+		LveAllocation allocation{};
+		allocation.memory = target->memory;
+		allocation.offset = offset;
+		allocation.size = size;
+		allocation.mapped = target->mapped != nullptr ? static_cast<char*>(target->mapped) + offset : nullptr;
+		allocation.block = target;
+		allocation.handle = handle;
+		allocation.memorySize = blockSize;
+
+		return allocation;
+	}
+
+	LveAllocation LveAllocator::allocateDedicated(
+		const VkMemoryRequirements& requirements,
+		uint32_t memoryTypeIndex,
+		VkImage dedicatedImage
+	)
+	{
+		LveAllocation allocation{};
+		allocation.memory = allocateMemory(requirements.size, memoryTypeIndex, dedicatedImage, &allocation.mapped);
+		allocation.offset = 0;
+		allocation.size = requirements.size;
+		allocation.memorySize = requirements.size;
+
+		std::lock_guard lock{ mutex };
+		liveBytes += allocation.size;
+		dedicatedBytes += allocation.size;
+		dedicatedCount++;
+		allocationCount++;
+
+		return allocation;
+	}
+
+	void LveAllocator::free(const LveAllocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+			return;
+
+		std::lock_guard lock{ mutex };
+		liveBytes -= allocation.size;
+		allocationCount--;
+
+		if (allocation.block == nullptr)
+		{
+			dedicatedBytes -= allocation.size;
+			dedicatedCount--;
+			vkFreeMemory(device, allocation.memory, nullptr);
+			return;
+		}
+
+		auto block = static_cast<Block*>(allocation.block);
+		block->ranges.free(allocation.handle);
+		if (!block->ranges.isEmpty())
+			return;
+
+		if (auto retired = retireEmptyBlock(pools[block->poolIndex].blocks, block))
+		{
+			vkFreeMemory(device, retired->memory, nullptr);
+		}
+	}
+
+	VkMappedMemoryRange LveAllocator::mappedRange(
+		const LveAllocation& allocation,
+		VkDeviceSize size,
+		VkDeviceSize offset
+	) const
+	{
+		VkDeviceSize begin = allocation.offset + offset;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+		VkMappedMemoryRange mappedRange = {};
+		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		mappedRange.memory = allocation.memory;
+		mappedRange.offset = begin - begin % nonCoherentAtomSize;
+
+		VkDeviceSize alignedEnd = alignUp(end, nonCoherentAtomSize);
+		mappedRange.size = alignedEnd >= allocation.memorySize ? VK_WHOLE_SIZE : alignedEnd - mappedRange.offset;
+
+		return mappedRange;
+	}
+
+	LveAllocator::Stats LveAllocator::getStats()
+	{
+		std::lock_guard lock{ mutex };
+
+		Stats stats{};
+		stats.liveBytes = liveBytes;
+		stats.reservedBytes = dedicatedBytes;
+		stats.dedicatedCount = dedicatedCount;
+		stats.allocationCount = allocationCount;
+
+		VkDeviceSize freeBytes = 0;
+		VkDeviceSize largestFree = 0;
+		for (auto& pool : pools)
+		{
+			for (auto& block : pool.blocks)
+			{
+				stats.blockCount++;
+				stats.reservedBytes += block->ranges.getSize();
+				freeBytes += block->ranges.getFreeSize();
+				largestFree = std::max(largestFree, block->ranges.getLargestFreeRange());
+			}
+		}
+
+		if (freeBytes != 0)
+		{
+			stats.fragmentation = 1.f - static_cast<float>(largestFree) / static_cast<float>(freeBytes);
+		}
+
+		return stats;
+	}
+
+	VkDeviceMemory LveAllocator::allocateMemory(
+		VkDeviceSize size,
+		uint32_t memoryTypeIndex,
+		VkImage dedicatedImage,
+		void** mapped
+	)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+		if (dedicatedImage != VK_NULL_HANDLE)
+		{
+			dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+			dedicatedInfo.image = dedicatedImage;
+			allocInfo.pNext = &dedicatedInfo;
+		}
+
+		VkDeviceMemory memory;
+		auto result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate device memory!" + VulkanHelpers::AsString(result));
+		}
+
+		*mapped = nullptr;
+		if (isHostVisible(memoryTypeIndex))
+		{
+			result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+			if (result != VK_SUCCESS)
+			{
+				vkFreeMemory(device, memory, nullptr);
+				throw std::runtime_error("failed to map device memory!" + VulkanHelpers::AsString(result));
+			}
+		}
+
+		return memory;
+	}
+
+	uint32_t LveAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) &&
+				(memoryProperties.memoryTypes[i].propertyFlags & properties) == properties
+				)
+			{
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	VkDeviceSize LveAllocator::preferredBlockSize(uint32_t memoryTypeIndex) const
+	{
+		auto heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		auto heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+
+		if (heapSize <= SMALL_HEAP_MAX_SIZE)
+		{
+			return alignUp(heapSize / 8, 1024 * 1024);
+		}
+
+		return LARGE_HEAP_BLOCK_SIZE;
+	}
+
+	bool LveAllocator::isHostVisible(uint32_t memoryTypeIndex) const
+	{
+		return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	}
+
+}  // namespace lve
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "lve_range_allocator.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	// Piece of VkDeviceMemory handed out by LveAllocator
+	struct LveAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		// host visible memory stays mapped for its whole lifetime, points at offset
+		void* mapped = nullptr;
+
+	private:
+		friend class LveAllocator;
+
+		void* block = nullptr; //null for dedicated allocations
+		uint32_t handle = LveRangeAllocator::INVALID_HANDLE;
+		VkDeviceSize memorySize = 0;
+	};
+
+	// Device memory sub-allocator. Keeps large blocks per memory type and carves resources
+	// out of them with LveRangeAllocator, so vkAllocateMemory runs once per block instead of
+	// once per resource. Only big images get dedicated allocations.
+	class LveAllocator {
+	public:
+		struct Stats
+		{
+			// bytes handed out to live allocations
+			VkDeviceSize liveBytes = 0;
+			// bytes allocated from Vulkan, blocks and dedicated allocations
+			VkDeviceSize reservedBytes = 0;
+			uint32_t blockCount = 0;
+			uint32_t dedicatedCount = 0;
+			uint32_t allocationCount = 0;
+			// 1 - largest free range / free bytes, over all blocks. 0 when free space is contiguous
+			float fragmentation = 0.f;
+		};
+
+		LveAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+		~LveAllocator();
+
+		LveAllocator(const LveAllocator&) = delete;
+		LveAllocator& operator=(const LveAllocator&) = delete;
+
+		LveAllocation allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+		LveAllocation allocateForImage(VkImage image, VkMemoryPropertyFlags properties);
+		void free(const LveAllocation& allocation);
+
+		// range for vkFlushMappedMemoryRanges/vkInvalidateMappedMemoryRanges, relative to allocation offset
+		VkMappedMemoryRange mappedRange(const LveAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+		Stats getStats();
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory;
+			void* mapped;
+			LveRangeAllocator ranges;
+			uint32_t poolIndex;
+		};
+
+		// linear (buffers) and optimal (images) resources live in separate pools,
+		// that way bufferImageGranularity never has to be considered
+		struct Pool
+		{
+			std::vector<std::unique_ptr<Block>> blocks;
+		};
+
+		LveAllocation allocate(
+			const VkMemoryRequirements& requirements,
+			VkMemoryPropertyFlags properties,
+			bool linear,
+			bool dedicated,
+			VkImage dedicatedImage
+		);
+		LveAllocation allocateDedicated(
+			const VkMemoryRequirements& requirements,
+			uint32_t memoryTypeIndex,
+			VkImage dedicatedImage
+		);
+		VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkImage dedicatedImage, void** mapped);
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		VkDeviceSize preferredBlockSize(uint32_t memoryTypeIndex) const;
+		bool isHostVisible(uint32_t memoryTypeIndex) const;
+
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize nonCoherentAtomSize;
+
+		std::vector<Pool> pools;
+		std::mutex mutex;
+
+		VkDeviceSize liveBytes = 0;
+		VkDeviceSize dedicatedBytes = 0;
+		uint32_t dedicatedCount = 0;
+		uint32_t allocationCount = 0;
+	};
+
+}  // namespace lve
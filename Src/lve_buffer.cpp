@@ -43,18 +43,21 @@ namespace lve {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     LveBuffer::~LveBuffer() {
         unmap();
         vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.getAllocator().free(allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note Host visible memory is persistently mapped by LveAllocator, this only hands out a pointer.
+     * The whole buffer stays reachable, size is only checked against the buffer
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -62,20 +65,24 @@ namespace lve {
      * @return VkResult of the buffer mapping call
      */
     VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.memory && "Called map on buffer before create");
+        assert((size == VK_WHOLE_SIZE ? offset <= bufferSize : offset + size <= bufferSize) && "Mapped range outside of buffer");
+        (void)size;
+        if (allocation.mapped == nullptr) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+
+        mapped = static_cast<char*>(allocation.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The memory block stays mapped, the allocator unmaps it together with the block
      */
     void LveBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(lveDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -112,11 +119,7 @@ namespace lve {
      * @return VkResult of the flush call
      */
     VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        auto mappedRange = lveDevice.getAllocator().mappedRange(allocation, size, offset);
         return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
@@ -132,11 +135,7 @@ namespace lve {
      * @return VkResult of the invalidate call
      */
     VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        auto mappedRange = lveDevice.getAllocator().mappedRange(allocation, size, offset);
         return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
@@ -46,7 +46,7 @@ namespace lve {
         LveDevice& lveDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        LveAllocation allocation;
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
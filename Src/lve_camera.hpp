@@ -23,10 +23,17 @@ namespace lve {
 		const glm::mat4& getView() const { return viewMatrix; }
 		const glm::mat4& getInverseView() const { return inverseViewMatrix; }
 		const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); };
+		// planes of the last projection set
+		float getNear() const { return nearPlane; }
+		float getFar() const { return farPlane; }
+		bool isPerspective() const { return perspective; }
 
 	private:
 		glm::mat4 projectionMatrix{ 1.f };
 		glm::mat4 viewMatrix{ 1.f };
 		glm::mat4 inverseViewMatrix{ 1.f };
+		float nearPlane = 0.f;
+		float farPlane = 1.f;
+		bool perspective = false;
 	};
 }//namespace lve
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "lve_depth_sorter.hpp"
+
+namespace lve {
+
+	void LveDepthSorter::clear()
+	{
+		positionX.clear();
+		positionY.clear();
+		positionZ.clear();
+	}
+
+	void LveDepthSorter::push(const glm::vec3& position)
+	{
+		positionX.push_back(position.x);
+		positionY.push_back(position.y);
+		positionZ.push_back(position.z);
+	}
+
+	void LveDepthSorter::sortBackToFront(const glm::mat4& view)
+	{
+		auto count = size();
+		depths.resize(count);
+		entries.resize(count);
+		order.resize(count);
+
+		// view space z is the third row of the view matrix, the loop is plain enough for the compiler to vectorize
+		const float rowX = view[0][2];
+		const float rowY = view[1][2];
+		const float rowZ = view[2][2];
+		const float rowW = view[3][2];
+		const float* x = positionX.data();
+		const float* y = positionY.data();
+		const float* z = positionZ.data();
+		float* depth = depths.data();
+		for (size_t i = 0; i < count; i++)
+		{
+			depth[i] = rowX * x[i] + rowY * y[i] + rowZ * z[i] + rowW;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			// inverted key: ascending keys are descending depths
+			entries[i] = { ~RadixSort::FloatKey(depth[i]), static_cast<uint32_t>(i) };
+		}
+		RadixSort::Sort(entries, sortScratch);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			order[i] = entries[i].value;
+		}
+	}
+}
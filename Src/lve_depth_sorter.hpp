@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Helpers/RadixSort.hpp"
+
+//libs
+#define GLM_FORCE_RADIANSE
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Back to front order for blended draws. Render systems push one position per draw,
+	// sortBackToFront computes all view depths in one pass over the positions (kept as structure of arrays)
+	// and radix sorts them as 32 bit float keys. The sort is stable, draws at the same depth keep their push order.
+	// All storage is reused between frames, once it reached the peak draw count a frame allocates nothing.
+	class LveDepthSorter
+	{
+	public:
+		LveDepthSorter() = default;
+
+		LveDepthSorter(const LveDepthSorter&) = delete;
+		void operator=(const LveDepthSorter&) = delete;
+
+		void clear();
+		/// <summary>
+		/// Add a draw, its index is the number of draws pushed before it
+		/// </summary>
+		/// <param name="position">world space, usually the center of the draw</param>
+		void push(const glm::vec3& position);
+		size_t size() const { return positionX.size(); }
+
+		/// <summary>
+		/// Order the pushed draws by descending view depth
+		/// </summary>
+		void sortBackToFront(const glm::mat4& view);
+		// after sortBackToFront: draw indices, farthest first
+		const std::vector<uint32_t>& getOrder() const { return order; }
+
+	private:
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> depths;
+		std::vector<RadixSort::Entry32> entries;
+		std::vector<RadixSort::Entry32> sortScratch;
+		std::vector<uint32_t> order;
+	};
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "lve_device.hpp"
+#include "lve_uploader.hpp"
+#include "lve_geometry_arena.hpp"
 
 // std headers
 #include <cstring>
@@ -51,19 +53,30 @@ namespace lve {
     }
 
     // class member functions
-    LveDevice::LveDevice(LveWindow& window) : window{ window }
+    LveDevice::LveDevice(LveWindow* window) : window{ window }
     {
+        if (isHeadless())
+        {
+            deviceExtensions.clear();
+        }
+
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        allocator = std::make_unique<LveAllocator>(device_, physicalDevice);
         createCommandPool();
+        uploader = std::make_unique<LveUploader>(*this);
+        geometryArena = std::make_unique<LveGeometryArena>(*this);
     }
 
     LveDevice::~LveDevice()
     {
+        geometryArena.reset();
+        uploader.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
+        allocator.reset();
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers)
@@ -71,7 +84,10 @@ namespace lve {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -155,7 +171,7 @@ namespace lve {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily, indices.transferFamily };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -168,16 +184,38 @@ namespace lve {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
-        VkPhysicalDeviceFeatures deviceFeatures = {};
-        deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // optional features of GPU driven rendering, devices without them keep drawing from the CPU
+        VkPhysicalDeviceVulkan12Features supportedFeatures12 = {};
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures = {};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &supportedFeatures12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+        indirectCountEnabled =
+            supportedFeatures12.drawIndirectCount &&
+            supportedFeatures.features.multiDrawIndirect &&
+            supportedFeatures.features.drawIndirectFirstInstance;
+
+        VkPhysicalDeviceVulkan12Features deviceFeatures12 = {};
+        deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        deviceFeatures12.drawIndirectCount = indirectCountEnabled ? VK_TRUE : VK_FALSE;
+
+        VkPhysicalDeviceFeatures2 deviceFeatures = {};
+        deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures.pNext = &deviceFeatures12;
+        deviceFeatures.features.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.features.multiDrawIndirect = indirectCountEnabled ? VK_TRUE : VK_FALSE;
+        deviceFeatures.features.drawIndirectFirstInstance = indirectCountEnabled ? VK_TRUE : VK_FALSE;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        // features through pNext, pEnabledFeatures stays null
+        createInfo.pNext = &deviceFeatures;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-        createInfo.pEnabledFeatures = &deviceFeatures;
         createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
         createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -201,6 +239,7 @@ namespace lve {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
     }
 
     void LveDevice::createCommandPool()
@@ -222,7 +261,12 @@ namespace lve {
 
     void LveDevice::createSurface()
     {
-        window.createWindowSurface(instance, &surface_);
+        if (isHeadless())
+        {
+            return;
+        }
+
+        window->createWindowSurface(instance, &surface_);
     }
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device)
@@ -231,8 +275,8 @@ namespace lve {
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported)
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless())
         {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -311,11 +355,14 @@ namespace lve {
 
     std::vector<const char*> LveDevice::getRequiredExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char*> extensions;
+        if (!isHeadless())
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers)
         {
@@ -385,7 +432,7 @@ namespace lve {
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-        int i = 0;
+        uint32_t i = 0;
         for (const auto& queueFamily : queueFamilies)
         {
             if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
@@ -394,8 +441,16 @@ namespace lve {
                 indices.graphicsFamilyHasValue = true;
             }
 
+            // headless has nothing to present to, the graphics queue stands in for the present queue
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless())
+            {
+                presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == i;
+            }
+            else
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport)
             {
                 indices.presentFamily = i;
@@ -410,6 +465,33 @@ namespace lve {
             i++;
         }
 
+        // prefer a transfer-only family (DMA engine), then any other non graphics family.
+        // Compute families support transfer implicitly
+        if (!indices.graphicsFamilyHasValue)
+        {
+            return indices;
+        }
+
+        indices.transferFamily = indices.graphicsFamily;
+        bool transferOnly = false;
+        for (uint32_t family = 0; family < queueFamilyCount; family++)
+        {
+            auto flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount == 0 ||
+                (flags & VK_QUEUE_GRAPHICS_BIT) ||
+                !(flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)))
+            {
+                continue;
+            }
+
+            bool isTransferOnly = (flags & VK_QUEUE_COMPUTE_BIT) == 0;
+            if (!indices.hasDedicatedTransfer() || (isTransferOnly && !transferOnly))
+            {
+                indices.transferFamily = family;
+                transferOnly = isTransferOnly;
+            }
+        }
+
         return indices;
     }
 
@@ -487,7 +569,7 @@ namespace lve {
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory)
+        LveAllocation& bufferAllocation)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -501,21 +583,13 @@ namespace lve {
             throw std::runtime_error("failed to create vertex buffer!" + VulkanHelpers::AsString(result));
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferAllocation = allocator->allocateForBuffer(buffer, properties);
 
-        result = vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory);
+        result = vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset);
         if (result != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to allocate vertex buffer memory!" + VulkanHelpers::AsString(result));
+            throw std::runtime_error("failed to bind buffer memory!" + VulkanHelpers::AsString(result));
         }
-
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
     }
 
     VkCommandBuffer LveDevice::beginSingleTimeCommands()
@@ -575,9 +649,23 @@ namespace lve {
     )
     {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        copyBufferToImage(commandBuffer, buffer, 0, image, width, height, layerCount, mipLevel);
+        endSingleTimeCommands(commandBuffer);
+    }
 
+    void LveDevice::copyBufferToImage(
+        VkCommandBuffer commandBuffer,
+        VkBuffer buffer,
+        VkDeviceSize bufferOffset,
+        VkImage image,
+        uint32_t width,
+        uint32_t height,
+        uint32_t layerCount,
+        uint32_t mipLevel
+    )
+    {
         VkBufferImageCopy region{};
-        region.bufferOffset = 0;
+        region.bufferOffset = bufferOffset;
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
 
@@ -597,15 +685,13 @@ namespace lve {
             1,
             &region
         );
-
-        endSingleTimeCommands(commandBuffer);
     }
 
     void LveDevice::createImageWithInfo(
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory
+        LveAllocation& imageAllocation
     )
     {
         auto result = vkCreateImage(device_, &imageInfo, nullptr, &image);
@@ -614,21 +700,9 @@ namespace lve {
             throw std::runtime_error("failed to create image!" + VulkanHelpers::AsString(result));
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(device_, image, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        imageAllocation = allocator->allocateForImage(image, properties);
 
-        result = vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory);
-        if (result != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate image memory!" + VulkanHelpers::AsString(result));
-        }
-
-        result = vkBindImageMemory(device_, image, imageMemory, 0);
+        result = vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset);
         if (result != VK_SUCCESS)
         {
             throw std::runtime_error("failed to bind image memory!");
@@ -668,7 +742,18 @@ namespace lve {
     )
     {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        transitionImageLayout(commandBuffer, image, oldLayout, newLayout, mipLevels);
+        endSingleTimeCommands(commandBuffer);
+    }
 
+    void LveDevice::transitionImageLayout(
+        VkCommandBuffer commandBuffer,
+        VkImage image,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout,
+        uint32_t mipLevels
+    )
+    {
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout = oldLayout;
@@ -718,11 +803,23 @@ namespace lve {
             1,
             &barrier
         );
+    }
 
+    void LveDevice::generateMipmaps(
+        VkImage image,
+        VkFormat imageFormat,
+        int32_t texWidth,
+        int32_t texHeight,
+        uint32_t mipLevels
+    )
+    {
+        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        generateMipmaps(commandBuffer, image, imageFormat, texWidth, texHeight, mipLevels);
         endSingleTimeCommands(commandBuffer);
     }
 
     void LveDevice::generateMipmaps(
+        VkCommandBuffer commandBuffer,
         VkImage image,
         VkFormat imageFormat,
         int32_t texWidth,
@@ -739,8 +836,6 @@ namespace lve {
             throw std::runtime_error("texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.image = image;
@@ -834,8 +929,6 @@ namespace lve {
             0, nullptr,
             1, &barrier
         );
-
-        endSingleTimeCommands(commandBuffer);
     }
 
 }  // namespace lve
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "lve_window.hpp"
+#include "lve_allocator.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,11 +19,17 @@ namespace lve {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // family of a transfer-only queue when the device has one, otherwise graphicsFamily
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool hasDedicatedTransfer() const { return transferFamily != graphicsFamily; }
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    class LveUploader;
+    class LveGeometryArena;
+
     class LveDevice {
     public:
 #ifdef NDEBUG
@@ -30,7 +38,8 @@ namespace lve {
         const bool enableValidationLayers = true;
 #endif
 
-        LveDevice(LveWindow& window);
+        // window == nullptr creates a headless device: no surface, no swapchain extension
+        LveDevice(LveWindow* window);
         ~LveDevice();
 
         // Not copyable or movable
@@ -46,6 +55,13 @@ namespace lve {
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        VkQueue transferQueue() { return transferQueue_; }
+        bool isHeadless() const { return window == nullptr; }
+        LveAllocator& getAllocator() { return *allocator; }
+        LveUploader& getUploader() { return *uploader; }
+        LveGeometryArena& getGeometryArena() { return *geometryArena; }
+        // drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance are enabled: GPU driven draws work
+        bool supportsIndirectCount() const { return indirectCountEnabled; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -59,7 +75,7 @@ namespace lve {
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            LveAllocation& bufferAllocation);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -75,11 +91,38 @@ namespace lve {
         void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
         void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
 
+        // Same helpers, recorded into a caller owned command buffer instead of a blocking single time submit
+        void copyBufferToImage(
+            VkCommandBuffer commandBuffer,
+            VkBuffer buffer,
+            VkDeviceSize bufferOffset,
+            VkImage image,
+            uint32_t width,
+            uint32_t height,
+            uint32_t layerCount,
+            uint32_t mipLevel
+        );
+        void transitionImageLayout(
+            VkCommandBuffer commandBuffer,
+            VkImage image,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout,
+            uint32_t mipLevels
+        );
+        void generateMipmaps(
+            VkCommandBuffer commandBuffer,
+            VkImage image,
+            VkFormat imageFormat,
+            int32_t texWidth,
+            int32_t texHeight,
+            uint32_t mipLevels
+        );
+
         void createImageWithInfo(
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory
+            LveAllocation& imageAllocation
         );
 
         void createImageView(
@@ -112,16 +155,21 @@ namespace lve {
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        LveWindow& window;
+        LveWindow* window;
         VkCommandPool commandPool;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        bool indirectCountEnabled = false;
+        VkQueue transferQueue_;
+        std::unique_ptr<LveAllocator> allocator;
+        std::unique_ptr<LveUploader> uploader;
+        std::unique_ptr<LveGeometryArena> geometryArena;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-        const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
     };
 
 }  // namespace lve
\ No newline at end of file
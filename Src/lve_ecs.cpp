@@ -0,0 +1,46 @@
+#include "lve_ecs.hpp"
+
+namespace lve {
+
+	LveEntity LveRegistry::create()
+	{
+		uint32_t index;
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(generations.size());
+			generations.push_back(0);
+		}
+
+		entityCount++;
+		return { index, ++generations[index] };
+	}
+
+	void LveRegistry::destroy(LveEntity entity)
+	{
+		if (!isAlive(entity))
+			return;
+
+		for (auto& pool : pools)
+		{
+			if (pool != nullptr)
+			{
+				pool->remove(entity);
+			}
+		}
+
+		// even again, handles of the old owner stop being alive
+		generations[entity.index]++;
+		freeSlots.push_back(entity.index);
+		entityCount--;
+	}
+
+	bool LveRegistry::isAlive(LveEntity entity) const
+	{
+		return entity.index < generations.size() && generations[entity.index] == entity.generation && (entity.generation & 1) != 0;
+	}
+}
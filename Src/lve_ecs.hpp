@@ -0,0 +1,225 @@
+#pragma once
+
+//std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+	// Handle of an entity in an LveRegistry. The index names a slot that is reused after the entity is destroyed,
+	// the generation tells the owners apart: a handle kept past destroy stops being alive instead of
+	// silently pointing at whatever entity took over its slot.
+	struct LveEntity
+	{
+		uint32_t index = 0;
+		// odd while alive, a default constructed entity (0) is null
+		uint32_t generation = 0;
+
+		bool isNull() const { return generation == 0; }
+		bool operator==(const LveEntity& other) const = default;
+	};
+
+	// Type erased part of a component pool, what destroying an entity needs without knowing its components
+	class LveComponentPoolBase
+	{
+	public:
+		virtual ~LveComponentPoolBase() = default;
+
+		size_t size() const { return entities.size(); }
+		// owners of the components, in the order of the dense component array
+		const std::vector<LveEntity>& getEntities() const { return entities; }
+
+		bool contains(LveEntity entity) const
+		{
+			return entity.index < sparse.size() && sparse[entity.index] != INVALID && entities[sparse[entity.index]] == entity;
+		}
+
+		virtual void remove(LveEntity entity) = 0;
+
+	protected:
+		static constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+		// entity index -> position in the dense arrays, INVALID - no component
+		std::vector<uint32_t> sparse;
+		std::vector<LveEntity> entities;
+	};
+
+	// Sparse set of one component type: components are packed into one array without holes, so a system that
+	// walks all of them scans memory linearly. Removing moves the last component into the hole,
+	// which invalidates references to that one; adding may reallocate and invalidates all of them.
+	template<typename T>
+	class LveComponentPool : public LveComponentPoolBase
+	{
+	public:
+		// dense, same order as getEntities()
+		std::vector<T>& getComponents() { return components; }
+		const std::vector<T>& getComponents() const { return components; }
+
+		T& add(LveEntity entity, T component)
+		{
+			assert(!contains(entity) && "entity already has the component");
+			if (entity.index >= sparse.size())
+			{
+				sparse.resize(static_cast<size_t>(entity.index) + 1, INVALID);
+			}
+			sparse[entity.index] = static_cast<uint32_t>(entities.size());
+			entities.push_back(entity);
+			return components.emplace_back(std::move(component));
+		}
+
+		T& get(LveEntity entity)
+		{
+			assert(contains(entity) && "entity doesn`t have the component");
+			return components[sparse[entity.index]];
+		}
+
+		T* tryGet(LveEntity entity)
+		{
+			return contains(entity) ? &components[sparse[entity.index]] : nullptr;
+		}
+
+		void remove(LveEntity entity) override
+		{
+			if (!contains(entity))
+				return;
+
+			auto position = sparse[entity.index];
+			auto last = static_cast<uint32_t>(entities.size() - 1);
+			if (position != last)
+			{
+				entities[position] = entities[last];
+				components[position] = std::move(components[last]);
+				sparse[entities[position].index] = position;
+			}
+			entities.pop_back();
+			components.pop_back();
+			sparse[entity.index] = INVALID;
+		}
+
+	private:
+		std::vector<T> components;
+	};
+
+	// Entity component store. Entities are generational handles, every component type lives in its own
+	// LveComponentPool (one contiguous array per type). Queries walk the smallest pool they need and skip
+	// entities that miss one of the other components, so systems never visit entities that aren`t theirs.
+	//
+	// Not thread safe. Components may be read and written from jobs while nothing adds or removes any.
+	class LveRegistry
+	{
+	public:
+		LveRegistry() = default;
+
+		LveRegistry(const LveRegistry&) = delete;
+		void operator=(const LveRegistry&) = delete;
+
+		LveEntity create();
+		/// <summary>
+		/// Remove all components of entity and retire its handle, the slot is reused by a later create
+		/// </summary>
+		void destroy(LveEntity entity);
+		bool isAlive(LveEntity entity) const;
+		uint32_t getEntityCount() const { return entityCount; }
+
+		template<typename T>
+		T& add(LveEntity entity, T component = {})
+		{
+			assert(isAlive(entity) && "entity is not alive");
+			return pool<T>().add(entity, std::move(component));
+		}
+
+		template<typename T>
+		void remove(LveEntity entity) { pool<T>().remove(entity); }
+
+		template<typename T>
+		bool has(LveEntity entity) { return pool<T>().contains(entity); }
+
+		template<typename T>
+		T& get(LveEntity entity) { return pool<T>().get(entity); }
+
+		/// <returns>null when entity doesn`t have the component</returns>
+		template<typename T>
+		T* tryGet(LveEntity entity) { return pool<T>().tryGet(entity); }
+
+		template<typename T>
+		LveComponentPool<T>& pool()
+		{
+			auto type = componentType<T>();
+			if (type >= pools.size())
+			{
+				pools.resize(static_cast<size_t>(type) + 1);
+			}
+			if (pools[type] == nullptr)
+			{
+				pools[type] = std::make_unique<LveComponentPool<T>>();
+			}
+			return static_cast<LveComponentPool<T>&>(*pools[type]);
+		}
+
+		/// <summary>
+		/// Call function(LveEntity, Components&...) for every entity that has all of Components.
+		/// function must not add or remove components of the queried types
+		/// </summary>
+		template<typename... Components, typename F>
+		void each(F&& function)
+		{
+			static_assert(sizeof...(Components) > 0, "query needs at least one component");
+			if constexpr (sizeof...(Components) == 1)
+			{
+				// a single pool has nothing to skip, straight walk over the dense arrays
+				auto& single = pool<Components...>();
+				auto& entities = single.getEntities();
+				auto& components = single.getComponents();
+				for (size_t i = 0; i < entities.size(); i++)
+				{
+					function(entities[i], components[i]);
+				}
+			}
+			else
+			{
+				auto required = std::make_tuple(&pool<Components>()...);
+				std::array<LveComponentPoolBase*, sizeof...(Components)> bases{ &pool<Components>()... };
+				auto smallest = *std::min_element(bases.begin(), bases.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+
+				auto& entities = smallest->getEntities();
+				for (size_t i = 0; i < entities.size(); i++)
+				{
+					auto entity = entities[i];
+					// one sparse lookup per pool, null where the entity misses the component
+					auto components = std::make_tuple(std::get<LveComponentPool<Components>*>(required)->tryGet(entity)...);
+					if (((std::get<Components*>(components) != nullptr) && ...))
+					{
+						function(entity, *std::get<Components*>(components)...);
+					}
+				}
+			}
+		}
+
+	private:
+		/// <summary>
+		/// Small dense number per component type, indexes pools
+		/// </summary>
+		template<typename T>
+		static uint32_t componentType()
+		{
+			static const uint32_t type = nextComponentType++;
+			return type;
+		}
+
+		static inline std::atomic<uint32_t> nextComponentType{ 0 };
+
+		std::vector<std::unique_ptr<LveComponentPoolBase>> pools;
+		// generation of every slot, odd while an entity uses it
+		std::vector<uint32_t> generations;
+		std::vector<uint32_t> freeSlots;
+		uint32_t entityCount = 0;
+	};
+}
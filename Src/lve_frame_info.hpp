@@ -8,11 +8,10 @@
 
 namespace lve {
 
-#define MAX_LIGHTS 10
-
+	// std430 element of the lights buffer, see LveLightClusters
 	struct PointLight
 	{
-		glm::vec4 position{};//ignore w
+		glm::vec4 position{};// w is the range, the light is cut off past it
 		glm::vec4 color{};// w is intensity
 	};
 
@@ -22,7 +21,10 @@ namespace lve {
 		glm::mat4 view{ 1.f };
 		glm::mat4 inverseView{ 1.f };
 		glm::vec4 ambientLightColor{ 1.f, 1.f , 1.f , .02f }; // w is intensity
-		PointLight pointLights[MAX_LIGHTS];
+		// light cluster grid size, w unused
+		glm::uvec4 clusterCount{};
+		// xy pixels per cluster tile, z and w scale and bias of the depth slice: log(viewZ) * z - w
+		glm::vec4 clusterParams{};
 		int numLights;
 	};
 
@@ -32,7 +34,8 @@ namespace lve {
 		VkCommandBuffer commandBuffer;
 		LveCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		LveGameObject::Map& gameObjects;
+		LveRegistry& registry;
+		VkExtent2D extent;
 	};
 
 }//namespace lve
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "lve_frustum.hpp"
+
+//std
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LVE_FRUSTUM_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LVE_FRUSTUM_SSE
+#endif
+
+namespace lve {
+
+#if defined(LVE_FRUSTUM_AVX)
+	const uint32_t LveFrustum::SIMD_WIDTH = 8;
+#elif defined(LVE_FRUSTUM_SSE)
+	const uint32_t LveFrustum::SIMD_WIDTH = 4;
+#else
+	const uint32_t LveFrustum::SIMD_WIDTH = 1;
+#endif
+
+	void LveAabbBatch::clear()
+	{
+		centerX.clear();
+		centerY.clear();
+		centerZ.clear();
+		extentX.clear();
+		extentY.clear();
+		extentZ.clear();
+	}
+
+	void LveAabbBatch::push(const glm::vec3& center, const glm::vec3& extent)
+	{
+		centerX.push_back(center.x);
+		centerY.push_back(center.y);
+		centerZ.push_back(center.z);
+		extentX.push_back(extent.x);
+		extentY.push_back(extent.y);
+		extentZ.push_back(extent.z);
+	}
+
+	LveFrustum LveFrustum::fromMatrix(const glm::mat4& matrix)
+	{
+		auto row = [&matrix](int i) { return glm::vec4{ matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i] }; };
+
+		LveFrustum frustum;
+		frustum.planes[Left] = row(3) + row(0);
+		frustum.planes[Right] = row(3) - row(0);
+		frustum.planes[Bottom] = row(3) + row(1);
+		frustum.planes[Top] = row(3) - row(1);
+		frustum.planes[Near] = row(2);
+		frustum.planes[Far] = row(3) - row(2);
+
+		for (auto& plane : frustum.planes)
+		{
+			float length = glm::length(glm::vec3(plane));
+			if (length > 0.f)
+			{
+				plane /= length;
+			}
+		}
+		return frustum;
+	}
+
+	bool LveFrustum::intersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const auto& plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	bool LveFrustum::intersectsAabb(const glm::vec3& center, const glm::vec3& extent) const
+	{
+		// the box is outside when even its corner furthest along the plane normal is behind the plane
+		for (const auto& plane : planes)
+		{
+			auto normal = glm::vec3(plane);
+			if (glm::dot(normal, center) + plane.w < -glm::dot(glm::abs(normal), extent))
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t LveFrustum::cullAabbs(const LveAabbBatch& boxes, std::vector<uint8_t>& visible) const
+	{
+		auto count = boxes.size();
+		visible.resize(count);
+		uint32_t visibleCount = 0;
+		size_t i = 0;
+
+#if defined(LVE_FRUSTUM_AVX)
+		__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+		for (size_t p = 0; p < planes.size(); p++)
+		{
+			planeX[p] = _mm256_set1_ps(planes[p].x);
+			planeY[p] = _mm256_set1_ps(planes[p].y);
+			planeZ[p] = _mm256_set1_ps(planes[p].z);
+			planeW[p] = _mm256_set1_ps(planes[p].w);
+			absX[p] = _mm256_set1_ps(std::abs(planes[p].x));
+			absY[p] = _mm256_set1_ps(std::abs(planes[p].y));
+			absZ[p] = _mm256_set1_ps(std::abs(planes[p].z));
+		}
+
+		for (; i + 8 <= count; i += 8)
+		{
+			auto cx = _mm256_loadu_ps(boxes.centerX.data() + i);
+			auto cy = _mm256_loadu_ps(boxes.centerY.data() + i);
+			auto cz = _mm256_loadu_ps(boxes.centerZ.data() + i);
+			auto ex = _mm256_loadu_ps(boxes.extentX.data() + i);
+			auto ey = _mm256_loadu_ps(boxes.extentY.data() + i);
+			auto ez = _mm256_loadu_ps(boxes.extentZ.data() + i);
+
+			auto outside = _mm256_setzero_ps();
+			for (size_t p = 0; p < planes.size(); p++)
+			{
+				auto distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(cx, planeX[p]), _mm256_mul_ps(cy, planeY[p])),
+					_mm256_add_ps(_mm256_mul_ps(cz, planeZ[p]), planeW[p]));
+				auto radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(ex, absX[p]), _mm256_mul_ps(ey, absY[p])),
+					_mm256_mul_ps(ez, absZ[p]));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(outside);
+			for (size_t lane = 0; lane < 8; lane++)
+			{
+				visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+				visibleCount += visible[i + lane];
+			}
+		}
+#elif defined(LVE_FRUSTUM_SSE)
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+		for (size_t p = 0; p < planes.size(); p++)
+		{
+			planeX[p] = _mm_set1_ps(planes[p].x);
+			planeY[p] = _mm_set1_ps(planes[p].y);
+			planeZ[p] = _mm_set1_ps(planes[p].z);
+			planeW[p] = _mm_set1_ps(planes[p].w);
+			absX[p] = _mm_set1_ps(std::abs(planes[p].x));
+			absY[p] = _mm_set1_ps(std::abs(planes[p].y));
+			absZ[p] = _mm_set1_ps(std::abs(planes[p].z));
+		}
+
+		for (; i + 4 <= count; i += 4)
+		{
+			auto cx = _mm_loadu_ps(boxes.centerX.data() + i);
+			auto cy = _mm_loadu_ps(boxes.centerY.data() + i);
+			auto cz = _mm_loadu_ps(boxes.centerZ.data() + i);
+			auto ex = _mm_loadu_ps(boxes.extentX.data() + i);
+			auto ey = _mm_loadu_ps(boxes.extentY.data() + i);
+			auto ez = _mm_loadu_ps(boxes.extentZ.data() + i);
+
+			auto outside = _mm_setzero_ps();
+			for (size_t p = 0; p < planes.size(); p++)
+			{
+				auto distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(cx, planeX[p]), _mm_mul_ps(cy, planeY[p])),
+					_mm_add_ps(_mm_mul_ps(cz, planeZ[p]), planeW[p]));
+				auto radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(ex, absX[p]), _mm_mul_ps(ey, absY[p])),
+					_mm_mul_ps(ez, absZ[p]));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			int mask = _mm_movemask_ps(outside);
+			for (size_t lane = 0; lane < 4; lane++)
+			{
+				visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+				visibleCount += visible[i + lane];
+			}
+		}
+#endif
+
+		// remainder that doesn`t fill a SIMD pass
+		for (; i < count; i++)
+		{
+			visible[i] = intersectsAabb(
+				{ boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i] },
+				{ boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i] }
+			) ? 1 : 0;
+			visibleCount += visible[i];
+		}
+
+		return visibleCount;
+	}
+
+}//namespace lve
@@ -0,0 +1,54 @@
+#pragma once
+
+//libs
+#define GLM_FORCE_RADIANSE
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Axis aligned boxes as center and half extent, structure of arrays so SIMD loads 4 or 8 boxes at once
+	struct LveAabbBatch
+	{
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ;
+
+		size_t size() const { return centerX.size(); }
+		void clear();
+		void push(const glm::vec3& center, const glm::vec3& extent);
+	};
+
+	// Six clip planes in the space of the matrix they were extracted from, normals point inside
+	struct LveFrustum
+	{
+		enum Plane { Left = 0, Right, Bottom, Top, Near, Far };
+
+		// boxes tested per cullAabbs pass: 8 with AVX, 4 with SSE2, 1 without SIMD
+		static const uint32_t SIMD_WIDTH;
+
+		// xyz is the unit normal, w the distance
+		std::array<glm::vec4, 6> planes{};
+
+		/// <summary>
+		/// Planes of the clip volume of matrix (Gribb/Hartmann), with depth 0..1.
+		/// Pass projection * view for world space planes, projection * view * model for object space ones
+		/// </summary>
+		static LveFrustum fromMatrix(const glm::mat4& matrix);
+
+		bool intersectsSphere(const glm::vec3& center, float radius) const;
+		bool intersectsAabb(const glm::vec3& center, const glm::vec3& extent) const;
+
+		/// <summary>
+		/// intersectsAabb for every box of the batch, SIMD_WIDTH boxes per pass
+		/// </summary>
+		/// <param name="visible">resized to boxes.size(), 1 if the box intersects the frustum</param>
+		/// <returns>visible boxes</returns>
+		uint32_t cullAabbs(const LveAabbBatch& boxes, std::vector<uint8_t>& visible) const;
+	};
+
+}//namespace lve
@@ -58,14 +58,14 @@ namespace lve {
 			}};
 	}
 
-	LveGameObject LveGameObject::makePointLight(float intensity, float radius, glm::vec3 color) {
-		LveGameObject gameObj = LveGameObject::createGameObject();
-		gameObj.color = color;
-		gameObj.transform.scale.x = radius;
-		gameObj.pointLight = std::make_unique<PointLightComponent>();
-		gameObj.pointLight->lightIntensity = intensity;
+	LveEntity makePointLight(LveRegistry& registry, float intensity, float radius, glm::vec3 color) {
+		auto entity = registry.create();
+		auto& transform = registry.add<TransformComponent>(entity);
+		transform.scale.x = radius;
+		registry.add<WorldTransformComponent>(entity);
+		registry.add<PointLightComponent>(entity, { color, intensity });
 
-		return gameObj;
+		return entity;
 	};
 
 }//namespace lve
\ No newline at end of file
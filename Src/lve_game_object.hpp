@@ -1,19 +1,21 @@
 #pragma once
 
+#include "lve_ecs.hpp"
 #include "lve_model.hpp"
 
 //libs
 #include <glm/gtc/matrix_transform.hpp>
 //std
 #include <memory>
-#include <unordered_map>
 
 namespace lve {
 
 	struct TransformComponent {
 		glm::vec3 translation{};// (position offset)
 		glm::vec3 scale{ 1.f, 1.f, 1.f };
-		glm::vec3 rotation;
+		glm::vec3 rotation{};
+		// set after changing any of the above, TransformSystem clears it once it recomputed the matrices
+		bool dirty = true;
 
 		// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
 		// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
@@ -22,43 +24,30 @@ namespace lve {
 		glm::mat3 normalMatrix();
 	};
 
-	struct PointLightComponent
+	// matrices of the TransformComponent of the same entity, cached by TransformSystem
+	struct WorldTransformComponent
 	{
-		float lightIntensity = 1.0f;
+		glm::mat4 world{ 1.f };
+		glm::mat3 normal{ 1.f };
 	};
 
-	class LveGameObject
+	// drawn by SimpleRenderSystem, needs a WorldTransformComponent
+	struct ModelComponent
 	{
-	public:
-		using id_t = unsigned int;
-		using Map = std::unordered_map<id_t, LveGameObject>;
-
-		static LveGameObject createGameObject() {
-			static id_t currentId = 0;
-			return LveGameObject{ currentId++ };
-		}
-
-		static LveGameObject makePointLight(
-			float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f)
-		);
-
-		LveGameObject(const LveGameObject&) = delete;
-		LveGameObject &operator=(const LveGameObject&) = delete;
-		LveGameObject(LveGameObject&&) = default;
-		LveGameObject &operator=(LveGameObject&&) = default;
-
-		const id_t getId() { return id; }
-
-		glm::vec3 color{};
-		TransformComponent transform{};
-
-		//optional pointer components
 		std::shared_ptr<LveModel> model{};
-		std::unique_ptr<PointLightComponent> pointLight = nullptr;
-
-	private:
-		LveGameObject(id_t objId) :id{ objId } {}
+		// level of detail of model drawn last frame, the next one is picked relative to it
+		uint32_t lod = 0;
+	};
 
-		id_t id;
+	// lit and drawn by PointLightSystem at the position of its WorldTransformComponent
+	struct PointLightComponent
+	{
+		glm::vec3 color{ 1.f };
+		float lightIntensity = 1.0f;
 	};
+
+	/// <summary>
+	/// Entity with the transforms and light of a point light, the billboard radius is the x scale
+	/// </summary>
+	LveEntity makePointLight(LveRegistry& registry, float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "lve_geometry_arena.hpp"
+#include "lve_device.hpp"
+#include "lve_uploader.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace lve {
+
+	LveGeometryArena::LveGeometryArena(LveDevice& device) : lveDevice{ device }
+	{
+	}
+
+	LveGeometryArena::~LveGeometryArena()
+	{
+		assert(rangeCount == 0 && "geometry ranges outlive the arena");
+	}
+
+	LveGeometryRange LveGeometryArena::allocate(Usage usage, uint32_t elementSize, uint32_t count, const void* data)
+	{
+		assert(elementSize > 0 && count > 0 && "empty geometry range");
+
+		std::unique_lock lock{ mutex };
+
+		auto poolIt = std::find_if(pools.begin(), pools.end(), [&](const Pool& pool) {
+			return pool.usage == usage && pool.elementSize == elementSize;
+			});
+		if (poolIt == pools.end())
+		{
+			pools.push_back(Pool{ usage, elementSize, {} });
+			poolIt = pools.end() - 1;
+		}
+		auto& pool = *poolIt;
+		auto poolIndex = static_cast<uint32_t>(poolIt - pools.begin());
+
+		Block* target = nullptr;
+		uint64_t first = 0;
+		uint32_t handle = LveRangeAllocator::INVALID_HANDLE;
+		for (auto& block : pool.blocks)
+		{
+			if (block->ranges.allocate(count, 1, first, handle))
+			{
+				target = block.get();
+				break;
+			}
+		}
+
+		if (target == nullptr)
+		{
+			auto capacity = std::max<uint64_t>(BLOCK_SIZE / elementSize, count);
+			auto block = std::make_unique<Block>(Block{
+				std::make_unique<LveBuffer>(
+					lveDevice,
+					elementSize,
+					static_cast<uint32_t>(capacity),
+					(usage == Usage::Vertex ? VK_BUFFER_USAGE_VERTEX_BUFFER_BIT : VK_BUFFER_USAGE_INDEX_BUFFER_BIT) | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+					),
+				LveRangeAllocator{ capacity },
+				poolIndex
+				});
+
+			bool allocated = block->ranges.allocate(count, 1, first, handle);
+			assert(allocated && "Block capacity covers count elements, nothing else is allocated in it yet");
+			(void)allocated;
+
+			target = block.get();
+			pool.blocks.push_back(std::move(block));
+		}
+
+		liveBytes += VkDeviceSize{ elementSize } * count;
+		rangeCount++;
+
+		LveGeometryRange range{};
+		range.buffer = target->buffer->getBuffer();
+		range.first = static_cast<uint32_t>(first);
+		range.count = count;
+		range.block = target;
+		range.handle = handle;
+		lock.unlock();
+
+		lveDevice.getUploader().uploadBuffer(
+			data,
+			VkDeviceSize{ elementSize } * count,
+			range.buffer,
+			VkDeviceSize{ elementSize } * range.first,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			usage == Usage::Vertex ? VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT : VK_ACCESS_INDEX_READ_BIT
+		);
+
+		return range;
+	}
+
+	void LveGeometryArena::free(const LveGeometryRange& range)
+	{
+		if (range.block == nullptr)
+			return;
+
+		std::lock_guard lock{ mutex };
+		auto block = static_cast<Block*>(range.block);
+		auto& pool = pools[block->poolIndex];
+		liveBytes -= VkDeviceSize{ pool.elementSize } * range.count;
+		rangeCount--;
+
+		block->ranges.free(range.handle);
+		if (block->ranges.isEmpty())
+		{
+			// the retired block destroys its buffer
+			retireEmptyBlock(pool.blocks, block);
+		}
+	}
+
+	LveGeometryArena::Stats LveGeometryArena::getStats()
+	{
+		std::lock_guard lock{ mutex };
+
+		Stats stats{};
+		stats.liveBytes = liveBytes;
+		stats.rangeCount = rangeCount;
+		for (const auto& pool : pools)
+		{
+			for (const auto& block : pool.blocks)
+			{
+				stats.reservedBytes += block->buffer->getBufferSize();
+				stats.bufferCount++;
+			}
+		}
+		return stats;
+	}
+
+}  // namespace lve
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_range_allocator.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	class LveDevice;
+
+	// Range of a geometry arena buffer handed out by LveGeometryArena, in elements of its pool
+	struct LveGeometryRange
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		// element index of the range in buffer: a base vertex or a first index
+		uint32_t first = 0;
+		uint32_t count = 0;
+
+	private:
+		friend class LveGeometryArena;
+
+		void* block = nullptr;
+		uint32_t handle = LveRangeAllocator::INVALID_HANDLE;
+	};
+
+	// Vertex and index data of all models in a few large device local buffers.
+	// Every element size (vertex stride or index size) has its own pool of buffers, ranges are
+	// carved out of them with LveRangeAllocator in units of elements, so a range start is directly
+	// usable as vertexOffset or firstIndex and models of one pool draw without rebinding buffers.
+	// Freed ranges merge with their free neighbours and are reused by later models.
+	class LveGeometryArena {
+	public:
+		// bytes of a pool buffer, ranges that don`t fit get a buffer of their own size
+		static constexpr VkDeviceSize BLOCK_SIZE = 32 * 1024 * 1024;
+
+		enum class Usage
+		{
+			Vertex,
+			Index
+		};
+
+		struct Stats
+		{
+			// bytes of live ranges
+			VkDeviceSize liveBytes = 0;
+			// bytes of all pool buffers
+			VkDeviceSize reservedBytes = 0;
+			uint32_t bufferCount = 0;
+			uint32_t rangeCount = 0;
+		};
+
+		LveGeometryArena(LveDevice& device);
+		~LveGeometryArena();
+
+		LveGeometryArena(const LveGeometryArena&) = delete;
+		LveGeometryArena& operator=(const LveGeometryArena&) = delete;
+
+		/// <summary>
+		/// Reserve count elements in the pool of usage and elementSize and upload data into them through LveUploader
+		/// </summary>
+		LveGeometryRange allocate(Usage usage, uint32_t elementSize, uint32_t count, const void* data);
+		/// <summary>
+		/// Give the range back for reuse. The GPU has to be done with it, like with a destroyed buffer
+		/// </summary>
+		void free(const LveGeometryRange& range);
+
+		Stats getStats();
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<LveBuffer> buffer;
+			LveRangeAllocator ranges;
+			uint32_t poolIndex;
+		};
+
+		struct Pool
+		{
+			Usage usage;
+			uint32_t elementSize;
+			std::vector<std::unique_ptr<Block>> blocks;
+		};
+
+		LveDevice& lveDevice;
+		std::vector<Pool> pools;
+		std::mutex mutex;
+
+		VkDeviceSize liveBytes = 0;
+		uint32_t rangeCount = 0;
+	};
+
+}  // namespace lve
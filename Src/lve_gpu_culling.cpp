@@ -0,0 +1,432 @@
+#include "lve_gpu_culling.hpp"
+#include "lve_frustum.hpp"
+
+#include <Helpers/VulkanHelpers.hpp>
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	static_assert(sizeof(LveGpuCulling::GpuObject) == 80, "GpuObject has to match Object of indirect_cull.comp");
+	static_assert(sizeof(LveGpuCulling::GpuMesh) == 96, "GpuMesh has to match Mesh of indirect_cull.comp");
+	static_assert(sizeof(LveGpuCulling::CullPushConstants) <= 128, "push constants above the guaranteed minimum");
+
+	namespace {
+
+		constexpr uint32_t BINDING_COUNT = 8;
+
+		uint32_t roundUpPowerOfTwo(uint32_t value, uint32_t minimum)
+		{
+			uint32_t result = minimum;
+			while (result < value)
+			{
+				result *= 2;
+			}
+			return result;
+		}
+
+	}//namespace
+
+	LveGpuCulling::LveGpuCulling(LveDevice& device, float lodPixelError, float lodHysteresis)
+		: lveDevice{ device }, lodPixelError{ lodPixelError }, lodHysteresis{ lodHysteresis }
+	{
+		assert(lveDevice.supportsIndirectCount() && "GPU culling needs drawIndirectCount");
+
+		auto layoutBuilder = LveDescriptorSetLayout::Builder(lveDevice);
+		for (uint32_t binding = 0; binding < BINDING_COUNT; binding++)
+		{
+			layoutBuilder.addBinding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+		}
+		setLayout = layoutBuilder.build();
+
+		descriptorPool = LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BINDING_COUNT * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+
+		createPipeline();
+	}
+
+	LveGpuCulling::~LveGpuCulling()
+	{
+		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+	}
+
+	void LveGpuCulling::createPipeline()
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPushConstants);
+
+		VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		auto vkResult = vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create culling pipeline layout!" + VulkanHelpers::AsString(vkResult));
+		}
+
+		pipeline = std::make_unique<LvePipeline>(lveDevice, "shaders/indirect_cull.comp.spv", pipelineLayout);
+	}
+
+	void LveGpuCulling::cull(FrameInfo& frameInfo)
+	{
+		objects.clear();
+		std::fill(meshObjectCounts.begin(), meshObjectCounts.end(), 0);
+		lodSlotCount = 0;
+		bool needsRebuild = false;
+		frameInfo.registry.each<WorldTransformComponent, ModelComponent>(
+			[&](LveEntity entity, WorldTransformComponent& world, ModelComponent& model) {
+				auto [it, inserted] = meshIndices.try_emplace(model.model.get(), static_cast<uint32_t>(meshes.size()));
+				if (inserted)
+				{
+					meshes.push_back(model.model);
+					meshObjectCounts.push_back(0);
+					needsRebuild = true;
+				}
+
+				meshObjectCounts[it->second]++;
+				// a recycled entity index starts from the lod of its previous owner, the selection moves on from there
+				objects.push_back({ world.world, it->second, entity.index, {} });
+				lodSlotCount = std::max(lodSlotCount, entity.index + 1);
+			});
+
+		objectCount = static_cast<uint32_t>(objects.size());
+		meshDraws.clear();
+		if (objectCount == 0)
+		{
+			// no layout to rebuild, but the models of the last one may still be drawn from
+			if (!meshes.empty())
+			{
+				vkDeviceWaitIdle(lveDevice.device());
+				meshes.clear();
+				meshIndices.clear();
+				meshObjectCounts.clear();
+				meshCapacities.clear();
+				meshBatches.clear();
+				batchDraws.clear();
+			}
+			return;
+		}
+
+		needsRebuild = needsRebuild || objectCount > objectCapacity || lodSlotCount > lodSlotCapacity;
+		for (size_t mesh = 0; mesh < meshCapacities.size() && !needsRebuild; mesh++)
+		{
+			needsRebuild = meshObjectCounts[mesh] == 0 || meshObjectCounts[mesh] > meshCapacities[mesh];
+		}
+		if (needsRebuild)
+		{
+			rebuild();
+		}
+
+		auto& objectBuffer = *objectBuffers[frameInfo.frameIndex];
+		objectBuffer.writeToBuffer(objects.data(), objects.size() * sizeof(GpuObject));
+		objectBuffer.flush();
+
+		auto commandBuffer = frameInfo.commandBuffer;
+
+		// the previous frame may still draw from the buffers this pass rewrites
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+
+		if (clearObjectLods)
+		{
+			vkCmdFillBuffer(commandBuffer, objectLodBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+			clearObjectLods = false;
+		}
+		vkCmdFillBuffer(commandBuffer, drawCountBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+
+		auto frustum = LveFrustum::fromMatrix(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+		CullPushConstants push{};
+		for (int plane = 0; plane < 6; plane++)
+		{
+			push.frustumPlanes[plane] = frustum.planes[plane];
+		}
+		push.cameraPosition = glm::vec4(frameInfo.camera.getPosition(), 0.f);
+		// a zero pixelsPerUnit keeps every object at lod 0, like selectLod without an extent
+		push.pixelsPerUnit = frameInfo.camera.getProjection()[1][1] * 0.5f * static_cast<float>(frameInfo.extent.height);
+		push.lodPixelError = lodPixelError;
+		push.lodHysteresis = lodHysteresis;
+		push.objectCount = objectCount;
+
+		pipeline->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipelineLayout,
+			0,
+			1,
+			&descriptorSets[frameInfo.frameIndex],
+			0,
+			nullptr
+		);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push);
+		vkCmdDispatch(commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+
+		batchUsed.assign(batchDraws.size(), 0);
+		for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			if (meshObjectCounts[mesh] != 0)
+			{
+				batchUsed[meshBatches[mesh]] = 1;
+			}
+		}
+		for (size_t batch = 0; batch < batchDraws.size(); batch++)
+		{
+			if (batchUsed[batch])
+			{
+				meshDraws.push_back(batchDraws[batch]);
+			}
+		}
+	}
+
+	void LveGpuCulling::rebuild()
+	{
+		// shared buffers are replaced, nothing in flight may use them
+		vkDeviceWaitIdle(lveDevice.device());
+
+		// meshes without objects leave the layout: models the app dropped are freed with their arena ranges
+		// and their command regions go away
+		meshCapacities.resize(meshes.size(), 0);
+		std::vector<uint32_t> remap(meshes.size(), UINT32_MAX);
+		uint32_t kept = 0;
+		for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			if (meshObjectCounts[mesh] == 0)
+				continue;
+
+			remap[mesh] = kept;
+			meshes[kept] = std::move(meshes[mesh]);
+			meshObjectCounts[kept] = meshObjectCounts[mesh];
+			meshCapacities[kept] = meshCapacities[mesh];
+			kept++;
+		}
+		meshes.resize(kept);
+		meshObjectCounts.resize(kept);
+		meshCapacities.resize(kept);
+		meshIndices.clear();
+		for (uint32_t mesh = 0; mesh < kept; mesh++)
+		{
+			meshIndices.emplace(meshes[mesh].get(), mesh);
+		}
+		for (auto& object : objects)
+		{
+			object.mesh = remap[object.mesh];
+		}
+
+		std::vector<GpuMesh> gpuMeshes;
+		std::vector<GpuLod> gpuLods;
+		std::vector<GpuSubmesh> gpuSubmeshes;
+
+		// meshes in the same arena buffers with the same format and texture share a batch:
+		// one command region, one draw count and so one indirect draw
+		meshBatches.clear();
+		batchDraws.clear();
+		for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			auto& model = *meshes[mesh];
+			meshCapacities[mesh] = roundUpPowerOfTwo(meshObjectCounts[mesh], std::max(meshCapacities[mesh], 1u));
+
+			GpuMesh gpuMesh{};
+			gpuMesh.positionDecode = model.getPositionDecode();
+			gpuMesh.sphere = glm::vec4(model.getSphereCenter(), model.getSphereRadius());
+			gpuMesh.firstLod = static_cast<uint32_t>(gpuLods.size());
+			gpuMesh.lodCount = static_cast<uint32_t>(model.getLods().size());
+
+			uint32_t maxSubmeshes = 0;
+			for (const auto& lod : model.getLods())
+			{
+				gpuLods.push_back({ static_cast<uint32_t>(gpuSubmeshes.size()), lod.submeshCount, lod.error, 0 });
+				for (uint32_t i = 0; i < lod.submeshCount; i++)
+				{
+					const auto& submesh = model.getSubmeshes()[lod.firstSubmesh + i];
+					gpuSubmeshes.push_back({ submesh.firstIndex, submesh.indexCount, submesh.vertexOffset, 0 });
+				}
+				maxSubmeshes = std::max(maxSubmeshes, lod.submeshCount);
+			}
+			gpuMeshes.push_back(gpuMesh);
+
+			auto batch = std::find_if(batchDraws.begin(), batchDraws.end(), [&](const MeshDraw& draw) {
+				return
+					draw.model->getVertexBuffer() == model.getVertexBuffer() &&
+					draw.model->getIndexBuffer() == model.getIndexBuffer() &&
+					draw.model->getIndexType() == model.getIndexType() &&
+					draw.model->getVertexFormat() == model.getVertexFormat() &&
+					draw.model->getTextureName() == model.getTextureName();
+				}) - batchDraws.begin();
+			if (batch == static_cast<ptrdiff_t>(batchDraws.size()))
+			{
+				batchDraws.push_back({ &model, 0, batch * sizeof(uint32_t), 0 });
+			}
+			meshBatches.push_back(static_cast<uint32_t>(batch));
+			batchDraws[batch].maxDrawCount += meshCapacities[mesh] * maxSubmeshes;
+		}
+
+		uint32_t commandCount = 0;
+		for (auto& draw : batchDraws)
+		{
+			draw.commandOffset = commandCount * sizeof(VkDrawIndexedIndirectCommand);
+			commandCount += draw.maxDrawCount;
+		}
+		for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			const auto& draw = batchDraws[meshBatches[mesh]];
+			gpuMeshes[mesh].firstCommand = static_cast<uint32_t>(draw.commandOffset / sizeof(VkDrawIndexedIndirectCommand));
+			gpuMeshes[mesh].countIndex = meshBatches[mesh];
+		}
+
+		auto createTable = [&](const void* data, VkDeviceSize elementSize, size_t count) {
+			auto buffer = std::make_unique<LveBuffer>(
+				lveDevice,
+				elementSize,
+				static_cast<uint32_t>(count),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+			buffer->map();
+			buffer->writeToBuffer(const_cast<void*>(data), elementSize * count);
+			buffer->flush();
+			return buffer;
+		};
+		meshBuffer = createTable(gpuMeshes.data(), sizeof(GpuMesh), gpuMeshes.size());
+		lodBuffer = createTable(gpuLods.data(), sizeof(GpuLod), gpuLods.size());
+		submeshBuffer = createTable(gpuSubmeshes.data(), sizeof(GpuSubmesh), gpuSubmeshes.size());
+
+		if (objectCount > objectCapacity)
+		{
+			objectCapacity = roundUpPowerOfTwo(objectCount, std::max(objectCapacity, 64u));
+
+			for (auto& objectBuffer : objectBuffers)
+			{
+				objectBuffer = std::make_unique<LveBuffer>(
+					lveDevice,
+					sizeof(GpuObject),
+					objectCapacity,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+					);
+				objectBuffer->map();
+			}
+
+			instanceBuffer = std::make_unique<LveBuffer>(
+				lveDevice,
+				INSTANCE_SIZE,
+				objectCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+				);
+		}
+
+		if (lodSlotCount > lodSlotCapacity)
+		{
+			lodSlotCapacity = roundUpPowerOfTwo(lodSlotCount, std::max(lodSlotCapacity, 64u));
+
+			objectLodBuffer = std::make_unique<LveBuffer>(
+				lveDevice,
+				sizeof(uint32_t),
+				lodSlotCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+				);
+			clearObjectLods = true;
+		}
+
+		drawCommandBuffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			sizeof(VkDrawIndexedIndirectCommand),
+			commandCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+		drawCountBuffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			sizeof(uint32_t),
+			static_cast<uint32_t>(batchDraws.size()),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+		writeDescriptorSets();
+	}
+
+	void LveGpuCulling::writeDescriptorSets()
+	{
+		for (uint32_t frame = 0; frame < LveSwapChain::MAX_FRAMES_IN_FLIGHT; frame++)
+		{
+			std::array<VkDescriptorBufferInfo, BINDING_COUNT> bufferInfos{
+				objectBuffers[frame]->descriptorInfo(),
+				meshBuffer->descriptorInfo(),
+				lodBuffer->descriptorInfo(),
+				submeshBuffer->descriptorInfo(),
+				instanceBuffer->descriptorInfo(),
+				drawCommandBuffer->descriptorInfo(),
+				drawCountBuffer->descriptorInfo(),
+				objectLodBuffer->descriptorInfo()
+			};
+
+			LveDescriptorWriter writer{ *setLayout, *descriptorPool };
+			for (uint32_t binding = 0; binding < BINDING_COUNT; binding++)
+			{
+				writer.writeBuffer(binding, &bufferInfos[binding]);
+			}
+
+			if (descriptorSets[frame] == VK_NULL_HANDLE)
+			{
+				if (!writer.build(descriptorSets[frame]))
+				{
+					throw std::runtime_error("failed to allocate culling descriptor set!");
+				}
+			}
+			else
+			{
+				writer.overwrite(descriptorSets[frame]);
+			}
+		}
+	}
+}
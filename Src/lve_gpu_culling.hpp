@@ -0,0 +1,164 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_model.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_swap_chain.hpp"
+
+//std
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	// GPU driven culling: a compute pass (indirect_cull.comp) culls every object against the frustum,
+	// selects its lod and writes one VkDrawIndexedIndirectCommand per submesh of the lod.
+	// Meshes that share arena buffers, vertex format and texture form a batch. Every batch owns a region
+	// of the command buffer sized for all of its objects plus a draw count, so drawing takes one
+	// vkCmdDrawIndexedIndirectCount per batch whatever the number of objects.
+	// The pass also writes the instance data the instanced pipelines read, at the object index
+	// that the commands pass as firstInstance.
+	class LveGpuCulling
+	{
+	public:
+		// size of SimpleRenderSystem InstanceData, written by the compute pass
+		static constexpr VkDeviceSize INSTANCE_SIZE = sizeof(glm::mat4) + 3 * sizeof(glm::vec4);
+
+		// std430 layouts of indirect_cull.comp
+		struct GpuObject
+		{
+			glm::mat4 modelMatrix;
+			uint32_t mesh;
+			// the entity index: unlike the object index it stays with the entity when others come and go
+			uint32_t lodSlot;
+			uint32_t pad[2];
+		};
+
+		struct GpuMesh
+		{
+			glm::mat4 positionDecode;
+			// object space bounding sphere, w is the radius
+			glm::vec4 sphere;
+			uint32_t firstLod;
+			uint32_t lodCount;
+			uint32_t firstCommand;
+			uint32_t countIndex;
+		};
+
+		struct GpuLod
+		{
+			uint32_t firstSubmesh;
+			uint32_t submeshCount;
+			float error;
+			uint32_t pad;
+		};
+
+		struct GpuSubmesh
+		{
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			int32_t vertexOffset;
+			uint32_t pad;
+		};
+
+		struct CullPushConstants
+		{
+			glm::vec4 frustumPlanes[6];
+			glm::vec4 cameraPosition;
+			float pixelsPerUnit;
+			float lodPixelError;
+			float lodHysteresis;
+			uint32_t objectCount;
+		};
+
+		// one vkCmdDrawIndexedIndirectCount, binds and texture of model
+		struct MeshDraw
+		{
+			LveModel* model;
+			VkDeviceSize commandOffset;
+			VkDeviceSize countOffset;
+			uint32_t maxDrawCount;
+		};
+
+		/// <param name="lodPixelError">see SimpleRenderSystem::selectLod</param>
+		LveGpuCulling(LveDevice& device, float lodPixelError, float lodHysteresis);
+		~LveGpuCulling();
+
+		LveGpuCulling(const LveGpuCulling&) = delete;
+		void operator=(const LveGpuCulling&) = delete;
+
+		/// <summary>
+		/// Upload the transforms of all objects with a model and record the culling pass.
+		/// Has to be recorded outside of a render pass, before the draws that use its results
+		/// </summary>
+		void cull(FrameInfo& frameInfo);
+
+		// draws of the last cull, one per batch in use
+		const std::vector<MeshDraw>& getMeshDraws() const { return meshDraws; }
+		VkBuffer getInstanceBuffer() const { return instanceBuffer->getBuffer(); }
+		VkBuffer getDrawCommandBuffer() const { return drawCommandBuffer->getBuffer(); }
+		VkBuffer getDrawCountBuffer() const { return drawCountBuffer->getBuffer(); }
+		uint32_t getObjectCount() const { return objectCount; }
+
+	private:
+		static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+		void createPipeline();
+		/// <summary>
+		/// Lay the command regions out for the current meshes and object counts, recreate the shared buffers.
+		/// Meshes without objects are dropped and the objects of the last cull renumbered.
+		/// Waits for the device, it only runs when meshes appear, lose all their objects or outgrow their regions
+		/// </summary>
+		void rebuild();
+		void writeDescriptorSets();
+
+		LveDevice& lveDevice;
+		float lodPixelError;
+		float lodHysteresis;
+
+		std::unique_ptr<LveDescriptorSetLayout> setLayout;
+		std::unique_ptr<LveDescriptorPool> descriptorPool;
+		std::array<VkDescriptorSet, LveSwapChain::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<LvePipeline> pipeline;
+
+		// written by the CPU every frame
+		std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> objectBuffers;
+		// written on rebuild
+		std::unique_ptr<LveBuffer> meshBuffer;
+		std::unique_ptr<LveBuffer> lodBuffer;
+		std::unique_ptr<LveBuffer> submeshBuffer;
+		// written by the compute pass
+		std::unique_ptr<LveBuffer> instanceBuffer;
+		std::unique_ptr<LveBuffer> drawCommandBuffer;
+		std::unique_ptr<LveBuffer> drawCountBuffer;
+		std::unique_ptr<LveBuffer> objectLodBuffer;
+
+		// meshes of the current layout, the table keeps them alive so their index stays theirs until rebuild drops them
+		std::vector<std::shared_ptr<LveModel>> meshes;
+		std::unordered_map<const LveModel*, uint32_t> meshIndices;
+		// objects each mesh region has room for
+		std::vector<uint32_t> meshCapacities;
+		// batch of every mesh
+		std::vector<uint32_t> meshBatches;
+		// draw of every batch, model is the first mesh of the batch
+		std::vector<MeshDraw> batchDraws;
+		std::vector<uint8_t> batchUsed;
+		// lods of the previous buffer are gone, the next cull starts all objects at lod 0
+		bool clearObjectLods = false;
+		uint32_t objectCapacity = 0;
+		uint32_t lodSlotCapacity = 0;
+
+		std::vector<GpuObject> objects;
+		std::vector<uint32_t> meshObjectCounts;
+		std::vector<MeshDraw> meshDraws;
+		uint32_t objectCount = 0;
+		// highest lodSlot of the last cull + 1
+		uint32_t lodSlotCount = 0;
+	};
+}
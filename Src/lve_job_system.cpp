@@ -0,0 +1,255 @@
+#include "lve_job_system.hpp"
+
+//std
+#include <cassert>
+
+namespace lve {
+
+	namespace {
+		// worker of the calling thread and the system it belongs to, a thread serves at most one system
+		struct WorkerSlot
+		{
+			const LveJobSystem* system = nullptr;
+			uint32_t index = 0;
+		};
+		thread_local WorkerSlot workerSlot;
+	}
+
+	LveJobSystem::LveJobSystem(uint32_t workerCount) : mainThread{ std::this_thread::get_id() }
+	{
+		if (workerCount == 0)
+		{
+			workerCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			workers.push_back(std::make_unique<JobQueue>());
+		}
+
+		threads.reserve(workerCount - 1);
+		for (uint32_t worker = 1; worker < workerCount; worker++)
+		{
+			threads.emplace_back(&LveJobSystem::workerLoop, this, worker);
+		}
+	}
+
+	LveJobSystem::~LveJobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+			stopping = true;
+		}
+		wakeUp.notify_all();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	LveJobSystem& LveJobSystem::shared()
+	{
+		static LveJobSystem jobSystem{};
+		return jobSystem;
+	}
+
+	uint32_t LveJobSystem::currentWorker() const
+	{
+		// threads outside of this system count as its main thread
+		return workerSlot.system == this ? workerSlot.index : 0;
+	}
+
+	void LveJobSystem::run(Job job, LveJobCounter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		auto worker = std::min(currentWorker(), getWorkerCount() - 1);
+		push(*workers[worker], { std::move(job), counter });
+	}
+
+	void LveJobSystem::runAfter(LveJobCounter& dependency, Job job, LveJobCounter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		{
+			// finish takes the same lock before it moves the continuations out, so none is missed
+			std::lock_guard<std::mutex> lock{ dependency.mutex };
+			if (!dependency.isDone())
+			{
+				dependency.continuations.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+
+		auto worker = std::min(currentWorker(), getWorkerCount() - 1);
+		push(*workers[worker], { std::move(job), counter });
+	}
+
+	void LveJobSystem::runOnMainThread(Job job, LveJobCounter* counter)
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		std::lock_guard<std::mutex> lock{ mainThreadJobs.mutex };
+		mainThreadJobs.tasks.push_back({ std::move(job), counter });
+	}
+
+	void LveJobSystem::wait(LveJobCounter& counter)
+	{
+		auto worker = std::min(currentWorker(), getWorkerCount() - 1);
+		while (!counter.isDone())
+		{
+			if (!tryRunJob(worker))
+			{
+				// the remaining jobs run elsewhere
+				std::this_thread::yield();
+			}
+		}
+
+		// the last finish still holds the counter`s lock right after pending hit 0, the counter may only go away after it
+		std::lock_guard<std::mutex> lock{ counter.mutex };
+	}
+
+	void LveJobSystem::runMainThreadJobs()
+	{
+		assert(isMainThread() && "main thread jobs run on the main thread only");
+		while (true)
+		{
+			Task task;
+			{
+				std::lock_guard<std::mutex> lock{ mainThreadJobs.mutex };
+				if (mainThreadJobs.tasks.empty())
+					return;
+
+				task = std::move(mainThreadJobs.tasks.front());
+				mainThreadJobs.tasks.pop_front();
+			}
+			execute(task);
+		}
+	}
+
+	void LveJobSystem::push(JobQueue& queue, Task task)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			queue.tasks.push_back(std::move(task));
+		}
+
+		queuedJobs.fetch_add(1, std::memory_order_release);
+		{
+			// a worker between its check of queuedJobs and going to sleep holds the lock, it can`t miss the notify
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+		}
+		wakeUp.notify_one();
+	}
+
+	bool LveJobSystem::tryRunJob(uint32_t worker)
+	{
+		Task task;
+		bool found = false;
+
+		{
+			auto& own = *workers[worker];
+			std::lock_guard<std::mutex> lock{ own.mutex };
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				found = true;
+			}
+		}
+
+		if (!found && worker == 0 && isMainThread())
+		{
+			bool mainThreadJob = false;
+			{
+				std::lock_guard<std::mutex> lock{ mainThreadJobs.mutex };
+				if (!mainThreadJobs.tasks.empty())
+				{
+					task = std::move(mainThreadJobs.tasks.front());
+					mainThreadJobs.tasks.pop_front();
+					mainThreadJob = true;
+				}
+			}
+
+			// outside of the lock: the job may queue main thread jobs or wait itself
+			if (mainThreadJob)
+			{
+				execute(task);
+				return true;
+			}
+		}
+
+		auto workerCount = getWorkerCount();
+		for (uint32_t offset = 1; !found && offset < workerCount; offset++)
+		{
+			auto& victim = *workers[(worker + offset) % workerCount];
+			std::lock_guard<std::mutex> lock{ victim.mutex };
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				found = true;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		execute(task);
+		return true;
+	}
+
+	void LveJobSystem::execute(Task& task)
+	{
+		task.job();
+		if (task.counter != nullptr)
+		{
+			finish(*task.counter);
+		}
+	}
+
+	void LveJobSystem::finish(LveJobCounter& counter)
+	{
+		std::vector<std::pair<Job, LveJobCounter*>> ready;
+		{
+			// the lock orders this against runAfter and against wait returning
+			std::lock_guard<std::mutex> lock{ counter.mutex };
+			if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			ready.swap(counter.continuations);
+		}
+
+		auto worker = std::min(currentWorker(), getWorkerCount() - 1);
+		for (auto& [job, jobCounter] : ready)
+		{
+			push(*workers[worker], { std::move(job), jobCounter });
+		}
+	}
+
+	void LveJobSystem::workerLoop(uint32_t worker)
+	{
+		workerSlot = { this, worker };
+		while (true)
+		{
+			if (tryRunJob(worker))
+				continue;
+
+			std::unique_lock<std::mutex> lock{ sleepMutex };
+			wakeUp.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+			if (stopping)
+				return;
+		}
+	}
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+//std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	// Counts the unfinished jobs it was passed to. Jobs can wait for it (LveJobSystem::wait) or be queued
+	// to start once it drops to zero (LveJobSystem::runAfter). Reuse a counter only after it was waited for.
+	class LveJobCounter
+	{
+	public:
+		LveJobCounter() = default;
+
+		LveJobCounter(const LveJobCounter&) = delete;
+		void operator=(const LveJobCounter&) = delete;
+
+		bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class LveJobSystem;
+
+		std::atomic<uint32_t> pending{ 0 };
+		// jobs of runAfter, queued when pending drops to zero
+		std::mutex mutex;
+		std::vector<std::pair<std::function<void()>, LveJobCounter*>> continuations;
+	};
+
+	// Work stealing job scheduler. Every worker owns a deque: it pushes and pops its own jobs at the back (newest first,
+	// warm caches) and idle workers steal from the front of the others (oldest, usually the biggest pieces of work).
+	// The thread that creates the system is worker 0, the main thread. It runs no loop of its own, it works off jobs
+	// while it waits for a counter. Jobs of runOnMainThread only ever run there, for work like Vulkan queue submission
+	// that has to stay on one thread.
+	//
+	// Waiting never blocks a worker: wait runs other jobs until the counter is done, so jobs can wait for jobs they start.
+	// Jobs must not throw.
+	class LveJobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+
+		/// <param name="workerCount">threads including the main thread, 0 - one per hardware thread</param>
+		LveJobSystem(uint32_t workerCount = 0);
+		~LveJobSystem();
+
+		LveJobSystem(const LveJobSystem&) = delete;
+		void operator=(const LveJobSystem&) = delete;
+
+		/// <summary>
+		/// Engine wide system with a worker per hardware thread. Created on first use, which has to be on the main thread
+		/// </summary>
+		static LveJobSystem& shared();
+
+		uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+		/// <summary>
+		/// Worker index of the calling thread in this system, unique among the threads running its jobs.
+		/// 0 on the main thread and on threads that don`t belong to this system, workers of another system included
+		/// </summary>
+		uint32_t currentWorker() const;
+		bool isMainThread() const { return std::this_thread::get_id() == mainThread; }
+
+		/// <param name="counter">incremented now, decremented when the job finished. May be null</param>
+		void run(Job job, LveJobCounter* counter = nullptr);
+		/// <summary>
+		/// Queue job once dependency is done, right away if it is already
+		/// </summary>
+		void runAfter(LveJobCounter& dependency, Job job, LveJobCounter* counter = nullptr);
+		/// <summary>
+		/// Queue job for the main thread, it runs in the next wait or runMainThreadJobs there
+		/// </summary>
+		void runOnMainThread(Job job, LveJobCounter* counter = nullptr);
+
+		/// <summary>
+		/// Run jobs until counter is done
+		/// </summary>
+		void wait(LveJobCounter& counter);
+		/// <summary>
+		/// Main thread only. Run the jobs queued by runOnMainThread so far
+		/// </summary>
+		void runMainThreadJobs();
+
+		/// <summary>
+		/// Call function(begin, end) for batches covering [0, count) of at least minBatchSize items, spread over the workers.
+		/// The calling thread takes part and returns when all batches are done
+		/// </summary>
+		template<typename F>
+		void parallelFor(uint32_t count, uint32_t minBatchSize, F&& function)
+		{
+			if (count == 0)
+				return;
+
+			// a few batches per worker so stealing can even out batches of uneven cost
+			uint32_t batchCount = (count + std::max(minBatchSize, 1u) - 1) / std::max(minBatchSize, 1u);
+			batchCount = std::clamp(batchCount, 1u, getWorkerCount() * 4);
+			auto batchBegin = [count, batchCount](uint32_t batch) {
+				return static_cast<uint32_t>(static_cast<uint64_t>(count) * batch / batchCount);
+			};
+
+			LveJobCounter counter;
+			for (uint32_t batch = 1; batch < batchCount; batch++)
+			{
+				run([&function, batchBegin, batch]() { function(batchBegin(batch), batchBegin(batch + 1)); }, &counter);
+			}
+			function(batchBegin(0), batchBegin(1));
+			wait(counter);
+		}
+
+	private:
+		struct Task
+		{
+			Job job;
+			LveJobCounter* counter = nullptr;
+		};
+
+		struct JobQueue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void push(JobQueue& queue, Task task);
+		/// <summary>
+		/// Own jobs newest first, then the main thread queue (main thread only), then steal the oldest of another worker
+		/// </summary>
+		bool tryRunJob(uint32_t worker);
+		void execute(Task& task);
+		void finish(LveJobCounter& counter);
+		void workerLoop(uint32_t worker);
+
+		std::thread::id mainThread;
+		std::vector<std::unique_ptr<JobQueue>> workers;
+		JobQueue mainThreadJobs;
+		std::vector<std::thread> threads;
+
+		// jobs in the worker queues, idle workers sleep while it is 0
+		std::atomic<uint32_t> queuedJobs{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wakeUp;
+		std::atomic<bool> stopping{ false };
+	};
+}
@@ -0,0 +1,214 @@
+#include "lve_light_clusters.hpp"
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace lve {
+
+	static_assert(sizeof(PointLight) == 32, "PointLight has to match the std430 lights buffer");
+	static_assert(sizeof(LveLightClusters::ClusterRange) == 8, "ClusterRange has to match the std430 cluster buffer");
+
+	LveLightClusters::LveLightClusters(LveDevice& device)
+	{
+		auto createBuffer = [&](VkDeviceSize elementSize, uint32_t count) {
+			auto buffer = std::make_unique<LveBuffer>(
+				device,
+				elementSize,
+				count,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+			buffer->map();
+			return buffer;
+		};
+
+		for (int frame = 0; frame < LveSwapChain::MAX_FRAMES_IN_FLIGHT; frame++)
+		{
+			lightBuffers[frame] = createBuffer(sizeof(PointLight), MAX_LIGHTS);
+			clusterBuffers[frame] = createBuffer(sizeof(ClusterRange), CLUSTER_COUNT);
+			lightIndexBuffers[frame] = createBuffer(sizeof(uint32_t), MAX_LIGHT_INDICES);
+		}
+
+		clusterCounts.resize(CLUSTER_COUNT);
+		clusterRanges.resize(CLUSTER_COUNT);
+	}
+
+	float LveLightClusters::lightRange(const glm::vec3& color, float intensity)
+	{
+		// intensity / distance^2 = LIGHT_CUTOFF
+		float peak = intensity * std::max({ color.r, color.g, color.b });
+		return std::sqrt(std::max(peak, 0.f) / LIGHT_CUTOFF);
+	}
+
+	void LveLightClusters::computeClusterBounds(float projectionX, float projectionY, float nearPlane, float farPlane)
+	{
+		boundsProjection = { projectionX, projectionY, nearPlane, farPlane };
+		clusterMin.resize(CLUSTER_COUNT);
+		clusterMax.resize(CLUSTER_COUNT);
+
+		for (uint32_t z = 0; z < GRID_Z; z++)
+		{
+			float sliceNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / GRID_Z);
+			float sliceFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z + 1) / GRID_Z);
+			for (uint32_t y = 0; y < GRID_Y; y++)
+			{
+				float ndcY0 = 2.f * y / GRID_Y - 1.f;
+				float ndcY1 = 2.f * (y + 1) / GRID_Y - 1.f;
+				for (uint32_t x = 0; x < GRID_X; x++)
+				{
+					float ndcX0 = 2.f * x / GRID_X - 1.f;
+					float ndcX1 = 2.f * (x + 1) / GRID_X - 1.f;
+
+					// the tile edges widen with depth, the box spans them at both slice planes
+					auto cluster = x + GRID_X * (y + GRID_Y * z);
+					clusterMin[cluster] = {
+						std::min(ndcX0 * sliceNear, ndcX0 * sliceFar) / projectionX,
+						std::min(ndcY0 * sliceNear, ndcY0 * sliceFar) / projectionY,
+						sliceNear
+					};
+					clusterMax[cluster] = {
+						std::max(ndcX1 * sliceNear, ndcX1 * sliceFar) / projectionX,
+						std::max(ndcY1 * sliceNear, ndcY1 * sliceFar) / projectionY,
+						sliceFar
+					};
+				}
+			}
+		}
+	}
+
+	void LveLightClusters::update(int frameIndex, const LveCamera& camera, VkExtent2D extent, const std::vector<PointLight>& lights, GlobalUbo& ubo)
+	{
+		assert(camera.isPerspective() && "light clusters need a perspective projection");
+
+		const auto& projection = camera.getProjection();
+		float nearPlane = camera.getNear();
+		float farPlane = camera.getFar();
+		glm::vec4 currentProjection{ projection[0][0], projection[1][1], nearPlane, farPlane };
+		if (currentProjection != boundsProjection)
+		{
+			computeClusterBounds(projection[0][0], projection[1][1], nearPlane, farPlane);
+		}
+
+		float logDepthRatio = std::log(farPlane / nearPlane);
+		float sliceScale = GRID_Z / logDepthRatio;
+		float sliceBias = GRID_Z * std::log(nearPlane) / logDepthRatio;
+		auto sliceOf = [&](float viewZ) {
+			auto slice = static_cast<int>(std::floor(std::log(viewZ) * sliceScale - sliceBias));
+			return static_cast<uint32_t>(std::clamp(slice, 0, static_cast<int>(GRID_Z) - 1));
+		};
+		auto tileOf = [](float ndc, uint32_t tiles) {
+			auto tile = static_cast<int>(std::floor((ndc + 1.f) * 0.5f * tiles));
+			return static_cast<uint32_t>(std::clamp(tile, 0, static_cast<int>(tiles) - 1));
+		};
+
+		auto lightCount = static_cast<uint32_t>(std::min<size_t>(lights.size(), MAX_LIGHTS));
+		ubo.clusterCount = { GRID_X, GRID_Y, GRID_Z, 0 };
+		ubo.clusterParams = {
+			static_cast<float>(extent.width) / GRID_X,
+			static_cast<float>(extent.height) / GRID_Y,
+			sliceScale,
+			sliceBias
+		};
+		ubo.numLights = static_cast<int>(lightCount);
+
+		const auto& view = camera.getView();
+		std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+		assignments.clear();
+		for (uint32_t light = 0; light < lightCount; light++)
+		{
+			auto center = glm::vec3(view * glm::vec4(glm::vec3(lights[light].position), 1.f));
+			float range = lights[light].position.w;
+			if (center.z + range < nearPlane || center.z - range > farPlane)
+				continue;
+
+			uint32_t z0 = sliceOf(std::max(center.z - range, nearPlane));
+			uint32_t z1 = sliceOf(std::min(center.z + range, farPlane));
+
+			// screen rect of the box around the sphere, its extremes are at the corners
+			uint32_t x0 = 0, x1 = GRID_X - 1, y0 = 0, y1 = GRID_Y - 1;
+			if (center.z - range > nearPlane)
+			{
+				float minX = 1.f, maxX = -1.f, minY = 1.f, maxY = -1.f;
+				for (float depth : { center.z - range, center.z + range })
+				{
+					for (float side : { -range, range })
+					{
+						float ndcX = projection[0][0] * (center.x + side) / depth;
+						float ndcY = projection[1][1] * (center.y + side) / depth;
+						minX = std::min(minX, ndcX);
+						maxX = std::max(maxX, ndcX);
+						minY = std::min(minY, ndcY);
+						maxY = std::max(maxY, ndcY);
+					}
+				}
+				if (minX > 1.f || maxX < -1.f || minY > 1.f || maxY < -1.f)
+					continue;
+
+				x0 = tileOf(minX, GRID_X);
+				x1 = tileOf(maxX, GRID_X);
+				y0 = tileOf(minY, GRID_Y);
+				y1 = tileOf(maxY, GRID_Y);
+			}
+
+			float rangeSquared = range * range;
+			for (uint32_t z = z0; z <= z1; z++)
+			{
+				for (uint32_t y = y0; y <= y1; y++)
+				{
+					for (uint32_t x = x0; x <= x1; x++)
+					{
+						auto cluster = x + GRID_X * (y + GRID_Y * z);
+						auto closest = glm::clamp(center, clusterMin[cluster], clusterMax[cluster]);
+						auto offset = closest - center;
+						if (glm::dot(offset, offset) > rangeSquared)
+							continue;
+
+						assignments.emplace_back(cluster, light);
+						clusterCounts[cluster]++;
+					}
+				}
+			}
+		}
+
+		stats = {};
+		stats.lights = lightCount;
+		uint32_t offset = 0;
+		for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+		{
+			auto count = std::min(clusterCounts[cluster], MAX_LIGHT_INDICES - offset);
+			stats.droppedIndices += clusterCounts[cluster] - count;
+			stats.maxClusterLights = std::max(stats.maxClusterLights, clusterCounts[cluster]);
+			clusterRanges[cluster] = { offset, count };
+			offset += count;
+			// reused as fill position
+			clusterCounts[cluster] = 0;
+		}
+		stats.lightIndices = offset;
+
+		lightIndices.resize(offset);
+		for (const auto& [cluster, light] : assignments)
+		{
+			auto& range = clusterRanges[cluster];
+			auto& fill = clusterCounts[cluster];
+			if (fill < range.count)
+			{
+				lightIndices[range.offset + fill++] = light;
+			}
+		}
+
+		if (lightCount > 0)
+		{
+			lightBuffers[frameIndex]->writeToBuffer(const_cast<PointLight*>(lights.data()), lightCount * sizeof(PointLight));
+			lightBuffers[frameIndex]->flush();
+		}
+		clusterBuffers[frameIndex]->writeToBuffer(clusterRanges.data(), CLUSTER_COUNT * sizeof(ClusterRange));
+		clusterBuffers[frameIndex]->flush();
+		if (offset > 0)
+		{
+			lightIndexBuffers[frameIndex]->writeToBuffer(lightIndices.data(), offset * sizeof(uint32_t));
+			lightIndexBuffers[frameIndex]->flush();
+		}
+	}
+}
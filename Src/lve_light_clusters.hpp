@@ -0,0 +1,100 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_camera.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_swap_chain.hpp"
+
+//std
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// Clustered forward lighting (Olsson et al.): the view frustum is split into GRID_X * GRID_Y screen tiles
+	// and GRID_Z depth slices of exponentially growing thickness. Every frame each light is assigned, on the CPU,
+	// to the clusters its range sphere touches. Fragments look their cluster up from gl_FragCoord and view depth
+	// and only shade the lights listed for it, so the cost per fragment follows the lights nearby, not the scene.
+	// Lights, cluster ranges and light index lists are storage buffers, one set per frame in flight.
+	class LveLightClusters
+	{
+	public:
+		static constexpr uint32_t GRID_X = 16;
+		static constexpr uint32_t GRID_Y = 9;
+		static constexpr uint32_t GRID_Z = 24;
+		static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+		static constexpr uint32_t MAX_LIGHTS = 4096;
+		// light indices of all clusters together, clusters past it lose the lights that don`t fit
+		static constexpr uint32_t MAX_LIGHT_INDICES = 1u << 19;
+
+		// std430 element of the cluster buffer: lights of the cluster are lightIndices[offset..offset + count)
+		struct ClusterRange
+		{
+			uint32_t offset;
+			uint32_t count;
+		};
+
+		struct Stats
+		{
+			uint32_t lights = 0;
+			uint32_t lightIndices = 0;
+			// indices that didn`t fit into MAX_LIGHT_INDICES
+			uint32_t droppedIndices = 0;
+			uint32_t maxClusterLights = 0;
+		};
+
+		LveLightClusters(LveDevice& device);
+
+		LveLightClusters(const LveLightClusters&) = delete;
+		void operator=(const LveLightClusters&) = delete;
+
+		/// <summary>
+		/// Assign lights to the clusters of camera and write lights and cluster lists into the buffers of frameIndex.
+		/// Sets the light and cluster fields of ubo. Lights past MAX_LIGHTS are ignored
+		/// </summary>
+		/// <param name="lights">world space, position w is the range</param>
+		void update(int frameIndex, const LveCamera& camera, VkExtent2D extent, const std::vector<PointLight>& lights, GlobalUbo& ubo);
+
+		// global set bindings 1, 2 and 3
+		VkDescriptorBufferInfo lightsInfo(int frameIndex) { return lightBuffers[frameIndex]->descriptorInfo(); }
+		VkDescriptorBufferInfo clustersInfo(int frameIndex) { return clusterBuffers[frameIndex]->descriptorInfo(); }
+		VkDescriptorBufferInfo lightIndicesInfo(int frameIndex) { return lightIndexBuffers[frameIndex]->descriptorInfo(); }
+
+		// of the last update
+		const Stats& getStats() const { return stats; }
+
+		/// <summary>
+		/// Range where the light of intensity * color falls off below LIGHT_CUTOFF, the shader fades it out towards it
+		/// </summary>
+		static float lightRange(const glm::vec3& color, float intensity);
+
+	private:
+		// attenuated intensity where lights are cut off
+		static constexpr float LIGHT_CUTOFF = 0.002f;
+
+		/// <summary>
+		/// View space boxes of all clusters, only changes with the projection
+		/// </summary>
+		void computeClusterBounds(float projectionX, float projectionY, float nearPlane, float farPlane);
+
+		std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> lightBuffers;
+		std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> clusterBuffers;
+		std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> lightIndexBuffers;
+
+		// projection the bounds were computed for
+		glm::vec4 boundsProjection{ 0.f };
+		std::vector<glm::vec3> clusterMin;
+		std::vector<glm::vec3> clusterMax;
+
+		// per update scratch
+		std::vector<uint32_t> clusterCounts;
+		std::vector<ClusterRange> clusterRanges;
+		// cluster and light of every assignment, in light order
+		std::vector<std::pair<uint32_t, uint32_t>> assignments;
+		std::vector<uint32_t> lightIndices;
+
+		Stats stats{};
+	};
+}
@@ -0,0 +1,244 @@
+#include "lve_mesh_cache.hpp"
+
+#include "lve_vertex_quantizer.hpp"
+
+//std
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace lve {
+
+	static constexpr char MESH_CACHE_MAGIC[4] = { 'L', 'V', 'E', 'M' };
+	static constexpr uint64_t MESH_CACHE_BLOB_ALIGNMENT = 16;
+
+	static uint64_t alignBlob(uint64_t offset)
+	{
+		return (offset + MESH_CACHE_BLOB_ALIGNMENT - 1) & ~(MESH_CACHE_BLOB_ALIGNMENT - 1);
+	}
+
+	std::string LveMeshCache::cachePath(const std::string& sourcePath)
+	{
+		return sourcePath + ".lvemesh";
+	}
+
+	bool LveMeshCache::sourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(sourcePath, error);
+		if (error)
+			return false;
+
+		auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+		if (error)
+			return false;
+
+		time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+		return true;
+	}
+
+	bool LveMeshCache::open(const std::string& sourcePath, LveModel::VertexFormat vertexFormat, uint32_t flags)
+	{
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		if (!sourceStamp(sourcePath, sourceSize, sourceTime))
+			return false;
+
+		if (!file.open(cachePath(sourcePath)))
+			return false;
+
+		bool valid = file.size() >= sizeof(Header);
+		if (valid)
+		{
+			auto& header = getHeader();
+			valid =
+				std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) == 0 &&
+				header.version == VERSION &&
+				header.vertexFormat == static_cast<uint32_t>(vertexFormat) &&
+				header.vertexStride == LveVertexQuantizer::vertexStride(vertexFormat) &&
+				(header.indexStride == sizeof(uint16_t) || header.indexStride == sizeof(uint32_t)) &&
+				header.flags == flags &&
+				header.sourceSize == sourceSize &&
+				header.sourceTime == sourceTime &&
+				header.vertexOffset + uint64_t{ header.vertexCount } * header.vertexStride <= file.size() &&
+				header.indexOffset + uint64_t{ header.indexCount } * header.indexStride <= file.size() &&
+				header.submeshOffset + uint64_t{ header.submeshCount } * sizeof(LveModel::Submesh) <= file.size() &&
+				header.lodCount > 0 &&
+				header.lodOffset + uint64_t{ header.lodCount } * sizeof(LveModel::Lod) <= file.size() &&
+				header.meshletOffset + uint64_t{ header.meshletCount } * sizeof(LveModel::Meshlet) <= file.size();
+		}
+
+		// blobs fit the file, now the ranges stored in them have to fit the blobs
+		valid = valid && rangesValid();
+
+		if (!valid)
+		{
+			file.close();
+		}
+
+		return valid;
+	}
+
+	bool LveMeshCache::rangesValid() const
+	{
+		auto& header = getHeader();
+		auto rangeFits = [](uint64_t first, uint64_t count, uint64_t total) { return first + count <= total; };
+		// every index of the range plus vertexOffset has to hit a vertex, a range is checked after it fits the index blob
+		auto indicesFit = [&](uint32_t firstIndex, uint32_t indexCount, int32_t vertexOffset) {
+			if (vertexOffset < 0 || static_cast<uint64_t>(vertexOffset) >= header.vertexCount)
+				return false;
+
+			uint32_t maxIndex = 0;
+			if (header.indexStride == sizeof(uint16_t))
+			{
+				auto indices = static_cast<const uint16_t*>(getIndices()) + firstIndex;
+				maxIndex = indexCount > 0 ? *std::max_element(indices, indices + indexCount) : 0;
+			}
+			else
+			{
+				auto indices = static_cast<const uint32_t*>(getIndices()) + firstIndex;
+				maxIndex = indexCount > 0 ? *std::max_element(indices, indices + indexCount) : 0;
+			}
+			return uint64_t{ maxIndex } + static_cast<uint64_t>(vertexOffset) < header.vertexCount;
+		};
+
+		auto submeshes = getSubmeshes();
+		for (uint32_t i = 0; i < header.submeshCount; i++)
+		{
+			const auto& submesh = submeshes[i];
+			if (!rangeFits(submesh.firstIndex, submesh.indexCount, header.indexCount) ||
+				!indicesFit(submesh.firstIndex, submesh.indexCount, submesh.vertexOffset))
+				return false;
+		}
+
+		auto lods = getLods();
+		for (uint32_t i = 0; i < header.lodCount; i++)
+		{
+			if (!rangeFits(lods[i].firstSubmesh, lods[i].submeshCount, header.submeshCount) ||
+				!rangeFits(lods[i].firstMeshlet, lods[i].meshletCount, header.meshletCount))
+				return false;
+		}
+
+		auto meshlets = getMeshlets();
+		for (uint32_t i = 0; i < header.meshletCount; i++)
+		{
+			const auto& meshlet = meshlets[i];
+			if (!rangeFits(meshlet.firstIndex, meshlet.indexCount, header.indexCount) ||
+				!indicesFit(meshlet.firstIndex, meshlet.indexCount, meshlet.vertexOffset))
+				return false;
+		}
+
+		return true;
+	}
+
+	const void* LveMeshCache::getVertices() const
+	{
+		return file.data() + getHeader().vertexOffset;
+	}
+
+	const void* LveMeshCache::getIndices() const
+	{
+		return file.data() + getHeader().indexOffset;
+	}
+
+	const LveModel::Submesh* LveMeshCache::getSubmeshes() const
+	{
+		return reinterpret_cast<const LveModel::Submesh*>(file.data() + getHeader().submeshOffset);
+	}
+
+	const LveModel::Lod* LveMeshCache::getLods() const
+	{
+		return reinterpret_cast<const LveModel::Lod*>(file.data() + getHeader().lodOffset);
+	}
+
+	const LveModel::Meshlet* LveMeshCache::getMeshlets() const
+	{
+		return reinterpret_cast<const LveModel::Meshlet*>(file.data() + getHeader().meshletOffset);
+	}
+
+	void LveMeshCache::write(const std::string& sourcePath, const LveModel::Builder& builder, LveModel::VertexFormat vertexFormat)
+	{
+		auto vertexData = LveVertexQuantizer::encode(vertexFormat, builder.vertices.data(), builder.vertices.size(), builder.boundsMin, builder.boundsMax);
+		auto indexType = builder.getIndexType();
+		auto indexData = builder.packIndices(indexType);
+		auto submeshes = builder.submeshes;
+		if (submeshes.empty())
+		{
+			submeshes.push_back({ 0, static_cast<uint32_t>(builder.indices.size()), 0 });
+		}
+		auto lods = builder.lods;
+		if (lods.empty())
+		{
+			lods.push_back({ 0, static_cast<uint32_t>(submeshes.size()), 0.f });
+		}
+
+		Header header{};
+		std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+		header.version = VERSION;
+		header.vertexStride = LveVertexQuantizer::vertexStride(vertexFormat);
+		header.indexStride = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		header.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		header.indexCount = static_cast<uint32_t>(builder.indices.size());
+		header.flags = builder.optimized ? FLAG_OPTIMIZED : 0;
+		header.vertexFormat = static_cast<uint32_t>(vertexFormat);
+		header.submeshCount = static_cast<uint32_t>(submeshes.size());
+		header.lodCount = static_cast<uint32_t>(lods.size());
+		header.meshletCount = static_cast<uint32_t>(builder.meshlets.size());
+		header.closed = builder.closed ? 1 : 0;
+		header.boundsMin = builder.boundsMin;
+		header.boundsMax = builder.boundsMax;
+		header.sphereCenter = builder.sphereCenter;
+		header.sphereRadius = builder.sphereRadius;
+		if (!sourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+			return;
+
+		header.vertexOffset = alignBlob(sizeof(Header));
+		header.indexOffset = alignBlob(header.vertexOffset + uint64_t{ header.vertexCount } * header.vertexStride);
+		header.submeshOffset = alignBlob(header.indexOffset + uint64_t{ header.indexCount } * header.indexStride);
+		header.lodOffset = alignBlob(header.submeshOffset + uint64_t{ header.submeshCount } * sizeof(LveModel::Submesh));
+		header.meshletOffset = alignBlob(header.lodOffset + uint64_t{ header.lodCount } * sizeof(LveModel::Lod));
+
+		//write next to the cache and swap, a half written cache must never look valid
+		auto path = cachePath(sourcePath);
+		auto tempPath = path + ".tmp";
+		{
+			std::ofstream out{ tempPath, std::ios::binary | std::ios::trunc };
+			if (!out)
+			{
+				std::cerr << "mesh cache: can`t write " << tempPath << std::endl;
+				return;
+			}
+
+			const char padding[MESH_CACHE_BLOB_ALIGNMENT]{};
+			out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			out.write(padding, header.vertexOffset - sizeof(Header));
+			out.write(reinterpret_cast<const char*>(vertexData.data()), uint64_t{ header.vertexCount } * header.vertexStride);
+			out.write(padding, header.indexOffset - (header.vertexOffset + uint64_t{ header.vertexCount } * header.vertexStride));
+			out.write(reinterpret_cast<const char*>(indexData.data()), uint64_t{ header.indexCount } * header.indexStride);
+			out.write(padding, header.submeshOffset - (header.indexOffset + uint64_t{ header.indexCount } * header.indexStride));
+			out.write(reinterpret_cast<const char*>(submeshes.data()), submeshes.size() * sizeof(LveModel::Submesh));
+			out.write(padding, header.lodOffset - (header.submeshOffset + uint64_t{ header.submeshCount } * sizeof(LveModel::Submesh)));
+			out.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(LveModel::Lod));
+			out.write(padding, header.meshletOffset - (header.lodOffset + uint64_t{ header.lodCount } * sizeof(LveModel::Lod)));
+			out.write(reinterpret_cast<const char*>(builder.meshlets.data()), builder.meshlets.size() * sizeof(LveModel::Meshlet));
+			if (!out)
+			{
+				std::cerr << "mesh cache: failed to write " << tempPath << std::endl;
+				out.close();
+				std::filesystem::remove(tempPath);
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::cerr << "mesh cache: can`t replace " << path << ": " << error.message() << std::endl;
+			std::filesystem::remove(tempPath, error);
+		}
+	}
+
+}//namespace lve
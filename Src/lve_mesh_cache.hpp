@@ -0,0 +1,86 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "Helpers/MappedFile.hpp"
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+	// Binary copy of a loaded mesh stored next to its source as "<source>.lvemesh".
+	// Layout: Header, vertex blob, index blob, submesh table, lod table, meshlet table; blobs are 16 byte aligned and stored exactly
+	// as they are uploaded, so a warm load is a mapping plus one memcpy per blob into staging.
+	// The cache is stale when the format version, vertex format, processing flags or source size/mtime differ.
+	class LveMeshCache
+	{
+	public:
+		static constexpr uint32_t VERSION = 8;
+
+		// processing the cached mesh went through, has to match to use the cache
+		static constexpr uint32_t FLAG_OPTIMIZED = 1 << 0;
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t vertexStride;
+			uint32_t indexStride;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t flags;
+			uint32_t vertexFormat;
+			uint32_t submeshCount;
+			uint32_t lodCount;
+			uint32_t meshletCount;
+			// LveModel::Builder::closed
+			uint32_t closed;
+			uint64_t sourceSize;
+			int64_t sourceTime;
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			glm::vec3 sphereCenter;
+			float sphereRadius;
+			uint64_t vertexOffset;
+			uint64_t indexOffset;
+			uint64_t submeshOffset;
+			uint64_t lodOffset;
+			uint64_t meshletOffset;
+		};
+
+		static std::string cachePath(const std::string& sourcePath);
+
+		/// <param name="flags">Flags the mesh has to be processed with</param>
+		/// <returns>false if there is no cache, it is stale or its ranges are out of bounds</returns>
+		bool open(const std::string& sourcePath, LveModel::VertexFormat vertexFormat, uint32_t flags);
+
+		/// <summary>
+		/// Write the cache for sourcePath. Failures are reported and ignored, the cache is optional
+		/// </summary>
+		static void write(const std::string& sourcePath, const LveModel::Builder& builder, LveModel::VertexFormat vertexFormat);
+
+		const Header& getHeader() const { return *reinterpret_cast<const Header*>(file.data()); }
+		// encoded in header.vertexFormat
+		const void* getVertices() const;
+		// 16 or 32 bit, header.indexStride
+		const void* getIndices() const;
+		const LveModel::Submesh* getSubmeshes() const;
+		const LveModel::Lod* getLods() const;
+		const LveModel::Meshlet* getMeshlets() const;
+
+	private:
+		static bool sourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time);
+		/// <summary>
+		/// Submesh, lod and meshlet ranges stay inside the index, submesh and meshlet blobs and the indices
+		/// of every submesh and meshlet stay inside the vertex blob. One pass over the indices per submesh and meshlet
+		/// </summary>
+		bool rangesValid() const;
+
+		MappedFile file;
+	};
+
+}//namespace lve
@@ -0,0 +1,333 @@
+#include "lve_mesh_optimizer.hpp"
+
+#include "Helpers/TriangleAdjacency.hpp"
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace lve {
+
+	namespace {
+
+		// FIFO cache with timestamps: a vertex is cached while time - cacheTime <= cacheSize
+		struct CacheSimulation
+		{
+			std::vector<uint32_t> cacheTime;
+			uint32_t time;
+			uint32_t cacheSize;
+
+			CacheSimulation(size_t vertexCount, uint32_t cacheSize)
+				: cacheTime(vertexCount, 0), time(cacheSize + 1), cacheSize(cacheSize) {}
+
+			void reset()
+			{
+				// push everything out instead of clearing the array
+				time += cacheSize + 1;
+			}
+
+			/// <returns>1 on a cache miss</returns>
+			uint32_t access(uint32_t vertex)
+			{
+				if (time - cacheTime[vertex] > cacheSize)
+				{
+					cacheTime[vertex] = time++;
+					return 1;
+				}
+				return 0;
+			}
+		};
+
+		glm::vec3 position(const float* positions, size_t positionStride, uint32_t vertex)
+		{
+			auto p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + positionStride * vertex);
+			return { p[0], p[1], p[2] };
+		}
+
+	}//namespace
+
+	LveMeshOptimizer::VertexCacheStats LveMeshOptimizer::analyzeVertexCache(
+		const uint32_t* indices,
+		size_t indexCount,
+		size_t vertexCount,
+		uint32_t cacheSize
+	)
+	{
+		VertexCacheStats stats{};
+		if (indexCount == 0)
+			return stats;
+
+		CacheSimulation cache{ vertexCount, cacheSize };
+		std::vector<bool> referenced(vertexCount, false);
+		size_t referencedCount = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			stats.transformedVertices += cache.access(indices[i]);
+			if (!referenced[indices[i]])
+			{
+				referenced[indices[i]] = true;
+				referencedCount++;
+			}
+		}
+
+		stats.acmr = static_cast<float>(stats.transformedVertices) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(stats.transformedVertices) / static_cast<float>(referencedCount);
+		return stats;
+	}
+
+	void LveMeshOptimizer::optimizeVertexCache(
+		uint32_t* indices,
+		size_t indexCount,
+		size_t vertexCount,
+		uint32_t cacheSize
+	)
+	{
+		assert(indexCount % 3 == 0 && "optimizeVertexCache expects a triangle list");
+		if (indexCount == 0)
+			return;
+
+		TriangleAdjacency adjacency{ indices, indexCount, vertexCount };
+
+		// triangles not emitted yet around every vertex
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+		}
+
+		std::vector<bool> emitted(indexCount / 3, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+
+		CacheSimulation cache{ vertexCount, cacheSize };
+		size_t cursor = 0;
+
+		auto skipDeadEnd = [&]() -> int64_t {
+			while (!deadEndStack.empty())
+			{
+				auto vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[vertex] > 0)
+					return vertex;
+			}
+
+			for (; cursor < vertexCount; cursor++)
+			{
+				if (liveTriangles[cursor] > 0)
+					return static_cast<int64_t>(cursor);
+			}
+			return -1;
+		};
+
+		int64_t fanning = skipDeadEnd();
+		while (fanning >= 0)
+		{
+			candidates.clear();
+			auto vertex = static_cast<uint32_t>(fanning);
+			for (auto i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++)
+			{
+				auto triangle = adjacency.triangles[i];
+				if (emitted[triangle])
+					continue;
+
+				emitted[triangle] = true;
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					auto v = indices[triangle * 3 + corner];
+					result.push_back(v);
+					deadEndStack.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					cache.access(v);
+				}
+			}
+
+			// prefer the candidate that stays in the cache longest after fanning it
+			int64_t next = -1;
+			int64_t bestPriority = -1;
+			for (auto candidate : candidates)
+			{
+				if (liveTriangles[candidate] == 0)
+					continue;
+
+				int64_t priority = 0;
+				int64_t age = cache.time - cache.cacheTime[candidate];
+				if (age + 2 * static_cast<int64_t>(liveTriangles[candidate]) <= cacheSize)
+				{
+					priority = age;
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = candidate;
+				}
+			}
+
+			fanning = next >= 0 ? next : skipDeadEnd();
+		}
+
+		assert(result.size() == indexCount && "every triangle has to be emitted once");
+		std::memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+	}
+
+	void LveMeshOptimizer::optimizeOverdraw(
+		uint32_t* indices,
+		size_t indexCount,
+		const float* positions,
+		size_t positionStride,
+		size_t vertexCount,
+		float threshold,
+		uint32_t cacheSize
+	)
+	{
+		assert(indexCount % 3 == 0 && "optimizeOverdraw expects a triangle list");
+		auto triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		auto targetAcmr = threshold * analyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr;
+
+		// hard boundaries: triangles that miss with all three vertices, the cache restarts there anyway.
+		// Soft boundaries split further as soon as a cluster is cache efficient enough on its own
+		std::vector<uint32_t> clusters;
+		{
+			CacheSimulation cache{ vertexCount, cacheSize };
+			size_t clusterStart = 0;
+			size_t clusterMisses = 0;
+			for (size_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				uint32_t misses = 0;
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					misses += cache.access(indices[triangle * 3 + corner]);
+				}
+
+				if (misses == 3 && triangle > clusterStart)
+				{
+					clusters.push_back(static_cast<uint32_t>(clusterStart));
+					clusterStart = triangle;
+					clusterMisses = 0;
+				}
+				clusterMisses += misses;
+
+				auto clusterTriangles = triangle + 1 - clusterStart;
+				if (static_cast<float>(clusterMisses) <= targetAcmr * static_cast<float>(clusterTriangles))
+				{
+					clusters.push_back(static_cast<uint32_t>(clusterStart));
+					clusterStart = triangle + 1;
+					clusterMisses = 0;
+					cache.reset();
+				}
+			}
+			if (clusterStart < triangleCount)
+			{
+				clusters.push_back(static_cast<uint32_t>(clusterStart));
+			}
+		}
+
+		// area weighted centroids and normals
+		glm::dvec3 meshCentroid{ 0.0 };
+		double meshArea = 0.0;
+		std::vector<glm::dvec3> clusterCentroids(clusters.size(), glm::dvec3{ 0.0 });
+		std::vector<glm::dvec3> clusterNormals(clusters.size(), glm::dvec3{ 0.0 });
+		for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+		{
+			size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+			double clusterArea = 0.0;
+			for (size_t triangle = clusters[cluster]; triangle < end; triangle++)
+			{
+				glm::dvec3 a = position(positions, positionStride, indices[triangle * 3 + 0]);
+				glm::dvec3 b = position(positions, positionStride, indices[triangle * 3 + 1]);
+				glm::dvec3 c = position(positions, positionStride, indices[triangle * 3 + 2]);
+
+				auto normal = glm::cross(b - a, c - a);
+				auto area = glm::length(normal);
+				auto centroid = (a + b + c) / 3.0;
+
+				clusterCentroids[cluster] += centroid * area;
+				clusterNormals[cluster] += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroids[cluster];
+			meshArea += clusterArea;
+			if (clusterArea > 0.0)
+			{
+				clusterCentroids[cluster] /= clusterArea;
+			}
+		}
+		if (meshArea > 0.0)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		// clusters facing away from the center occlude the rest from most view directions
+		std::vector<double> sortKeys(clusters.size());
+		for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+		{
+			auto normalLength = glm::length(clusterNormals[cluster]);
+			auto normal = normalLength > 0.0 ? clusterNormals[cluster] / normalLength : glm::dvec3{ 0.0 };
+			sortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid, normal);
+		}
+
+		std::vector<uint32_t> order(clusters.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		for (auto cluster : order)
+		{
+			size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+			result.insert(result.end(), indices + clusters[cluster] * 3, indices + end * 3);
+		}
+
+		std::memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+	}
+
+	size_t LveMeshOptimizer::optimizeVertexFetch(
+		void* vertices,
+		size_t vertexCount,
+		size_t vertexSize,
+		uint32_t* indices,
+		size_t indexCount
+	)
+	{
+		constexpr uint32_t UNUSED = UINT32_MAX;
+
+		std::vector<uint32_t> remap(vertexCount, UNUSED);
+		uint32_t nextVertex = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			auto& target = remap[indices[i]];
+			if (target == UNUSED)
+			{
+				target = nextVertex++;
+			}
+			indices[i] = target;
+		}
+
+		auto bytes = static_cast<char*>(vertices);
+		std::vector<char> reordered(static_cast<size_t>(nextVertex) * vertexSize);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] != UNUSED)
+			{
+				std::memcpy(reordered.data() + remap[v] * vertexSize, bytes + v * vertexSize, vertexSize);
+			}
+		}
+
+		std::memcpy(vertices, reordered.data(), reordered.size());
+		return nextVertex;
+	}
+
+}//namespace lve
@@ -0,0 +1,74 @@
+#pragma once
+
+//std
+#include <cstddef>
+#include <cstdint>
+
+namespace lve {
+
+	// Index and vertex reordering for triangle lists, run offline on Builder data.
+	// Usual order: optimizeVertexCache, optimizeOverdraw, optimizeVertexFetch.
+	class LveMeshOptimizer
+	{
+	public:
+		// FIFO post-transform cache size the reordering and the stats assume
+		static constexpr uint32_t CACHE_SIZE = 16;
+
+		struct VertexCacheStats
+		{
+			// transformed vertices per triangle, 0.5 is the limit for regular grids, 3 the worst
+			float acmr = 0.f;
+			// transformed vertices per referenced vertex, 1 is perfect
+			float atvr = 0.f;
+			size_t transformedVertices = 0;
+		};
+
+		/// <summary>
+		/// Simulate a FIFO post-transform cache over the index stream
+		/// </summary>
+		static VertexCacheStats analyzeVertexCache(
+			const uint32_t* indices,
+			size_t indexCount,
+			size_t vertexCount,
+			uint32_t cacheSize = CACHE_SIZE
+		);
+
+		/// <summary>
+		/// Reorder triangles for post-transform cache locality (Tipsify, Sander et al. 2007)
+		/// </summary>
+		static void optimizeVertexCache(
+			uint32_t* indices,
+			size_t indexCount,
+			size_t vertexCount,
+			uint32_t cacheSize = CACHE_SIZE
+		);
+
+		/// <summary>
+		/// Reorder clusters of cache optimized triangles so outer facing ones are drawn first.
+		/// Clusters end where the local ACMR stays within threshold times the ACMR of the input
+		/// </summary>
+		/// <param name="positionStride">bytes between positions, 3 floats each</param>
+		static void optimizeOverdraw(
+			uint32_t* indices,
+			size_t indexCount,
+			const float* positions,
+			size_t positionStride,
+			size_t vertexCount,
+			float threshold = 1.05f,
+			uint32_t cacheSize = CACHE_SIZE
+		);
+
+		/// <summary>
+		/// Reorder vertices in order of first use and remap indices. Unused vertices are dropped
+		/// </summary>
+		/// <returns>new vertex count</returns>
+		static size_t optimizeVertexFetch(
+			void* vertices,
+			size_t vertexCount,
+			size_t vertexSize,
+			uint32_t* indices,
+			size_t indexCount
+		);
+	};
+
+}//namespace lve
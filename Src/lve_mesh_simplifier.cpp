@@ -0,0 +1,376 @@
+#include "lve_mesh_simplifier.hpp"
+
+#include "Helpers/VertexDeduplicator.hpp"
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+
+		// symmetric 4x4 error quadric, sum of squared distances to the planes it was built from
+		struct Quadric
+		{
+			double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+			double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+			double c = 0.0;
+			// area the planes were weighted with
+			double weight = 0.0;
+
+			static Quadric fromPlane(const glm::dvec3& n, double d, double weight)
+			{
+				Quadric q;
+				q.a00 = weight * n.x * n.x; q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z;
+				q.a11 = weight * n.y * n.y; q.a12 = weight * n.y * n.z;
+				q.a22 = weight * n.z * n.z;
+				q.b0 = weight * n.x * d; q.b1 = weight * n.y * d; q.b2 = weight * n.z * d;
+				q.c = weight * d * d;
+				q.weight = weight;
+				return q;
+			}
+
+			Quadric& operator+=(const Quadric& o)
+			{
+				a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+				b0 += o.b0; b1 += o.b1; b2 += o.b2;
+				c += o.c;
+				weight += o.weight;
+				return *this;
+			}
+
+			// weighted mean of squared distances from p to the planes
+			double error(const glm::dvec3& p) const
+			{
+				double e =
+					a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+					2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+					2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) +
+					c;
+				return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			double error;
+		};
+
+		uint64_t edgeKey(uint32_t a, uint32_t b)
+		{
+			return a < b ? (uint64_t{ a } << 32) | b : (uint64_t{ b } << 32) | a;
+		}
+
+	}//namespace
+
+	LveMeshSimplifier::LveMeshSimplifier(const std::vector<LveModel::Vertex>& vertices) : vertices(vertices)
+	{
+		vertexGroup.resize(vertices.size());
+		VertexDeduplicator<glm::vec3> uniquePositions{ vertices.size() };
+		for (size_t v = 0; v < vertices.size(); v++)
+		{
+			vertexGroup[v] = uniquePositions.insert(vertices[v].position, groupPositions);
+		}
+
+		groupOffsets.assign(groupPositions.size() + 1, 0);
+		for (auto group : vertexGroup)
+		{
+			groupOffsets[group + 1]++;
+		}
+		std::partial_sum(groupOffsets.begin(), groupOffsets.end(), groupOffsets.begin());
+
+		std::vector<uint32_t> fill(groupOffsets.begin(), groupOffsets.end() - 1);
+		groupVertices.resize(vertices.size());
+		for (size_t v = 0; v < vertices.size(); v++)
+		{
+			groupVertices[fill[vertexGroup[v]]++] = static_cast<uint32_t>(v);
+		}
+	}
+
+	std::vector<uint32_t> LveMeshSimplifier::simplify(
+		const uint32_t* indices,
+		size_t indexCount,
+		size_t targetIndexCount,
+		float& resultError
+	) const
+	{
+		assert(indexCount % 3 == 0 && "simplify expects a triangle list");
+		auto groupCount = groupPositions.size();
+
+		// corners keep the source vertex, triangles the group each corner was moved to
+		std::vector<uint32_t> corners(indices, indices + indexCount);
+		std::vector<uint32_t> triangles(indexCount);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			triangles[i] = vertexGroup[indices[i]];
+		}
+
+		auto position = [this](uint32_t group) { return glm::dvec3{ groupPositions[group] }; };
+
+		// quadrics order the collapses, the source planes a group has moved across bound the error:
+		// the quadric only gives the mean squared distance, the plane list the worst one
+		std::vector<Quadric> quadrics(groupCount);
+		std::vector<glm::dvec4> planes;
+		std::vector<std::vector<uint32_t>> groupPlanes(groupCount);
+		for (size_t t = 0; t < indexCount; t += 3)
+		{
+			auto p0 = position(triangles[t + 0]);
+			auto normal = glm::cross(position(triangles[t + 1]) - p0, position(triangles[t + 2]) - p0);
+			auto length = glm::length(normal);
+			if (length == 0.0)
+				continue;
+
+			normal /= length;
+			auto quadric = Quadric::fromPlane(normal, -glm::dot(normal, p0), length * 0.5);
+			auto plane = static_cast<uint32_t>(planes.size());
+			planes.push_back(glm::dvec4{ normal, -glm::dot(normal, p0) });
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				quadrics[triangles[t + corner]] += quadric;
+				groupPlanes[triangles[t + corner]].push_back(plane);
+			}
+		}
+
+		// edges without exactly two triangles are borders or non manifold, their vertices stay
+		std::vector<bool> locked(groupCount, false);
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeTriangles;
+			edgeTriangles.reserve(indexCount);
+			for (size_t t = 0; t < indexCount; t += 3)
+			{
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					edgeTriangles[edgeKey(triangles[t + corner], triangles[t + (corner + 1) % 3])]++;
+				}
+			}
+			for (const auto& [key, count] : edgeTriangles)
+			{
+				if (count != 2)
+				{
+					locked[static_cast<uint32_t>(key >> 32)] = true;
+					locked[static_cast<uint32_t>(key)] = true;
+				}
+			}
+		}
+
+		std::vector<uint32_t> adjacencyOffsets;
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+		std::vector<uint64_t> edges;
+		std::vector<uint32_t> remap(groupCount);
+		std::vector<bool> touched(groupCount);
+		std::vector<uint32_t> stamp(groupCount, 0);
+		uint32_t currentStamp = 0;
+
+		double maxError = 0.0;
+		size_t triangleCount = indexCount / 3;
+		auto targetTriangles = targetIndexCount / 3;
+
+		// every pass collapses an independent set of the cheapest edges
+		while (triangleCount > targetTriangles)
+		{
+			adjacencyOffsets.assign(groupCount + 1, 0);
+			for (auto group : triangles)
+			{
+				adjacencyOffsets[group + 1]++;
+			}
+			std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			adjacency.resize(triangles.size());
+			for (size_t i = 0; i < triangles.size(); i++)
+			{
+				adjacency[fill[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+
+			edges.clear();
+			for (size_t t = 0; t < triangles.size(); t += 3)
+			{
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					edges.push_back(edgeKey(triangles[t + corner], triangles[t + (corner + 1) % 3]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			collapses.clear();
+			for (auto key : edges)
+			{
+				auto a = static_cast<uint32_t>(key >> 32);
+				auto b = static_cast<uint32_t>(key);
+
+				Collapse best{ 0, 0, HUGE_VAL };
+				for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } })
+				{
+					if (locked[from])
+						continue;
+
+					auto merged = quadrics[from];
+					merged += quadrics[to];
+					auto error = merged.error(position(to));
+					if (error < best.error)
+					{
+						best = { from, to, error };
+					}
+				}
+				if (best.error != HUGE_VAL)
+				{
+					collapses.push_back(best);
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.error < r.error; });
+
+			std::iota(remap.begin(), remap.end(), 0u);
+			std::fill(touched.begin(), touched.end(), false);
+
+			auto canCollapse = [&](uint32_t from, uint32_t to) {
+				// link condition: from and to may only share the two vertices of the triangles around their edge
+				currentStamp++;
+				for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+				{
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						stamp[triangles[adjacency[i] * 3 + corner]] = currentStamp;
+					}
+				}
+				uint32_t shared = 0;
+				currentStamp++;
+				for (auto i = adjacencyOffsets[to]; i < adjacencyOffsets[to + 1]; i++)
+				{
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						auto group = triangles[adjacency[i] * 3 + corner];
+						if (group != to && group != from && stamp[group] == currentStamp - 1)
+						{
+							stamp[group] = currentStamp;
+							shared++;
+						}
+					}
+				}
+				if (shared > 2)
+					return false;
+
+				// triangles that stay must not turn over or rotate by more than ~75 degrees
+				auto target = position(to);
+				for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+				{
+					auto t = adjacency[i] * 3;
+					if (triangles[t] == to || triangles[t + 1] == to || triangles[t + 2] == to)
+						continue;
+
+					glm::dvec3 before[3], after[3];
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						before[corner] = position(triangles[t + corner]);
+						after[corner] = triangles[t + corner] == from ? target : before[corner];
+					}
+					auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					auto normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					if (glm::dot(normalBefore, normalAfter) <= 0.25 * glm::length(normalBefore) * glm::length(normalAfter))
+						return false;
+				}
+				return true;
+			};
+
+			size_t collapsed = 0;
+			for (const auto& collapse : collapses)
+			{
+				if (triangleCount <= targetTriangles)
+					break;
+				if (touched[collapse.from] || touched[collapse.to])
+					continue;
+				if (!canCollapse(collapse.from, collapse.to))
+					continue;
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to] += quadrics[collapse.from];
+				auto target = position(collapse.to);
+				auto& fromPlanes = groupPlanes[collapse.from];
+				for (auto plane : fromPlanes)
+				{
+					maxError = std::max(maxError, std::abs(glm::dot(glm::dvec3{ planes[plane] }, target) + planes[plane].w));
+				}
+				auto& toPlanes = groupPlanes[collapse.to];
+				toPlanes.insert(toPlanes.end(), fromPlanes.begin(), fromPlanes.end());
+				std::sort(toPlanes.begin(), toPlanes.end());
+				toPlanes.erase(std::unique(toPlanes.begin(), toPlanes.end()), toPlanes.end());
+				std::vector<uint32_t>().swap(fromPlanes);
+				collapsed++;
+
+				// triangles around from change, flip tests against them are stale for the rest of the pass
+				for (auto i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; i++)
+				{
+					auto t = adjacency[i] * 3;
+					bool removed = false;
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						touched[triangles[t + corner]] = true;
+						removed |= triangles[t + corner] == collapse.to;
+					}
+					triangleCount -= removed ? 1 : 0;
+				}
+			}
+
+			if (collapsed == 0)
+				break;
+
+			size_t write = 0;
+			for (size_t t = 0; t < triangles.size(); t += 3)
+			{
+				uint32_t moved[3] = { remap[triangles[t]], remap[triangles[t + 1]], remap[triangles[t + 2]] };
+				if (moved[0] == moved[1] || moved[1] == moved[2] || moved[0] == moved[2])
+					continue;
+
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					triangles[write + corner] = moved[corner];
+					corners[write + corner] = corners[t + corner];
+				}
+				write += 3;
+			}
+			triangles.resize(write);
+			corners.resize(write);
+		}
+
+		resultError = static_cast<float>(maxError);
+
+		std::vector<uint32_t> result(triangles.size());
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			result[i] = selectVertex(corners[i], triangles[i]);
+		}
+		return result;
+	}
+
+	uint32_t LveMeshSimplifier::selectVertex(uint32_t original, uint32_t group) const
+	{
+		if (vertexGroup[original] == group)
+			return original;
+
+		// keeps uv seams and hard edges on the side the corner came from
+		const auto& source = vertices[original];
+		uint32_t best = groupVertices[groupOffsets[group]];
+		float bestDistance = HUGE_VALF;
+		for (auto i = groupOffsets[group]; i < groupOffsets[group + 1]; i++)
+		{
+			const auto& candidate = vertices[groupVertices[i]];
+			auto normal = candidate.normal - source.normal;
+			auto color = candidate.color - source.color;
+			auto uv = candidate.uv - source.uv;
+			float distance = glm::dot(normal, normal) + glm::dot(color, color) + glm::dot(uv, uv);
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				best = groupVertices[i];
+			}
+		}
+		return best;
+	}
+
+}//namespace lve
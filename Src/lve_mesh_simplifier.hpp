@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Quadric error mesh simplification (Garland & Heckbert) with half edge collapses:
+	// a vertex only ever moves onto a neighbour, so every level reuses the vertices of the
+	// source mesh and all levels can share one vertex buffer.
+	// Collapses work on positions; vertices that share a position (uv seams, flat shading) move
+	// together and every corner picks the vertex at the new position with the closest normal and uv.
+	// Mesh borders and non manifold edges are kept as they are.
+	class LveMeshSimplifier
+	{
+	public:
+		LveMeshSimplifier(const std::vector<LveModel::Vertex>& vertices);
+
+		/// <summary>
+		/// Simplify a triangle list until it has at most targetIndexCount indices or no collapse is possible
+		/// </summary>
+		/// <param name="resultError">max distance of a moved position to the source triangles it moved across, object space units</param>
+		/// <returns>indices of the simplified triangle list</returns>
+		std::vector<uint32_t> simplify(
+			const uint32_t* indices,
+			size_t indexCount,
+			size_t targetIndexCount,
+			float& resultError
+		) const;
+
+	private:
+		uint32_t selectVertex(uint32_t original, uint32_t group) const;
+
+		const std::vector<LveModel::Vertex>& vertices;
+
+		// vertices with the same position form a group
+		std::vector<uint32_t> vertexGroup;
+		std::vector<glm::vec3> groupPositions;
+		// vertices of every group, groupVertices[groupOffsets[g]..groupOffsets[g + 1])
+		std::vector<uint32_t> groupOffsets;
+		std::vector<uint32_t> groupVertices;
+	};
+
+}//namespace lve
@@ -0,0 +1,328 @@
+#include "lve_meshlets.hpp"
+
+#include "Helpers/TriangleAdjacency.hpp"
+#include "Helpers/VertexDeduplicator.hpp"
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+
+		glm::vec3 position(const float* positions, size_t positionStride, uint32_t vertex)
+		{
+			auto p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + positionStride * vertex);
+			return { p[0], p[1], p[2] };
+		}
+
+	}//namespace
+
+	std::vector<LveModel::Meshlet> LveMeshlets::build(
+		uint32_t* indices,
+		size_t indexCount,
+		const float* positions,
+		size_t positionStride,
+		size_t vertexCount
+	)
+	{
+		assert(indexCount % 3 == 0 && "build expects a triangle list");
+		constexpr uint32_t NONE = UINT32_MAX;
+
+		std::vector<LveModel::Meshlet> meshlets;
+		auto triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return meshlets;
+
+		// meshlets grow over shared positions, flat shaded meshes share no vertices between triangles
+		std::vector<uint32_t> positionIndices(indexCount);
+		{
+			std::vector<glm::vec3> uniquePositions;
+			std::vector<uint32_t> remap(vertexCount);
+			VertexDeduplicator<glm::vec3> deduplicator{ vertexCount };
+			for (size_t v = 0; v < vertexCount; v++)
+			{
+				remap[v] = deduplicator.insert(position(positions, positionStride, static_cast<uint32_t>(v)), uniquePositions);
+			}
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				positionIndices[i] = remap[indices[i]];
+			}
+		}
+		TriangleAdjacency adjacency{ positionIndices.data(), indexCount, vertexCount };
+		std::vector<bool> emitted(triangleCount, false);
+		// meshlet that already holds a vertex
+		std::vector<uint32_t> vertexMeshlet(vertexCount, NONE);
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+
+		auto triangleCentroid = [&](uint32_t triangle) {
+			return (
+				position(positions, positionStride, indices[triangle * 3 + 0]) +
+				position(positions, positionStride, indices[triangle * 3 + 1]) +
+				position(positions, positionStride, indices[triangle * 3 + 2])
+			) / 3.f;
+		};
+
+		size_t cursor = 0;
+		while (true)
+		{
+			// seeds follow the input order, that keeps the post-transform cache order of the optimizer
+			while (cursor < triangleCount && emitted[cursor])
+			{
+				cursor++;
+			}
+			if (cursor == triangleCount)
+				break;
+
+			auto id = static_cast<uint32_t>(meshlets.size());
+			LveModel::Meshlet meshlet{};
+			meshlet.firstIndex = static_cast<uint32_t>(result.size());
+			uint32_t meshletVertices = 0;
+			glm::vec3 positionSum{ 0.f };
+			candidates.clear();
+
+			auto next = static_cast<uint32_t>(cursor);
+			while (next != NONE)
+			{
+				emitted[next] = true;
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					auto vertex = indices[next * 3 + corner];
+					result.push_back(vertex);
+					if (vertexMeshlet[vertex] == id)
+						continue;
+
+					vertexMeshlet[vertex] = id;
+					meshletVertices++;
+					positionSum += position(positions, positionStride, vertex);
+					auto positionIndex = positionIndices[next * 3 + corner];
+					for (auto i = adjacency.offsets[positionIndex]; i < adjacency.offsets[positionIndex + 1]; i++)
+					{
+						if (!emitted[adjacency.triangles[i]])
+						{
+							candidates.push_back(adjacency.triangles[i]);
+						}
+					}
+				}
+				meshlet.indexCount += 3;
+				if (meshlet.indexCount / 3 == MAX_TRIANGLES)
+					break;
+
+				// fewest new vertices first, then the triangle closest to the meshlet center
+				auto center = positionSum / static_cast<float>(meshletVertices);
+				next = NONE;
+				uint32_t bestNewVertices = 4;
+				float bestDistance = 0.f;
+				size_t write = 0;
+				for (auto candidate : candidates)
+				{
+					if (emitted[candidate])
+						continue;
+					candidates[write++] = candidate;
+
+					uint32_t newVertices = 0;
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						newVertices += vertexMeshlet[indices[candidate * 3 + corner]] == id ? 0 : 1;
+					}
+					if (meshletVertices + newVertices > MAX_VERTICES || newVertices > bestNewVertices)
+						continue;
+
+					auto offset = triangleCentroid(candidate) - center;
+					float distance = glm::dot(offset, offset);
+					if (newVertices < bestNewVertices || distance < bestDistance)
+					{
+						next = candidate;
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+					}
+				}
+				candidates.resize(write);
+			}
+
+			meshlets.push_back(meshlet);
+		}
+
+		assert(result.size() == indexCount && "every triangle has to be emitted once");
+		std::memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+		return meshlets;
+	}
+
+	void LveMeshlets::computeBounds(
+		LveModel::Meshlet& meshlet,
+		const uint32_t* indices,
+		const float* positions,
+		size_t positionStride,
+		float orientation
+	)
+	{
+		auto first = indices + meshlet.firstIndex;
+		glm::vec3 min = position(positions, positionStride, first[0]);
+		glm::vec3 max = min;
+		for (uint32_t i = 1; i < meshlet.indexCount; i++)
+		{
+			auto p = position(positions, positionStride, first[i]);
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+
+		meshlet.center = (min + max) * 0.5f;
+		meshlet.radius = 0.f;
+		for (uint32_t i = 0; i < meshlet.indexCount; i++)
+		{
+			meshlet.radius = std::max(meshlet.radius, glm::length(position(positions, positionStride, first[i]) - meshlet.center));
+		}
+
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.indexCount / 3);
+		glm::vec3 normalSum{ 0.f };
+		for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+		{
+			auto a = position(positions, positionStride, first[i + 0]);
+			auto normal = glm::cross(position(positions, positionStride, first[i + 1]) - a, position(positions, positionStride, first[i + 2]) - a);
+			float length = glm::length(normal);
+			if (length == 0.f)
+				continue;
+
+			normals.push_back(normal * (orientation / length));
+			normalSum += normals.back();
+		}
+
+		// coneCutoff >= 1 - the cone is too wide, never culled
+		meshlet.coneAxis = glm::vec3{ 0.f, 0.f, 1.f };
+		meshlet.coneCutoff = 1.f;
+		float sumLength = glm::length(normalSum);
+		if (sumLength == 0.f)
+			return;
+
+		meshlet.coneAxis = normalSum / sumLength;
+		float minDot = 1.f;
+		for (const auto& normal : normals)
+		{
+			minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normal));
+		}
+
+		// all normals within acos(minDot) of the axis: every triangle faces away from views inside
+		// asin(minDot) of the axis, cos of that angle is sqrt(1 - minDot^2)
+		if (minDot > 0.f)
+		{
+			meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		}
+	}
+
+	float LveMeshlets::surfaceOrientation(
+		const uint32_t* indices,
+		size_t indexCount,
+		const float* positions,
+		size_t positionStride,
+		size_t vertexCount
+	)
+	{
+		if (indexCount == 0)
+			return 0.f;
+
+		// vertices split along uv seams or hard edges still close the surface
+		std::vector<glm::vec3> uniquePositions;
+		std::vector<uint32_t> remap(vertexCount);
+		VertexDeduplicator<glm::vec3> deduplicator{ vertexCount };
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			remap[v] = deduplicator.insert(position(positions, positionStride, static_cast<uint32_t>(v)), uniquePositions);
+		}
+
+		// closed and consistently wound: every edge is used once in each direction
+		std::unordered_map<uint64_t, int32_t> edges;
+		edges.reserve(indexCount);
+		double volume = 0.0;
+		for (size_t t = 0; t < indexCount; t += 3)
+		{
+			uint32_t corners[3] = { remap[indices[t]], remap[indices[t + 1]], remap[indices[t + 2]] };
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				auto a = corners[corner];
+				auto b = corners[(corner + 1) % 3];
+				if (a == b)
+					continue;
+
+				edges[a < b ? (uint64_t{ a } << 32) | b : (uint64_t{ b } << 32) | a] += a < b ? 1 : -1;
+			}
+
+			glm::dvec3 a = uniquePositions[corners[0]];
+			glm::dvec3 b = uniquePositions[corners[1]];
+			glm::dvec3 c = uniquePositions[corners[2]];
+			volume += glm::dot(a, glm::cross(b, c));
+		}
+
+		for (const auto& [key, balance] : edges)
+		{
+			if (balance != 0)
+				return 0.f;
+		}
+		if (volume == 0.0)
+			return 0.f;
+
+		return volume > 0.0 ? 1.f : -1.f;
+	}
+
+	LveMeshlets::CullContext LveMeshlets::makeCullContext(
+		const glm::mat4& viewProjection,
+		const glm::mat4& modelMatrix,
+		const glm::vec3& cameraPosition,
+		const LveModel& model
+	)
+	{
+		CullContext context{};
+		context.frustum = LveFrustum::fromMatrix(viewProjection * modelMatrix);
+		context.cameraPosition = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.f));
+
+		// from inside a closed mesh its back faces are the visible ones
+		bool cameraInside =
+			glm::all(glm::greaterThanEqual(context.cameraPosition, model.getBoundsMin())) &&
+			glm::all(glm::lessThanEqual(context.cameraPosition, model.getBoundsMax()));
+		context.coneCulling = model.isClosed() && !cameraInside;
+		return context;
+	}
+
+	bool LveMeshlets::isVisible(const LveModel::Meshlet& meshlet, const CullContext& context)
+	{
+		if (!context.frustum.intersectsSphere(meshlet.center, meshlet.radius))
+			return false;
+
+		if (context.coneCulling && meshlet.coneCutoff < 1.f)
+		{
+			auto view = meshlet.center - context.cameraPosition;
+			if (glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(view) + meshlet.radius)
+				return false;
+		}
+		return true;
+	}
+
+	void LveMeshlets::cull(
+		std::span<const LveModel::Meshlet> meshlets,
+		const LveModel::Lod& lod,
+		const CullContext& context,
+		std::vector<uint32_t>& visibleMeshlets,
+		CullStats& stats
+	)
+	{
+		assert(lod.firstMeshlet + lod.meshletCount <= meshlets.size() && "lod meshlets out of range");
+		visibleMeshlets.clear();
+		for (auto i = lod.firstMeshlet; i < lod.firstMeshlet + lod.meshletCount; i++)
+		{
+			if (isVisible(meshlets[i], context))
+			{
+				visibleMeshlets.push_back(i);
+			}
+		}
+
+		stats.visible += static_cast<uint32_t>(visibleMeshlets.size());
+		stats.culled += lod.meshletCount - static_cast<uint32_t>(visibleMeshlets.size());
+	}
+
+}//namespace lve
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_frustum.hpp"
+
+//std
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lve {
+
+	// Meshlets are small clusters of triangles that are culled on their own before drawing.
+	// Without mesh shaders a meshlet is a range of the index buffer, build() reorders triangles so
+	// every meshlet is contiguous and neighbouring visible meshlets merge into one draw.
+	class LveMeshlets
+	{
+	public:
+		static constexpr uint32_t MAX_VERTICES = 64;
+		static constexpr uint32_t MAX_TRIANGLES = 124;
+
+		struct CullContext
+		{
+			// object space
+			LveFrustum frustum;
+			glm::vec3 cameraPosition;
+			// back facing meshlets are only hidden on closed meshes seen from outside
+			bool coneCulling;
+		};
+
+		struct CullStats
+		{
+			uint32_t visible = 0;
+			uint32_t culled = 0;
+			uint32_t drawCalls = 0;
+		};
+
+		/// <summary>
+		/// Partition a triangle list into meshlets of at most MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+		/// Meshlets grow over shared vertices first, then towards their center, so they stay compact
+		/// </summary>
+		/// <param name="indices">reordered so every meshlet is a contiguous range</param>
+		/// <returns>meshlets with firstIndex relative to indices and vertexOffset 0, bounds not computed</returns>
+		static std::vector<LveModel::Meshlet> build(
+			uint32_t* indices,
+			size_t indexCount,
+			const float* positions,
+			size_t positionStride,
+			size_t vertexCount
+		);
+
+		/// <summary>
+		/// Bounding sphere and normal cone of the meshlet triangles
+		/// </summary>
+		/// <param name="indices">the indices firstIndex points into</param>
+		/// <param name="orientation">-1 for closed meshes with inward facing triangles, flips the cone</param>
+		static void computeBounds(
+			LveModel::Meshlet& meshlet,
+			const uint32_t* indices,
+			const float* positions,
+			size_t positionStride,
+			float orientation = 1.f
+		);
+
+		/// <returns>1 for a closed surface with counter clockwise outside faces, -1 for an inside out one, 0 if it has borders</returns>
+		static float surfaceOrientation(
+			const uint32_t* indices,
+			size_t indexCount,
+			const float* positions,
+			size_t positionStride,
+			size_t vertexCount
+		);
+
+		static CullContext makeCullContext(
+			const glm::mat4& viewProjection,
+			const glm::mat4& modelMatrix,
+			const glm::vec3& cameraPosition,
+			const LveModel& model
+		);
+
+		/// <returns>false if the meshlet is outside the frustum or all its triangles face away from the camera</returns>
+		static bool isVisible(const LveModel::Meshlet& meshlet, const CullContext& context);
+
+		/// <summary>
+		/// Indices of the visible meshlets of lod, for LveModel::drawMeshlets.
+		/// Needs no model, only its meshlets, so the culling math runs without a device
+		/// </summary>
+		/// <param name="meshlets">all meshlets of the model, lod points into them</param>
+		static void cull(
+			std::span<const LveModel::Meshlet> meshlets,
+			const LveModel::Lod& lod,
+			const CullContext& context,
+			std::vector<uint32_t>& visibleMeshlets,
+			CullStats& stats
+		);
+	};
+
+}//namespace lve
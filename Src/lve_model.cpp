@@ -1,150 +1,245 @@
 #include "lve_model.hpp"
 
-#include "lve_utils.hpp"
-
-//libs
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include "lve_mesh_cache.hpp"
+#include "lve_uploader.hpp"
+#include "lve_obj_parser.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_simplifier.hpp"
+#include "lve_meshlets.hpp"
+#include "lve_vertex_quantizer.hpp"
+#include "Helpers/VertexDeduplicator.hpp"
 
 //std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
+#include <numeric>
 #include <unordered_map>
 
 #ifndef ENGINE_DIR
 #define ENGINE_DIR "../../../" 
 #endif // !ENGINE_DIR
 
-namespace std {
-	template<>
-	struct hash<lve::LveModel::Vertex>
-	{
-		size_t operator()(lve::LveModel::Vertex const& vertex) const {
-			size_t seed = 0;
-			lve::hash_combine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+namespace lve {
+
+	LveModel::LveModel(LveDevice& lveDevice, const LveModel::Builder& builder, VertexFormat vertexFormat)
+		: lveDevice(lveDevice), vertexFormat(vertexFormat) {
+		boundsMin = builder.boundsMin;
+		boundsMax = builder.boundsMax;
+		sphereCenter = builder.sphereCenter;
+		sphereRadius = builder.sphereRadius;
+		positionDecode = LveVertexQuantizer::getPositionDecode(vertexFormat, boundsMin, boundsMax);
+
+		auto vertexData = LveVertexQuantizer::encode(vertexFormat, builder.vertices.data(), builder.vertices.size(), boundsMin, boundsMax);
+		createVertexBuffers(vertexData.data(), static_cast<uint32_t>(builder.vertices.size()));
+
+		auto indexType = builder.getIndexType();
+		auto indexData = builder.packIndices(indexType);
+		createIndexBuffers(indexData.data(), static_cast<uint32_t>(builder.indices.size()), indexType);
 
-			return seed;
+		submeshes = builder.submeshes;
+		if (submeshes.empty())
+		{
+			submeshes.push_back({ 0, indexCount, 0 });
 		}
-	};
-}
 
-namespace lve {
+		lods = builder.lods;
+		if (lods.empty())
+		{
+			lods.push_back({ 0, static_cast<uint32_t>(submeshes.size()), 0.f });
+		}
 
-	LveModel::LveModel(LveDevice& lveDevice, const LveModel::Builder& builder) : lveDevice(lveDevice) {
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
+		meshlets = builder.meshlets;
+		closed = builder.closed;
+		rebaseRanges();
 	}
 
-	LveModel::~LveModel() { }
-
-	std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice& device, const std::string& filepath) {
-		Builder builder{};
-		builder.loadModel(ENGINE_DIR + filepath);
+	LveModel::LveModel(LveDevice& lveDevice, const LveMeshCache& meshCache) : lveDevice(lveDevice) {
+		auto& header = meshCache.getHeader();
+		vertexFormat = static_cast<VertexFormat>(header.vertexFormat);
+		positionDecode = LveVertexQuantizer::getPositionDecode(vertexFormat, header.boundsMin, header.boundsMax);
+		createVertexBuffers(meshCache.getVertices(), header.vertexCount);
+		createIndexBuffers(meshCache.getIndices(), header.indexCount, header.indexStride == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+		submeshes.assign(meshCache.getSubmeshes(), meshCache.getSubmeshes() + header.submeshCount);
+		lods.assign(meshCache.getLods(), meshCache.getLods() + header.lodCount);
+		meshlets.assign(meshCache.getMeshlets(), meshCache.getMeshlets() + header.meshletCount);
+		closed = header.closed != 0;
+		boundsMin = header.boundsMin;
+		boundsMax = header.boundsMax;
+		sphereCenter = header.sphereCenter;
+		sphereRadius = header.sphereRadius;
+		rebaseRanges();
+	}
 
-		return std::make_unique<LveModel>(device, builder);
+	LveModel::~LveModel() {
+		lveDevice.getGeometryArena().free(vertexRange);
+		lveDevice.getGeometryArena().free(indexRange);
 	}
 
-	void LveModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
-		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3");
+	std::unique_ptr<LveModel> LveModel::createModelFromFile(
+		LveDevice& device,
+		const std::string& filepath,
+		VertexFormat vertexFormat,
+		bool optimize
+	) {
+		auto sourcePath = ENGINE_DIR + filepath;
 
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
+		LveMeshCache meshCache{};
+		if (meshCache.open(sourcePath, vertexFormat, optimize ? LveMeshCache::FLAG_OPTIMIZED : 0))
+		{
+			return std::make_unique<LveModel>(device, meshCache);
+		}
 
-		LveBuffer stagingBuffer{
-			lveDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+		Builder builder{};
+		builder.loadModel(sourcePath);
+		if (optimize)
+		{
+			builder.optimize();
+		}
+		builder.generateLods();
+		builder.splitForShortIndices();
+		builder.buildMeshlets();
+		LveMeshCache::write(sourcePath, builder, vertexFormat);
+
+		return std::make_unique<LveModel>(device, builder, vertexFormat);
+	}
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
+	void LveModel::createVertexBuffers(const void* vertexData, uint32_t vertexCount) {
+		this->vertexCount = vertexCount;
+		assert(vertexCount >= 3 && "Vertex count must be at least 3");
 
-		vertexBuffer = std::make_unique<LveBuffer>(
-			lveDevice,
-			vertexSize,
+		vertexRange = lveDevice.getGeometryArena().allocate(
+			LveGeometryArena::Usage::Vertex,
+			LveVertexQuantizer::vertexStride(vertexFormat),
 			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-			);
-
-		lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+			vertexData
+		);
 	}
 
-	void LveModel::createIndexBuffers(const std::vector<uint32_t>& indices) {
-		indexCount = static_cast<uint32_t>(indices.size());
+	void LveModel::createIndexBuffers(const void* indexData, uint32_t indexCount, VkIndexType indexType) {
+		this->indexCount = indexCount;
+		this->indexType = indexType;
 		hasIndexBuffer = indexCount > 0;
 
 		if (!hasIndexBuffer)
 			return;
 
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		LveBuffer stagingBuffer{
-			lveDevice,
-			indexSize,
+		indexRange = lveDevice.getGeometryArena().allocate(
+			LveGeometryArena::Usage::Index,
+			indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t),
 			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
-
-		indexBuffer = std::make_unique<LveBuffer>(
-			lveDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-			);
+			indexData
+		);
+	}
 
-		lveDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+	void LveModel::rebaseRanges() {
+		auto vertexBase = static_cast<int32_t>(vertexRange.first);
+		for (auto& submesh : submeshes)
+		{
+			submesh.firstIndex += indexRange.first;
+			submesh.vertexOffset += vertexBase;
+		}
+		for (auto& meshlet : meshlets)
+		{
+			meshlet.firstIndex += indexRange.first;
+			meshlet.vertexOffset += vertexBase;
+		}
 	}
 
-	void LveModel::draw(VkCommandBuffer commandBuffer) {
+	void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) {
+		assert(lod < lods.size() && "lod out of range");
 		if (hasIndexBuffer)
 		{
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			const auto& level = lods[lod];
+			for (auto i = level.firstSubmesh; i < level.firstSubmesh + level.submeshCount; i++)
+			{
+				const auto& submesh = submeshes[i];
+				vkCmdDrawIndexed(commandBuffer, submesh.indexCount, instanceCount, submesh.firstIndex, submesh.vertexOffset, firstInstance);
+			}
 		}
 		else
 		{
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, vertexRange.first, firstInstance);
+		}
+	}
+
+	uint32_t LveModel::drawMeshlets(VkCommandBuffer commandBuffer, const std::vector<uint32_t>& meshletIndices) {
+		assert(hasIndexBuffer && "meshlets are index ranges");
+
+		uint32_t drawCalls = 0;
+		size_t i = 0;
+		while (i < meshletIndices.size())
+		{
+			const auto& first = meshlets[meshletIndices[i]];
+			uint32_t indexCount = first.indexCount;
+			for (i++; i < meshletIndices.size(); i++)
+			{
+				const auto& meshlet = meshlets[meshletIndices[i]];
+				if (meshlet.firstIndex != first.firstIndex + indexCount || meshlet.vertexOffset != first.vertexOffset)
+					break;
+
+				indexCount += meshlet.indexCount;
+			}
+
+			vkCmdDrawIndexed(commandBuffer, indexCount, 1, first.firstIndex, first.vertexOffset, 0);
+			drawCalls++;
 		}
+		return drawCalls;
 	}
 
 	void LveModel::bind(VkCommandBuffer commandBuffer) {
-		VkBuffer buffers[] = { vertexBuffer->getBuffer()};
+		VkBuffer buffers[] = { vertexRange.buffer };
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
 		if (hasIndexBuffer)
 		{
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(commandBuffer, indexRange.buffer, 0, indexType);
 		}
 	}
 
-	std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions() {
+	std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions(VertexFormat format) {
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
 		bindingDescriptions[0].binding = 0;
-		bindingDescriptions[0].stride = sizeof(Vertex);
+		bindingDescriptions[0].stride = LveVertexQuantizer::vertexStride(format);
 		bindingDescriptions[0].inputRate= VK_VERTEX_INPUT_RATE_VERTEX;
 		
 		return bindingDescriptions;
 	}
 
-	std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDescriptions() {
+	std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDescriptions(VertexFormat format) {
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
-		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT , offsetof(Vertex, position) });
-		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT , offsetof(Vertex, color) });
-		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT , offsetof(Vertex, normal) });
-		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT    , offsetof(Vertex, uv) });
+		switch (format)
+		{
+		case VertexFormat::Full:
+			attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT , offsetof(Vertex, position) });
+			attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT , offsetof(Vertex, color) });
+			attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT , offsetof(Vertex, normal) });
+			attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT    , offsetof(Vertex, uv) });
+			break;
+
+		case VertexFormat::Compact:
+		{
+			using CompactVertex = LveVertexQuantizer::CompactVertex;
+			attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position) });
+			attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM    , offsetof(CompactVertex, color) });
+			attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SNORM      , offsetof(CompactVertex, normal) });
+			attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT     , offsetof(CompactVertex, uv) });
+			break;
+		}
+
+		case VertexFormat::Compact16:
+		{
+			// normal is packed into position.w
+			using Compact16Vertex = LveVertexQuantizer::Compact16Vertex;
+			attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(Compact16Vertex, position) });
+			attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM    , offsetof(Compact16Vertex, color) });
+			attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT     , offsetof(Compact16Vertex, uv) });
+			break;
+		}
+		}
 
 		return attributeDescriptions;
 	}
@@ -159,20 +254,33 @@ namespace lve {
 		return textureName;
 	}
 
+	static_assert(sizeof(LveModel::Vertex) == 11 * sizeof(float), "Vertex is deduplicated bytewise and must have no padding");
+
 	void LveModel::Builder::loadModel(const std::string& filepath) {
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
 		std::string warn, err;
 
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
+		if (!LveObjParser::load(filepath, attrib, shapes, warn, err)) {
 			throw std::runtime_error(warn + err);
 		}
 
 		vertices.clear();
 		indices.clear();
+		submeshes.clear();
+		lods.clear();
+		meshlets.clear();
+		closed = false;
+		optimized = false;
+
+		size_t indexCount = 0;
+		for (const auto& shape : shapes)
+		{
+			indexCount += shape.mesh.indices.size();
+		}
+		indices.reserve(indexCount);
 
-		std::unordered_map<Vertex, uint32_t> uniceVerteces{};
+		VertexDeduplicator<Vertex> uniqueVertices{ indexCount };
 		for (const auto &shape : shapes) 
 		{
 			for (const auto &index : shape.mesh.indices)
@@ -211,14 +319,388 @@ namespace lve {
 					};
 				}
 
-				if (uniceVerteces.count(vertex) == 0)
+				indices.push_back(uniqueVertices.insert(vertex, vertices));
+			}
+		}
+
+		computeBounds();
+	}
+
+	void LveModel::Builder::optimize() {
+		assert(lods.empty() && "optimize reorders all indices as one mesh, run it before generateLods");
+		if (indices.empty())
+			return;
+
+		LveMeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+		LveMeshOptimizer::optimizeOverdraw(
+			indices.data(),
+			indices.size(),
+			&vertices[0].position.x,
+			sizeof(Vertex),
+			vertices.size()
+		);
+
+		auto vertexCount = LveMeshOptimizer::optimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size());
+		vertices.resize(vertexCount);
+		optimized = true;
+	}
+
+	void LveModel::Builder::generateLods() {
+		assert(submeshes.empty() && lods.empty() && "lods have to be generated before splitting");
+		if (indices.empty())
+			return;
+
+		// smaller levels don`t pay for their draw calls
+		constexpr size_t MIN_LOD_TRIANGLES = 64;
+		// stop when simplification gets stuck, e.g. on meshes made of borders
+		constexpr size_t MIN_REDUCTION_PERCENT = 20;
+
+		submeshes.push_back({ 0, static_cast<uint32_t>(indices.size()), 0 });
+		lods.push_back({ 0, 1, 0.f });
+
+		LveMeshSimplifier simplifier{ vertices };
+		size_t sourceOffset = 0;
+		size_t sourceCount = indices.size();
+		float error = 0.f;
+		while (lods.size() < MAX_LODS)
+		{
+			auto targetTriangles = sourceCount / 3 / 2;
+			if (targetTriangles < MIN_LOD_TRIANGLES)
+				break;
+
+			float levelError = 0.f;
+			auto lod = simplifier.simplify(indices.data() + sourceOffset, sourceCount, targetTriangles * 3, levelError);
+			if (lod.size() * 100 > sourceCount * (100 - MIN_REDUCTION_PERCENT))
+				break;
+
+			LveMeshOptimizer::optimizeVertexCache(lod.data(), lod.size(), vertices.size());
+
+			// every level simplifies the previous one, so deviations from the full mesh add up
+			error += levelError;
+			sourceOffset = indices.size();
+			sourceCount = lod.size();
+			submeshes.push_back({ static_cast<uint32_t>(sourceOffset), static_cast<uint32_t>(sourceCount), 0 });
+			lods.push_back({ static_cast<uint32_t>(submeshes.size() - 1), 1, error });
+			indices.insert(indices.end(), lod.begin(), lod.end());
+		}
+	}
+
+	void LveModel::Builder::splitForShortIndices() {
+		if (vertices.size() <= MAX_SHORT_INDEX_VERTICES)
+			return;
+
+		assert(meshlets.empty() && "meshlets have to be built after splitting");
+		std::vector<Submesh> ranges = std::move(submeshes);
+		if (ranges.empty())
+		{
+			ranges.push_back({ 0, static_cast<uint32_t>(indices.size()), 0 });
+		}
+		assert(std::all_of(ranges.begin(), ranges.end(), [](const Submesh& range) { return range.vertexOffset == 0; }) && "mesh is split already");
+		submeshes.clear();
+		constexpr uint32_t UNASSIGNED = UINT32_MAX;
+
+		// A window is a vertex range of at most MAX_SHORT_INDEX_VERTICES vertices. The full detail ranges are cut
+		// into windows in triangle order, the other lods reuse them: every lod triangle goes to a window that already
+		// holds its vertices, so all levels share one vertex buffer and only triangles across windows add vertices
+		struct Window
+		{
+			// source vertex of every window vertex
+			std::vector<uint32_t> sources;
+			// source vertices whose home is another window
+			std::unordered_map<uint32_t, uint32_t> copies;
+		};
+		std::vector<Window> windows;
+		// first window a source vertex was put into and its index there
+		std::vector<uint32_t> homeWindow(vertices.size(), UNASSIGNED);
+		std::vector<uint32_t> homeIndex(vertices.size(), UNASSIGNED);
+
+		auto localIndex = [&](uint32_t window, uint32_t vertex) {
+			if (homeWindow[vertex] == window)
+				return homeIndex[vertex];
+
+			auto it = windows[window].copies.find(vertex);
+			return it == windows[window].copies.end() ? UNASSIGNED : it->second;
+		};
+		auto missingVertices = [&](uint32_t window, const uint32_t* triangle) {
+			uint32_t missing = 0;
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				bool repeated = (corner > 0 && triangle[corner] == triangle[0]) || (corner > 1 && triangle[corner] == triangle[1]);
+				missing += !repeated && localIndex(window, triangle[corner]) == UNASSIGNED ? 1 : 0;
+			}
+			return missing;
+		};
+		auto hasRoom = [&](uint32_t window, uint32_t missing) {
+			return windows[window].sources.size() + missing <= MAX_SHORT_INDEX_VERTICES;
+		};
+		auto addVertex = [&](uint32_t window, uint32_t vertex) {
+			auto local = static_cast<uint32_t>(windows[window].sources.size());
+			windows[window].sources.push_back(vertex);
+			if (homeWindow[vertex] == UNASSIGNED)
+			{
+				homeWindow[vertex] = window;
+				homeIndex[vertex] = local;
+			}
+			else
+			{
+				windows[window].copies.emplace(vertex, local);
+			}
+			return local;
+		};
+		auto openWindow = [&]() {
+			windows.emplace_back();
+			return static_cast<uint32_t>(windows.size() - 1);
+		};
+
+		// ranges of the full detail level are cut first, a mesh without lods is all full detail
+		std::vector<bool> fullDetail(ranges.size(), lods.empty());
+		if (!lods.empty())
+		{
+			for (auto range = lods[0].firstSubmesh; range < lods[0].firstSubmesh + lods[0].submeshCount; range++)
+			{
+				fullDetail[range] = true;
+			}
+		}
+		std::vector<size_t> order;
+		for (size_t pass = 0; pass < 2; pass++)
+		{
+			for (size_t range = 0; range < ranges.size(); range++)
+			{
+				if (fullDetail[range] == (pass == 0))
+				{
+					order.push_back(range);
+				}
+			}
+		}
+
+		// window of every triangle, submeshes are runs of one window
+		std::vector<std::vector<uint32_t>> rangeWindows(ranges.size());
+		for (auto range : order)
+		{
+			const auto& source = ranges[range];
+			auto& triangleWindows = rangeWindows[range];
+			triangleWindows.reserve(source.indexCount / 3);
+			uint32_t current = UNASSIGNED;
+			for (size_t triangle = source.firstIndex; triangle + 2 < static_cast<size_t>(source.firstIndex) + source.indexCount; triangle += 3)
+			{
+				const uint32_t* corners = &indices[triangle];
+				uint32_t window = UNASSIGNED;
+				if (fullDetail[range])
+				{
+					// in order: the triangles of a window stay one contiguous run
+					if (current == UNASSIGNED || !hasRoom(current, missingVertices(current, corners)))
+					{
+						current = openWindow();
+					}
+					window = current;
+				}
+				else
+				{
+					// the window of a corner, or the last one used, that needs the fewest new vertices
+					uint32_t bestMissing = 4;
+					uint32_t candidates[4] = { homeWindow[corners[0]], homeWindow[corners[1]], homeWindow[corners[2]], current };
+					for (auto candidate : candidates)
+					{
+						if (candidate == UNASSIGNED)
+							continue;
+
+						auto missing = missingVertices(candidate, corners);
+						if (missing < bestMissing && hasRoom(candidate, missing))
+						{
+							window = candidate;
+							bestMissing = missing;
+						}
+					}
+					if (window == UNASSIGNED)
+					{
+						auto last = static_cast<uint32_t>(windows.size() - 1);
+						window = !windows.empty() && hasRoom(last, 3) ? last : openWindow();
+					}
+					current = window;
+				}
+
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					if (localIndex(window, corners[corner]) == UNASSIGNED)
+					{
+						addVertex(window, corners[corner]);
+					}
+				}
+				triangleWindows.push_back(window);
+			}
+		}
+
+		// window vertices one after the other
+		std::vector<uint32_t> windowOffset(windows.size());
+		std::vector<Vertex> splitVertices;
+		for (size_t window = 0; window < windows.size(); window++)
+		{
+			windowOffset[window] = static_cast<uint32_t>(splitVertices.size());
+			for (auto vertex : windows[window].sources)
+			{
+				splitVertices.push_back(vertices[vertex]);
+			}
+		}
+
+		// group the triangles of every range by window, stable so the cache order inside a window stays,
+		// then rewrite them with window relative indices. firstSplit[range] is its first submesh afterwards
+		std::vector<uint32_t> firstSplit(ranges.size() + 1);
+		std::vector<uint32_t> triangleOrder;
+		std::vector<uint32_t> rangeIndices;
+		for (size_t range = 0; range < ranges.size(); range++)
+		{
+			const auto& source = ranges[range];
+			const auto& triangleWindows = rangeWindows[range];
+			firstSplit[range] = static_cast<uint32_t>(submeshes.size());
+
+			triangleOrder.resize(triangleWindows.size());
+			std::iota(triangleOrder.begin(), triangleOrder.end(), 0u);
+			std::stable_sort(triangleOrder.begin(), triangleOrder.end(), [&](uint32_t l, uint32_t r) { return triangleWindows[l] < triangleWindows[r]; });
+
+			rangeIndices.assign(indices.begin() + source.firstIndex, indices.begin() + source.firstIndex + source.indexCount);
+			Submesh submesh{ source.firstIndex, 0, 0 };
+			uint32_t submeshWindow = UNASSIGNED;
+			for (size_t i = 0; i < triangleOrder.size(); i++)
+			{
+				auto triangle = triangleOrder[i];
+				auto window = triangleWindows[triangle];
+				if (window != submeshWindow)
+				{
+					if (submesh.indexCount > 0)
+					{
+						submeshes.push_back(submesh);
+					}
+					submesh = { static_cast<uint32_t>(source.firstIndex + i * 3), 0, static_cast<int32_t>(windowOffset[window]) };
+					submeshWindow = window;
+				}
+
+				for (size_t corner = 0; corner < 3; corner++)
 				{
-					uniceVerteces[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
+					indices[source.firstIndex + i * 3 + corner] = localIndex(window, rangeIndices[triangle * 3 + corner]);
 				}
-				indices.push_back(uniceVerteces[vertex]);
+				submesh.indexCount += 3;
+			}
+			if (submesh.indexCount > 0)
+			{
+				submeshes.push_back(submesh);
+			}
+		}
+		firstSplit.back() = static_cast<uint32_t>(submeshes.size());
+
+		for (auto& lod : lods)
+		{
+			auto first = firstSplit[lod.firstSubmesh];
+			lod.submeshCount = firstSplit[lod.firstSubmesh + lod.submeshCount] - first;
+			lod.firstSubmesh = first;
+		}
+
+		vertices = std::move(splitVertices);
+	}
+
+	void LveModel::Builder::buildMeshlets() {
+		meshlets.clear();
+		if (indices.empty())
+			return;
+
+		if (submeshes.empty())
+		{
+			submeshes.push_back({ 0, static_cast<uint32_t>(indices.size()), 0 });
+		}
+		if (lods.empty())
+		{
+			lods.push_back({ 0, static_cast<uint32_t>(submeshes.size()), 0.f });
+		}
+
+		// simplification keeps borders, so the full detail level tells for all of them
+		std::vector<uint32_t> fullDetail;
+		for (auto s = lods[0].firstSubmesh; s < lods[0].firstSubmesh + lods[0].submeshCount; s++)
+		{
+			for (uint32_t i = 0; i < submeshes[s].indexCount; i++)
+			{
+				fullDetail.push_back(indices[submeshes[s].firstIndex + i] + submeshes[s].vertexOffset);
 			}
 		}
+		float orientation = LveMeshlets::surfaceOrientation(fullDetail.data(), fullDetail.size(), &vertices[0].position.x, sizeof(Vertex), vertices.size());
+		closed = orientation != 0.f;
+
+		std::vector<uint32_t> firstMeshlet(submeshes.size() + 1);
+		for (size_t s = 0; s < submeshes.size(); s++)
+		{
+			const auto& submesh = submeshes[s];
+			firstMeshlet[s] = static_cast<uint32_t>(meshlets.size());
+
+			const float* positions = &vertices[submesh.vertexOffset].position.x;
+			auto submeshMeshlets = LveMeshlets::build(
+				indices.data() + submesh.firstIndex,
+				submesh.indexCount,
+				positions,
+				sizeof(Vertex),
+				vertices.size() - submesh.vertexOffset
+			);
+			for (auto& meshlet : submeshMeshlets)
+			{
+				meshlet.firstIndex += submesh.firstIndex;
+				meshlet.vertexOffset = submesh.vertexOffset;
+				LveMeshlets::computeBounds(meshlet, indices.data(), positions, sizeof(Vertex), closed ? orientation : 1.f);
+				meshlets.push_back(meshlet);
+			}
+		}
+		firstMeshlet.back() = static_cast<uint32_t>(meshlets.size());
+
+		for (auto& lod : lods)
+		{
+			lod.firstMeshlet = firstMeshlet[lod.firstSubmesh];
+			lod.meshletCount = firstMeshlet[lod.firstSubmesh + lod.submeshCount] - lod.firstMeshlet;
+		}
+	}
+
+	VkIndexType LveModel::Builder::getIndexType() const {
+		bool fitsShort = std::all_of(indices.begin(), indices.end(), [](uint32_t index) { return index < MAX_SHORT_INDEX_VERTICES; });
+		return fitsShort ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
+
+	std::vector<uint8_t> LveModel::Builder::packIndices(VkIndexType indexType) const {
+		if (indexType == VK_INDEX_TYPE_UINT32)
+		{
+			std::vector<uint8_t> packed(indices.size() * sizeof(uint32_t));
+			std::memcpy(packed.data(), indices.data(), packed.size());
+			return packed;
+		}
+
+		std::vector<uint8_t> packed(indices.size() * sizeof(uint16_t));
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			assert(indices[i] < MAX_SHORT_INDEX_VERTICES && "index doesn`t fit 16 bits");
+			auto index = static_cast<uint16_t>(indices[i]);
+			std::memcpy(packed.data() + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+		}
+		return packed;
+	}
+
+	void LveModel::Builder::computeBounds() {
+		if (vertices.empty())
+		{
+			boundsMin = boundsMax = sphereCenter = glm::vec3{ 0.f };
+			sphereRadius = 0.f;
+			return;
+		}
+
+		boundsMin = boundsMax = vertices[0].position;
+		for (const auto& vertex : vertices)
+		{
+			boundsMin = glm::min(boundsMin, vertex.position);
+			boundsMax = glm::max(boundsMax, vertex.position);
+		}
+
+		// tighter than the half diagonal whenever the mesh doesn`t fill the box corners
+		sphereCenter = (boundsMin + boundsMax) * 0.5f;
+		float radiusSquared = 0.f;
+		for (const auto& vertex : vertices)
+		{
+			auto offset = vertex.position - sphereCenter;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		sphereRadius = std::sqrt(radiusSquared);
 	}
 
 }//namespace lve
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "lve_buffer.hpp"
 #include "lve_device.hpp"
+#include "lve_geometry_arena.hpp"
 #include "Definitions/DefaultSamplersNames.hpp"
 #include "lve_swap_chain.hpp"
 
@@ -15,65 +16,209 @@
 #include <vector>
 
 namespace lve {
+	class LveMeshCache;
+
 	class LveModel
 	{
 	public:
 
+		// GPU layout of vertex buffers, see LveVertexQuantizer
+		enum class VertexFormat : uint32_t
+		{
+			// fp32 Vertex as is, 44 bytes
+			Full = 0,
+			// unorm16 position in mesh bounds, oct snorm16 normal, unorm8 color, half uv: 20 bytes
+			Compact = 1,
+			// Compact with an oct snorm8 normal in the position w: 16 bytes
+			Compact16 = 2,
+		};
+		static constexpr uint32_t VERTEX_FORMAT_COUNT = 3;
+
 		struct  Vertex
 		{
 			glm::vec3 position{};
 			glm::vec3 color{};
 			glm::vec3 normal{};
 			glm::vec2 uv{};
-			glm::vec2 textCoord{};
 
-			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(VertexFormat format = VertexFormat::Full);
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexFormat format = VertexFormat::Full);
 
 			bool operator==(const Vertex& other) const {
 				return
 					position == other.position &&
 					color == other.color &&
 					normal == other.normal &&
-					uv == other.uv &&
-					textCoord == other.textCoord;
+					uv == other.uv;
 			}
 		};
 
+		// range of the index buffer drawn with its own base vertex
+		struct Submesh
+		{
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			int32_t vertexOffset;
+		};
+
+		// cluster of triangles culled on its own, a range of the index buffer inside one submesh
+		struct Meshlet
+		{
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			int32_t vertexOffset;
+			// bounding sphere, object space
+			glm::vec3 center;
+			float radius;
+			// all triangles face away from views within the cone around coneAxis, see LveMeshlets::isVisible
+			glm::vec3 coneAxis;
+			float coneCutoff;
+		};
+
+		// level of detail, a range of submeshes. All levels share the vertex buffer
+		struct Lod
+		{
+			uint32_t firstSubmesh;
+			uint32_t submeshCount;
+			// max object space deviation from the full detail mesh
+			float error;
+			uint32_t firstMeshlet = 0;
+			uint32_t meshletCount = 0;
+		};
+
+		// meshes up to this many vertices use 16 bit indices
+		static constexpr uint32_t MAX_SHORT_INDEX_VERTICES = 1u << 16;
+		// full detail mesh included
+		static constexpr uint32_t MAX_LODS = 5;
+
 		struct Builder {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			// empty - one submesh over all indices with vertexOffset 0
+			std::vector<Submesh> submeshes{};
+			// empty - one level over all submeshes
+			std::vector<Lod> lods{};
+			std::vector<Meshlet> meshlets{};
+			// every edge is shared by two triangles, back faces can`t be seen from outside
+			bool closed = false;
+			glm::vec3 boundsMin{};
+			glm::vec3 boundsMax{};
+			// bounding sphere around the box center
+			glm::vec3 sphereCenter{};
+			float sphereRadius = 0.f;
+			// optimize() ran over vertices and indices
+			bool optimized = false;
 
 			void loadModel(const std::string& filepath);
+			/// <summary>
+			/// Bounding box and sphere of vertices
+			/// </summary>
+			void computeBounds();
+			/// <summary>
+			/// Reorder triangles for the post-transform cache and overdraw, then vertices for fetch
+			/// </summary>
+			void optimize();
+			/// <summary>
+			/// Append simplified levels, each with about half the triangles of the previous one, to indices.
+			/// Has to run after optimize and before splitForShortIndices
+			/// </summary>
+			void generateLods();
+			/// <summary>
+			/// Split meshes with more than MAX_SHORT_INDEX_VERTICES vertices into submeshes that each
+			/// own a vertex range of at most that size, indices become relative to the submesh.
+			/// The ranges come from the full detail level, the other lods draw from the same ranges,
+			/// so vertices are only duplicated where triangles cross ranges. Lods keep covering the same triangles
+			/// </summary>
+			void splitForShortIndices();
+			/// <summary>
+			/// Partition every submesh into meshlets, see LveMeshlets. Runs last, it reorders triangles inside submeshes
+			/// </summary>
+			void buildMeshlets();
+
+			/// <returns>VK_INDEX_TYPE_UINT16 when every index fits</returns>
+			VkIndexType getIndexType() const;
+			/// <returns>indices in the layout of indexType</returns>
+			std::vector<uint8_t> packIndices(VkIndexType indexType) const;
 		};
 
-		LveModel(LveDevice& lveDevice, const LveModel::Builder& builder);
+		LveModel(LveDevice& lveDevice, const LveModel::Builder& builder, VertexFormat vertexFormat = VertexFormat::Full);
+		LveModel(LveDevice& lveDevice, const LveMeshCache& meshCache);
 
 		~LveModel();
 
 		LveModel(const LveModel&) = delete;
 		void operator=(const LveModel&) = delete;
 
-		static std::unique_ptr<LveModel> createModelFromFile(LveDevice& device, const std::string& filepath);
+		/// <summary>
+		/// Load a mesh and its lod chain, from the mesh cache when it is up to date
+		/// </summary>
+		/// <param name="optimize">run Builder::optimize on meshes that are not cached yet</param>
+		static std::unique_ptr<LveModel> createModelFromFile(
+			LveDevice& device,
+			const std::string& filepath,
+			VertexFormat vertexFormat = VertexFormat::Compact,
+			bool optimize = true
+		);
 
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+		/// <summary>
+		/// Draw meshlets by index, in ascending order. Neighbouring meshlets share a draw
+		/// </summary>
+		/// <returns>draw calls issued</returns>
+		uint32_t drawMeshlets(VkCommandBuffer commandBuffer, const std::vector<uint32_t>& meshletIndices);
 
 		void setTextureName(std::string&& textureName);
 		std::string& getTextureName();
 
+		const glm::vec3& getBoundsMin() const { return boundsMin; }
+		const glm::vec3& getBoundsMax() const { return boundsMax; }
+		const glm::vec3& getSphereCenter() const { return sphereCenter; }
+		float getSphereRadius() const { return sphereRadius; }
+
+		VertexFormat getVertexFormat() const { return vertexFormat; }
+		VkIndexType getIndexType() const { return indexType; }
+		// arena buffers bind() binds, shared with other models of the same vertex format and index type
+		VkBuffer getVertexBuffer() const { return vertexRange.buffer; }
+		VkBuffer getIndexBuffer() const { return indexRange.buffer; }
+		// index and vertex offsets are absolute in the arena buffers
+		const std::vector<Submesh>& getSubmeshes() const { return submeshes; }
+		// at least one, full detail first
+		const std::vector<Lod>& getLods() const { return lods; }
+		const std::vector<Meshlet>& getMeshlets() const { return meshlets; }
+		bool isClosed() const { return closed; }
+		// dequantization of packed positions, has to be applied after the model matrix
+		const glm::mat4& getPositionDecode() const { return positionDecode; }
+
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		void createVertexBuffers(const void* vertexData, uint32_t vertexCount);
+		void createIndexBuffers(const void* indexData, uint32_t indexCount, VkIndexType indexType);
+		/// <summary>
+		/// Offset submesh and meshlet ranges by where the geometry landed in the arena buffers
+		/// </summary>
+		void rebaseRanges();
 
 		LveDevice& lveDevice;
 
-		std::unique_ptr<LveBuffer> vertexBuffer;
+		// vertices and indices live in the shared buffers of LveGeometryArena
+		LveGeometryRange vertexRange;
 		uint32_t vertexCount;
+		VertexFormat vertexFormat = VertexFormat::Full;
+		glm::mat4 positionDecode{ 1.f };
 
 		bool hasIndexBuffer = false;
-		std::unique_ptr<LveBuffer> indexBuffer;
+		LveGeometryRange indexRange;
 		uint32_t indexCount;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		std::vector<Submesh> submeshes;
+		std::vector<Lod> lods;
+		std::vector<Meshlet> meshlets;
+		bool closed = false;
+
+		glm::vec3 boundsMin{};
+		glm::vec3 boundsMax{};
+		glm::vec3 sphereCenter{};
+		float sphereRadius = 0.f;
 
 		std::string textureName;
 
@@ -0,0 +1,347 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "lve_obj_parser.hpp"
+
+#include "Helpers/MappedFile.hpp"
+#include "lve_job_system.hpp"
+
+//std
+#include <algorithm>
+#include <cstring>
+
+namespace lve {
+
+	namespace {
+
+		struct ObjChunk
+		{
+			const char* begin = nullptr;
+			const char* end = nullptr;
+
+			std::vector<tinyobj::real_t> positions;
+			std::vector<tinyobj::real_t> colors;
+			std::vector<tinyobj::real_t> normals;
+			std::vector<tinyobj::real_t> texcoords;
+
+			// corners of all faces, faceSizes[i] corners per face
+			std::vector<tinyobj::vertex_index_t> corners;
+			std::vector<uint32_t> faceSizes;
+			// for faces with more than 3 corners: positions of this chunk defined before the face
+			std::vector<uint32_t> polygonVertexLimits;
+
+			std::vector<tinyobj::index_t> indices;
+
+			// chunk uses something only tinyobj reproduces exactly
+			bool supported = true;
+
+			size_t positionBase = 0;
+			size_t normalBase = 0;
+			size_t texcoordBase = 0;
+			size_t indexBase = 0;
+		};
+
+		// chunks are jobs of the shared job system, the calling thread works on them too
+		template<typename F>
+		void runPerChunk(size_t chunkCount, F&& function)
+		{
+			LveJobSystem::shared().parallelFor(static_cast<uint32_t>(chunkCount), 1, [&function](uint32_t begin, uint32_t end) {
+				for (auto i = begin; i < end; i++)
+				{
+					function(i);
+				}
+			});
+		}
+
+		// mirrors the line handling of tinyobj::LoadObj for v/vn/vt/f records
+		void parseChunk(ObjChunk& chunk)
+		{
+			std::string line;
+			const char* current = chunk.begin;
+			while (current < chunk.end && chunk.supported)
+			{
+				// safeGetline treats \n, \r and \r\n as line ends, empty lines are skipped anyway
+				auto length = static_cast<size_t>(chunk.end - current);
+				auto lineEnd = static_cast<const char*>(std::memchr(current, '\n', length));
+				if (lineEnd == nullptr)
+				{
+					lineEnd = chunk.end;
+				}
+				auto carriageReturn = static_cast<const char*>(std::memchr(current, '\r', static_cast<size_t>(lineEnd - current)));
+				if (carriageReturn != nullptr)
+				{
+					lineEnd = carriageReturn;
+				}
+
+				line.assign(current, lineEnd);
+				current = lineEnd + 1;
+
+				const char* token = line.c_str();
+				token += strspn(token, " \t");
+				if (token[0] == '\0' || token[0] == '#')
+					continue;
+
+				if (token[0] == 'v' && IS_SPACE(token[1]))
+				{
+					token += 2;
+					tinyobj::real_t x, y, z;
+					tinyobj::real_t r, g, b;
+					tinyobj::parseVertexWithColor(&x, &y, &z, &r, &g, &b, &token);
+
+					chunk.positions.insert(chunk.positions.end(), { x, y, z });
+					chunk.colors.insert(chunk.colors.end(), { r, g, b });
+					continue;
+				}
+
+				if (token[0] == 'v' && token[1] == 'n' && IS_SPACE(token[2]))
+				{
+					token += 3;
+					tinyobj::real_t x, y, z;
+					tinyobj::parseReal3(&x, &y, &z, &token);
+					chunk.normals.insert(chunk.normals.end(), { x, y, z });
+					continue;
+				}
+
+				if (token[0] == 'v' && token[1] == 't' && IS_SPACE(token[2]))
+				{
+					token += 3;
+					tinyobj::real_t x, y;
+					tinyobj::parseReal2(&x, &y, &token);
+					chunk.texcoords.insert(chunk.texcoords.end(), { x, y });
+					continue;
+				}
+
+				// records tinyobj can fail on
+				if ((token[0] == 'v' && token[1] == 'w' && IS_SPACE(token[2])) ||
+					((token[0] == 'l' || token[0] == 'p') && IS_SPACE(token[1])))
+				{
+					chunk.supported = false;
+					return;
+				}
+
+				if (token[0] == 'f' && IS_SPACE(token[1]))
+				{
+					token += 2;
+					token += strspn(token, " \t");
+
+					// relative indices depend on counts of previous chunks
+					if (std::strchr(token, '-') != nullptr)
+					{
+						chunk.supported = false;
+						return;
+					}
+
+					uint32_t faceSize = 0;
+					while (!IS_NEW_LINE(token[0]))
+					{
+						tinyobj::vertex_index_t vi;
+						if (!tinyobj::parseTriple(&token, 0, 0, 0, &vi))
+						{
+							chunk.supported = false;
+							return;
+						}
+
+						chunk.corners.push_back(vi);
+						faceSize++;
+						token += strspn(token, " \t\r");
+					}
+
+					chunk.faceSizes.push_back(faceSize);
+					if (faceSize > 3)
+					{
+						chunk.polygonVertexLimits.push_back(static_cast<uint32_t>(chunk.positions.size() / 3));
+					}
+				}
+			}
+		}
+
+		void triangulateChunk(
+			ObjChunk& chunk,
+			const std::vector<tinyobj::real_t>& positions,
+			size_t normalCount,
+			size_t texcoordCount
+		)
+		{
+			const auto positionCount = positions.size() / 3;
+			const auto inRange = [&](const tinyobj::vertex_index_t& vi) {
+				return
+					vi.v_idx >= 0 && static_cast<size_t>(vi.v_idx) < positionCount &&
+					(vi.vn_idx < 0 || static_cast<size_t>(vi.vn_idx) < normalCount) &&
+					(vi.vt_idx < 0 || static_cast<size_t>(vi.vt_idx) < texcoordCount);
+			};
+			const auto toIndex = [](const tinyobj::vertex_index_t& vi) {
+				tinyobj::index_t index;
+				index.vertex_index = vi.v_idx;
+				index.normal_index = vi.vn_idx;
+				index.texcoord_index = vi.vt_idx;
+				return index;
+			};
+
+			tinyobj::PrimGroup polygon;
+			polygon.faceGroup.resize(1);
+			tinyobj::shape_t polygonShape;
+			const std::vector<tinyobj::tag_t> noTags;
+			const std::string noName;
+
+			chunk.indices.reserve(chunk.corners.size());
+
+			size_t corner = 0;
+			size_t polygonIndex = 0;
+			for (auto faceSize : chunk.faceSizes)
+			{
+				auto first = chunk.corners.begin() + corner;
+				corner += faceSize;
+
+				if (!std::all_of(first, first + faceSize, inRange))
+				{
+					chunk.supported = false;
+					return;
+				}
+
+				if (faceSize < 3)
+					continue;
+
+				if (faceSize == 3)
+				{
+					chunk.indices.push_back(toIndex(first[0]));
+					chunk.indices.push_back(toIndex(first[1]));
+					chunk.indices.push_back(toIndex(first[2]));
+					continue;
+				}
+
+				// tinyobj triangulates against the positions known when the group is exported,
+				// so a polygon must not reference positions defined after it
+				auto vertexLimit = chunk.positionBase / 3 + chunk.polygonVertexLimits[polygonIndex++];
+				if (!std::all_of(first, first + faceSize, [vertexLimit](const auto& vi) { return static_cast<size_t>(vi.v_idx) < vertexLimit; }))
+				{
+					chunk.supported = false;
+					return;
+				}
+
+				polygon.faceGroup[0].vertex_indices.assign(first, first + faceSize);
+				polygonShape.mesh.indices.clear();
+				tinyobj::exportGroupsToShape(&polygonShape, polygon, noTags, -1, noName, true, positions, nullptr);
+				chunk.indices.insert(chunk.indices.end(), polygonShape.mesh.indices.begin(), polygonShape.mesh.indices.end());
+			}
+		}
+
+	}//namespace
+
+	bool LveObjParser::loadReference(
+		const std::string& filepath,
+		tinyobj::attrib_t& attrib,
+		std::vector<tinyobj::shape_t>& shapes,
+		std::string& warn,
+		std::string& err
+	)
+	{
+		std::vector<tinyobj::material_t> materials;
+		return tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str());
+	}
+
+	bool LveObjParser::load(
+		const std::string& filepath,
+		tinyobj::attrib_t& attrib,
+		std::vector<tinyobj::shape_t>& shapes,
+		std::string& warn,
+		std::string& err,
+		uint32_t threadCount
+	)
+	{
+		MappedFile file{};
+		if (!file.open(filepath) || file.size() < MIN_PARALLEL_FILE_SIZE)
+		{
+			return loadReference(filepath, attrib, shapes, warn, err);
+		}
+
+		if (threadCount == 0)
+		{
+			threadCount = LveJobSystem::shared().getWorkerCount();
+		}
+		auto chunkCount = std::clamp<size_t>(file.size() / MIN_CHUNK_SIZE, 1, threadCount);
+
+		// split into chunks that start right after a line break
+		std::vector<ObjChunk> chunks(chunkCount);
+		const char* fileEnd = file.data() + file.size();
+		const char* chunkBegin = file.data();
+		for (size_t i = 0; i < chunkCount; i++)
+		{
+			const char* chunkEnd = fileEnd;
+			if (i + 1 < chunkCount)
+			{
+				chunkEnd = std::max(chunkBegin, file.data() + file.size() / chunkCount * (i + 1));
+				auto lineBreak = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<size_t>(fileEnd - chunkEnd)));
+				chunkEnd = lineBreak != nullptr ? lineBreak + 1 : fileEnd;
+			}
+
+			chunks[i].begin = chunkBegin;
+			chunks[i].end = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+
+		runPerChunk(chunkCount, [&chunks](size_t i) { parseChunk(chunks[i]); });
+		bool supported = std::all_of(chunks.begin(), chunks.end(), [](const auto& chunk) { return chunk.supported; });
+		if (!supported)
+		{
+			file.close();
+			return loadReference(filepath, attrib, shapes, warn, err);
+		}
+
+		size_t positionCount = 0, normalCount = 0, texcoordCount = 0;
+		for (auto& chunk : chunks)
+		{
+			chunk.positionBase = positionCount;
+			chunk.normalBase = normalCount;
+			chunk.texcoordBase = texcoordCount;
+			positionCount += chunk.positions.size();
+			normalCount += chunk.normals.size();
+			texcoordCount += chunk.texcoords.size();
+		}
+
+		attrib = tinyobj::attrib_t{};
+		attrib.vertices.resize(positionCount);
+		attrib.colors.resize(positionCount);
+		attrib.normals.resize(normalCount);
+		attrib.texcoords.resize(texcoordCount);
+		runPerChunk(chunkCount, [&](size_t i) {
+			auto& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), attrib.vertices.begin() + chunk.positionBase);
+			std::copy(chunk.colors.begin(), chunk.colors.end(), attrib.colors.begin() + chunk.positionBase);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), attrib.normals.begin() + chunk.normalBase);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), attrib.texcoords.begin() + chunk.texcoordBase);
+			chunk.positions = {};
+			chunk.colors = {};
+			chunk.normals = {};
+			chunk.texcoords = {};
+		});
+
+		runPerChunk(chunkCount, [&](size_t i) {
+			triangulateChunk(chunks[i], attrib.vertices, normalCount / 3, texcoordCount / 2);
+		});
+		supported = std::all_of(chunks.begin(), chunks.end(), [](const auto& chunk) { return chunk.supported; });
+		if (!supported)
+		{
+			file.close();
+			attrib = tinyobj::attrib_t{};
+			return loadReference(filepath, attrib, shapes, warn, err);
+		}
+
+		size_t indexCount = 0;
+		for (auto& chunk : chunks)
+		{
+			chunk.indexBase = indexCount;
+			indexCount += chunk.indices.size();
+		}
+
+		shapes.clear();
+		shapes.resize(1);
+		auto& mesh = shapes[0].mesh;
+		mesh.indices.resize(indexCount);
+		mesh.num_face_vertices.assign(indexCount / 3, 3);
+		runPerChunk(chunkCount, [&](size_t i) {
+			auto& chunk = chunks[i];
+			std::copy(chunk.indices.begin(), chunk.indices.end(), mesh.indices.begin() + chunk.indexBase);
+		});
+
+		return true;
+	}
+
+}//namespace lve
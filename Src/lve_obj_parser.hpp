@@ -0,0 +1,50 @@
+#pragma once
+
+//libs
+#include <tiny_obj_loader.h>
+
+//std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// OBJ geometry loader that parses big files on several threads.
+	// The file is memory mapped and split into line aligned chunks; every chunk is parsed
+	// with tinyobj`s own number/index parsing and chunks are merged in file order, so the
+	// result is bit-identical to tinyobj::LoadObj with default arguments: same attrib arrays,
+	// same triangulation, faces in the same order (all of them in a single shape).
+	// Files that are small or use something the fast path doesn`t reproduce exactly
+	// (relative indices, forward references from polygons, l/p/vw records) go through tinyobj.
+	class LveObjParser
+	{
+	public:
+		// files below this size are not worth splitting into jobs
+		static constexpr size_t MIN_PARALLEL_FILE_SIZE = 4 * 1024 * 1024;
+		static constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+		/// <param name="threadCount">most chunks the file is split into, 0 - one per job system worker</param>
+		/// <returns>false on parse errors, err describes them</returns>
+		static bool load(
+			const std::string& filepath,
+			tinyobj::attrib_t& attrib,
+			std::vector<tinyobj::shape_t>& shapes,
+			std::string& warn,
+			std::string& err,
+			uint32_t threadCount = 0
+		);
+
+		/// <summary>
+		/// Single threaded reference path, plain tinyobj::LoadObj
+		/// </summary>
+		static bool loadReference(
+			const std::string& filepath,
+			tinyobj::attrib_t& attrib,
+			std::vector<tinyobj::shape_t>& shapes,
+			std::string& warn,
+			std::string& err
+		);
+	};
+
+}//namespace lve
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Render target for headless mode: one color + depth image per frame in flight,
+	// used by LveRenderer in place of LveSwapChain when there is no window to present to
+	class LveOffscreenTarget {
+	public:
+		static constexpr int FRAMES_IN_FLIGHT = LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+		LveOffscreenTarget(LveDevice& deviceRef, VkExtent2D extent);
+		~LveOffscreenTarget();
+
+		LveOffscreenTarget(const LveOffscreenTarget&) = delete;
+		LveOffscreenTarget& operator=(const LveOffscreenTarget&) = delete;
+
+		VkFramebuffer getFrameBuffer(int index) { return framebuffers[index]; }
+		VkRenderPass getRenderPass() { return renderPass; }
+		VkFormat getImageFormat() { return colorFormat; }
+		VkExtent2D getExtent() { return extent; }
+
+		float extentAspectRatio() {
+			return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+		}
+
+		VkResult acquireNextImage(uint32_t* imageIndex);
+		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+
+		/// <summary>
+		/// Waits for the frame rendered into image imageIndex and copies it to host memory
+		/// </summary>
+		/// <returns>Tightly packed RGBA8 pixels, width * height * 4 bytes</returns>
+		std::vector<uint8_t> readPixels(uint32_t imageIndex);
+
+	private:
+		void createImages();
+		void createRenderPass();
+		void createFramebuffers();
+		void createSyncObjects();
+		VkFormat findDepthFormat();
+
+		LveDevice& device;
+		VkExtent2D extent;
+
+		VkFormat colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+		VkFormat depthFormat;
+		VkRenderPass renderPass;
+
+		std::vector<VkImage> colorImages;
+		std::vector<LveAllocation> colorImageAllocations;
+		std::vector<VkImageView> colorImageViews;
+		std::vector<VkImage> depthImages;
+		std::vector<LveAllocation> depthImageAllocations;
+		std::vector<VkImageView> depthImageViews;
+		std::vector<VkFramebuffer> framebuffers;
+
+		std::vector<VkFence> inFlightFences;
+		size_t currentFrame = 0;
+	};
+
+}  // namespace lve
@@ -0,0 +1,150 @@
+#include "lve_parallel_recorder.hpp"
+
+#include "Helpers/VulkanHelpers.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	LveParallelRecorder::LveParallelRecorder(LveDevice& device, LveJobSystem& jobSystem, uint32_t maxChunks)
+		: lveDevice{ device }, jobSystem{ jobSystem }, maxChunks{ std::max(maxChunks, 1u) }
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		// buffers are only reset together with their pool, once per frame
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+
+		for (auto& framePools : pools)
+		{
+			framePools.resize(jobSystem.getWorkerCount());
+			for (auto& pool : framePools)
+			{
+				auto result = vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &pool.commandPool);
+				if (result != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create recording command pool!" + VulkanHelpers::AsString(result));
+				}
+			}
+		}
+	}
+
+	LveParallelRecorder::~LveParallelRecorder()
+	{
+		for (auto& framePools : pools)
+		{
+			for (auto& pool : framePools)
+			{
+				// destroying the pool frees its buffers
+				vkDestroyCommandPool(lveDevice.device(), pool.commandPool, nullptr);
+			}
+		}
+	}
+
+	void LveParallelRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		assert(frameIndex >= 0 && frameIndex < LveSwapChain::MAX_FRAMES_IN_FLIGHT && "frame index out of range");
+		this->frameIndex = frameIndex;
+		this->renderPass = renderPass;
+		this->framebuffer = framebuffer;
+		this->extent = extent;
+		recorded.clear();
+
+		for (auto& pool : pools[frameIndex])
+		{
+			auto result = vkResetCommandPool(lveDevice.device(), pool.commandPool, 0);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to reset recording command pool!" + VulkanHelpers::AsString(result));
+			}
+			pool.used = 0;
+		}
+	}
+
+	VkCommandBuffer LveParallelRecorder::beginSecondary()
+	{
+		assert(jobSystem.isMainThread() && "beginSecondary records with the main thread`s pool");
+		return beginWorkerSecondary(0);
+	}
+
+	void LveParallelRecorder::endSecondary(VkCommandBuffer commandBuffer)
+	{
+		endWorkerSecondary(commandBuffer);
+		recorded.push_back(commandBuffer);
+	}
+
+	VkCommandBuffer LveParallelRecorder::beginWorkerSecondary(uint32_t worker)
+	{
+		assert(renderPass != VK_NULL_HANDLE && "secondary buffer outside of a frame");
+		auto& pool = pools[frameIndex][worker];
+		if (pool.used == pool.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandPool = pool.commandPool;
+			allocateInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			auto result = vkAllocateCommandBuffers(lveDevice.device(), &allocateInfo, &commandBuffer);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate secondary command buffer!" + VulkanHelpers::AsString(result));
+			}
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+		auto commandBuffer = pool.commandBuffers[pool.used++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		auto result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin secondary command buffer!" + VulkanHelpers::AsString(result));
+		}
+
+		// dynamic state is not inherited from the primary
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0,0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		return commandBuffer;
+	}
+
+	void LveParallelRecorder::endWorkerSecondary(VkCommandBuffer commandBuffer)
+	{
+		auto result = vkEndCommandBuffer(commandBuffer);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record secondary command buffer!" + VulkanHelpers::AsString(result));
+		}
+	}
+
+	void LveParallelRecorder::execute(VkCommandBuffer primary)
+	{
+		executedCount = static_cast<uint32_t>(recorded.size());
+		if (!recorded.empty())
+		{
+			vkCmdExecuteCommands(primary, executedCount, recorded.data());
+		}
+		recorded.clear();
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_job_system.hpp"
+#include "lve_swap_chain.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace lve {
+
+	// Records the contents of a render pass on the workers of an LveJobSystem. Every worker has its own command pool per frame
+	// in flight (pools are externally synchronized, so workers never share one) and records secondary command buffers
+	// that inherit the render pass. execute() runs them from the primary command buffer in the order they were recorded.
+	//
+	// A render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS takes no inline commands, so everything
+	// drawn in it has to go through the recorder: split lists through record(), the rest through beginSecondary().
+	class LveParallelRecorder
+	{
+	public:
+		/// <param name="maxChunks">most secondary buffers record() splits a range into</param>
+		LveParallelRecorder(LveDevice& device, LveJobSystem& jobSystem, uint32_t maxChunks);
+		~LveParallelRecorder();
+
+		LveParallelRecorder(const LveParallelRecorder&) = delete;
+		void operator=(const LveParallelRecorder&) = delete;
+
+		uint32_t getMaxChunks() const { return maxChunks; }
+
+		/// <summary>
+		/// Start recording a frame: resets the command pools of frameIndex, the last submit of that frame has to be finished.
+		/// Secondary buffers of the frame inherit renderPass (subpass 0) and framebuffer
+		/// </summary>
+		void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+		/// <summary>
+		/// Secondary command buffer inside the render pass, viewport and scissor already set.
+		/// Main thread only, record() is the way to record from the other workers
+		/// </summary>
+		VkCommandBuffer beginSecondary();
+		/// <summary>
+		/// End a buffer of beginSecondary, it is executed after everything recorded before it
+		/// </summary>
+		void endSecondary(VkCommandBuffer commandBuffer);
+
+		/// <summary>
+		/// Split [0, itemCount) into contiguous chunks of at least minItemsPerChunk and record them as jobs.
+		/// Main thread only. Returns when all chunks are recorded, their buffers execute in item order
+		/// </summary>
+		/// <param name="function">void(uint32_t chunk, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end),
+		/// called once per chunk. Chunks are below getMaxChunks(), per chunk state needs no locking</param>
+		template<typename F>
+		void record(uint32_t itemCount, uint32_t minItemsPerChunk, F&& function)
+		{
+			if (itemCount == 0)
+				return;
+
+			uint32_t chunkCount = (itemCount + std::max(minItemsPerChunk, 1u) - 1) / std::max(minItemsPerChunk, 1u);
+			chunkCount = std::clamp(chunkCount, 1u, maxChunks);
+			chunkBuffers.resize(chunkCount);
+
+			jobSystem.parallelFor(chunkCount, 1, [&](uint32_t firstChunk, uint32_t endChunk) {
+				for (auto chunk = firstChunk; chunk < endChunk; chunk++)
+				{
+					auto begin = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * chunk / chunkCount);
+					auto end = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * (chunk + 1) / chunkCount);
+					// the pool of the thread running the chunk, one thread records one buffer at a time
+					auto commandBuffer = beginWorkerSecondary(jobSystem.currentWorker());
+					function(chunk, commandBuffer, begin, end);
+					endWorkerSecondary(commandBuffer);
+					chunkBuffers[chunk] = commandBuffer;
+				}
+			});
+
+			recorded.insert(recorded.end(), chunkBuffers.begin(), chunkBuffers.end());
+		}
+
+		/// <summary>
+		/// Execute everything recorded since beginFrame in primary, which has to be inside the render pass
+		/// </summary>
+		void execute(VkCommandBuffer primary);
+
+		// secondary buffers executed last frame
+		uint32_t getExecutedCount() const { return executedCount; }
+
+	private:
+		struct WorkerPool
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;
+			// buffers of commandBuffers begun since the last reset, the rest are free
+			uint32_t used = 0;
+		};
+
+		VkCommandBuffer beginWorkerSecondary(uint32_t worker);
+		void endWorkerSecondary(VkCommandBuffer commandBuffer);
+
+		LveDevice& lveDevice;
+		LveJobSystem& jobSystem;
+		uint32_t maxChunks;
+
+		std::array<std::vector<WorkerPool>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> pools;
+		int frameIndex = 0;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+
+		std::vector<VkCommandBuffer> chunkBuffers;
+		// in execution order
+		std::vector<VkCommandBuffer> recorded;
+		uint32_t executedCount = 0;
+	};
+}
@@ -21,9 +21,19 @@ namespace lve {
 		createGraphicsPipeline(vertFilepatch, fragFilepatch, configInfo);
 	}
 
+	LvePipeline::LvePipeline(
+		LveDevice& device,
+		const std::string& compFilepath,
+		VkPipelineLayout pipelineLayout
+	)
+		: lveDevice{ device }, bindPoint{ VK_PIPELINE_BIND_POINT_COMPUTE }
+	{
+		createComputePipeline(compFilepath, pipelineLayout);
+	}
+
 	LvePipeline::~LvePipeline() 
 	{
-		vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+		vkDestroyPipeline(lveDevice.device(), pipeline, nullptr);
 	}
 	
 	std::vector<char> LvePipeline::readFile(const std::string& filepath) 
@@ -117,7 +127,7 @@ namespace lve {
 			1,
 			&pipelineInfo,
 			nullptr,
-			&graphicsPipeline
+			&pipeline
 		);
 
 		if (vkResult != VK_SUCCESS)
@@ -129,6 +139,40 @@ namespace lve {
 		vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
 	}
 
+	void LvePipeline::createComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+	{
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+		auto compCode = readFile(compFilepath);
+		VkShaderModule compShaderModule = createShaderModule(compCode);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = compShaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		auto vkResult = vkCreateComputePipelines(
+			lveDevice.device(),
+			VK_NULL_HANDLE,
+			1,
+			&pipelineInfo,
+			nullptr,
+			&pipeline
+		);
+
+		vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create compute pipeline!" + VulkanHelpers::AsString(vkResult));
+		}
+	}
+
 	VkShaderModule LvePipeline::createShaderModule(const std::vector<char>& code) {
 
 		VkShaderModule shaderModule{};
@@ -148,7 +192,7 @@ namespace lve {
 
 	void LvePipeline::bind(VkCommandBuffer commandBuffer) 
 	{
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
 	}
 
 	void LvePipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) 
@@ -39,6 +39,14 @@ namespace lve {
 			const std::string& fragFilepatch,
 			const PipelineConfigInfo& configInfo
 		);
+		/// <summary>
+		/// Compute pipeline, bind() binds it to the compute bind point
+		/// </summary>
+		LvePipeline(
+			LveDevice& device,
+			const std::string& compFilepath,
+			VkPipelineLayout pipelineLayout
+		);
 
 		~LvePipeline();
 
@@ -58,10 +66,13 @@ namespace lve {
 			const PipelineConfigInfo& configInfo
 		);
 
+		void createComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+
 		VkShaderModule createShaderModule(const std::vector<char>& code);
 
 		LveDevice& lveDevice;
-		VkPipeline graphicsPipeline;
+		VkPipeline pipeline;
+		VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
 	};
 }
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "lve_range_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace lve {
+
+	LveRangeAllocator::LveRangeAllocator(uint64_t size) : totalSize{ size }, freeSize{ size }
+	{
+		for (auto& heads : freeHeads)
+		{
+			std::fill(std::begin(heads), std::end(heads), INVALID_HANDLE);
+		}
+
+		if (size == 0)
+			return;
+
+		auto index = createChunk();
+		chunks[index].offset = 0;
+		chunks[index].size = size;
+		insertFree(index);
+	}
+
+	void LveRangeAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+	{
+		//small ranges get a linear class each, bigger ones SL_COUNT classes per power of two
+		if (size < SL_COUNT)
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size);
+			return;
+		}
+
+		uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		fl = msb - SL_BITS + 1;
+		sl = static_cast<uint32_t>(size >> (msb - SL_BITS)) - SL_COUNT;
+	}
+
+	uint32_t LveRangeAllocator::findFreeChunk(uint64_t size)
+	{
+		//round up to the next class so that any chunk of the found list fits
+		if (size >= SL_COUNT)
+		{
+			uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+			size += (uint64_t{ 1 } << (msb - SL_BITS)) - 1;
+		}
+
+		uint32_t fl, sl;
+		mapping(size, fl, sl);
+		if (fl >= FL_COUNT)
+			return INVALID_HANDLE;
+
+		uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+		if (slMap == 0)
+		{
+			if (fl + 1 >= FL_COUNT)
+				return INVALID_HANDLE;
+
+			uint64_t flMap = flBitmap & (~uint64_t{ 0 } << (fl + 1));
+			if (flMap == 0)
+				return INVALID_HANDLE;
+
+			fl = static_cast<uint32_t>(std::countr_zero(flMap));
+			slMap = slBitmaps[fl];
+		}
+
+		sl = static_cast<uint32_t>(std::countr_zero(slMap));
+		return freeHeads[fl][sl];
+	}
+
+	bool LveRangeAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t& offset, uint32_t& handle)
+	{
+		assert(std::has_single_bit(alignment) && "Alignment must be a power of two");
+
+		size = std::max<uint64_t>(size, 1);
+		auto index = findFreeChunk(size + alignment - 1);
+		if (index == INVALID_HANDLE)
+			return false;
+
+		removeFree(index);
+
+		uint64_t alignedOffset = (chunks[index].offset + alignment - 1) & ~(alignment - 1);
+		uint64_t padding = alignedOffset - chunks[index].offset;
+		if (padding != 0)
+		{
+			//free neighbours are always merged, so the padding can`t be merged with the previous chunk
+			auto front = createChunk();
+			auto& chunk = chunks[index];
+			chunks[front].offset = chunk.offset;
+			chunks[front].size = padding;
+			chunks[front].prevPhysical = chunk.prevPhysical;
+			chunks[front].nextPhysical = index;
+			if (chunk.prevPhysical != INVALID_HANDLE)
+			{
+				chunks[chunk.prevPhysical].nextPhysical = front;
+			}
+			chunk.prevPhysical = front;
+			chunk.offset = alignedOffset;
+			chunk.size -= padding;
+			insertFree(front);
+		}
+
+		if (chunks[index].size > size)
+		{
+			auto back = createChunk();
+			auto& chunk = chunks[index];
+			chunks[back].offset = chunk.offset + size;
+			chunks[back].size = chunk.size - size;
+			chunks[back].prevPhysical = index;
+			chunks[back].nextPhysical = chunk.nextPhysical;
+			if (chunk.nextPhysical != INVALID_HANDLE)
+			{
+				chunks[chunk.nextPhysical].prevPhysical = back;
+			}
+			chunk.nextPhysical = back;
+			chunk.size = size;
+			insertFree(back);
+		}
+
+		freeSize -= chunks[index].size;
+		offset = chunks[index].offset;
+		handle = index;
+		return true;
+	}
+
+	void LveRangeAllocator::free(uint32_t handle)
+	{
+		assert(handle < chunks.size() && !chunks[handle].isFree && "Range is not allocated");
+
+		auto index = handle;
+		freeSize += chunks[index].size;
+
+		auto prev = chunks[index].prevPhysical;
+		if (prev != INVALID_HANDLE && chunks[prev].isFree)
+		{
+			removeFree(prev);
+			chunks[prev].size += chunks[index].size;
+			chunks[prev].nextPhysical = chunks[index].nextPhysical;
+			if (chunks[index].nextPhysical != INVALID_HANDLE)
+			{
+				chunks[chunks[index].nextPhysical].prevPhysical = prev;
+			}
+			releaseChunk(index);
+			index = prev;
+		}
+
+		auto next = chunks[index].nextPhysical;
+		if (next != INVALID_HANDLE && chunks[next].isFree)
+		{
+			removeFree(next);
+			chunks[index].size += chunks[next].size;
+			chunks[index].nextPhysical = chunks[next].nextPhysical;
+			if (chunks[next].nextPhysical != INVALID_HANDLE)
+			{
+				chunks[chunks[next].nextPhysical].prevPhysical = index;
+			}
+			releaseChunk(next);
+		}
+
+		insertFree(index);
+	}
+
+	uint64_t LveRangeAllocator::getLargestFreeRange() const
+	{
+		if (flBitmap == 0)
+			return 0;
+
+		uint32_t fl = 63 - static_cast<uint32_t>(std::countl_zero(flBitmap));
+		uint32_t sl = 31 - static_cast<uint32_t>(std::countl_zero(slBitmaps[fl]));
+
+		uint64_t largest = 0;
+		for (auto i = freeHeads[fl][sl]; i != INVALID_HANDLE; i = chunks[i].nextFree)
+		{
+			largest = std::max(largest, chunks[i].size);
+		}
+
+		return largest;
+	}
+
+	uint32_t LveRangeAllocator::createChunk()
+	{
+		if (!unusedChunks.empty())
+		{
+			auto index = unusedChunks.back();
+			unusedChunks.pop_back();
+			chunks[index] = Chunk{};
+			return index;
+		}
+
+		chunks.emplace_back();
+		return static_cast<uint32_t>(chunks.size() - 1);
+	}
+
+	void LveRangeAllocator::releaseChunk(uint32_t index)
+	{
+		chunks[index].isFree = false;
+		chunks[index].size = 0;
+		unusedChunks.push_back(index);
+	}
+
+	void LveRangeAllocator::insertFree(uint32_t index)
+	{
+		uint32_t fl, sl;
+		mapping(chunks[index].size, fl, sl);
+
+		auto& chunk = chunks[index];
+		chunk.isFree = true;
+		chunk.prevFree = INVALID_HANDLE;
+		chunk.nextFree = freeHeads[fl][sl];
+		if (chunk.nextFree != INVALID_HANDLE)
+		{
+			chunks[chunk.nextFree].prevFree = index;
+		}
+
+		freeHeads[fl][sl] = index;
+		slBitmaps[fl] |= 1u << sl;
+		flBitmap |= uint64_t{ 1 } << fl;
+	}
+
+	void LveRangeAllocator::removeFree(uint32_t index)
+	{
+		uint32_t fl, sl;
+		mapping(chunks[index].size, fl, sl);
+
+		auto& chunk = chunks[index];
+		if (chunk.prevFree != INVALID_HANDLE)
+		{
+			chunks[chunk.prevFree].nextFree = chunk.nextFree;
+		}
+		else
+		{
+			freeHeads[fl][sl] = chunk.nextFree;
+		}
+
+		if (chunk.nextFree != INVALID_HANDLE)
+		{
+			chunks[chunk.nextFree].prevFree = chunk.prevFree;
+		}
+
+		if (freeHeads[fl][sl] == INVALID_HANDLE)
+		{
+			slBitmaps[fl] &= ~(1u << sl);
+			if (slBitmaps[fl] == 0)
+			{
+				flBitmap &= ~(uint64_t{ 1 } << fl);
+			}
+		}
+
+		chunk.isFree = false;
+		chunk.prevFree = INVALID_HANDLE;
+		chunk.nextFree = INVALID_HANDLE;
+	}
+
+}  // namespace lve
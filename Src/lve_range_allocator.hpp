@@ -0,0 +1,94 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// Two-level segregated fit (TLSF) allocator over an abstract [0, size) range.
+	// Knows nothing about Vulkan: callers map the returned offsets onto memory or buffers.
+	// Allocation and free are O(1), neighbouring free ranges are merged on free.
+	class LveRangeAllocator {
+	public:
+		static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+		explicit LveRangeAllocator(uint64_t size);
+
+		LveRangeAllocator(const LveRangeAllocator&) = delete;
+		LveRangeAllocator& operator=(const LveRangeAllocator&) = delete;
+		LveRangeAllocator(LveRangeAllocator&&) = default;
+		LveRangeAllocator& operator=(LveRangeAllocator&&) = default;
+
+		/// <param name="alignment">Power of two</param>
+		/// <returns>false if no free range is big enough</returns>
+		bool allocate(uint64_t size, uint64_t alignment, uint64_t& offset, uint32_t& handle);
+		void free(uint32_t handle);
+
+		uint64_t getSize() const { return totalSize; }
+		uint64_t getFreeSize() const { return freeSize; }
+		uint64_t getLargestFreeRange() const;
+		bool isEmpty() const { return freeSize == totalSize; }
+
+	private:
+		static constexpr uint32_t SL_BITS = 4;
+		static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+		static constexpr uint32_t FL_COUNT = 64 - SL_BITS + 1;
+
+		struct Chunk
+		{
+			uint64_t offset = 0;
+			uint64_t size = 0;
+			uint32_t prevPhysical = INVALID_HANDLE;
+			uint32_t nextPhysical = INVALID_HANDLE;
+			uint32_t prevFree = INVALID_HANDLE;
+			uint32_t nextFree = INVALID_HANDLE;
+			bool isFree = false;
+		};
+
+		static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+		uint32_t findFreeChunk(uint64_t size);
+
+		uint32_t createChunk();
+		void releaseChunk(uint32_t index);
+		void insertFree(uint32_t index);
+		void removeFree(uint32_t index);
+
+		std::vector<Chunk> chunks;
+		std::vector<uint32_t> unusedChunks;
+
+		uint64_t flBitmap = 0;
+		uint32_t slBitmaps[FL_COUNT]{};
+		uint32_t freeHeads[FL_COUNT][SL_COUNT];
+
+		uint64_t totalSize;
+		uint64_t freeSize;
+	};
+
+	/// <summary>
+	/// Block retire policy of the pools carved up by LveRangeAllocator (device memory, geometry buffers): one empty
+	/// block per pool is kept, so alloc/free patterns don`t thrash creating the Vulkan object behind the blocks.
+	/// Block needs a LveRangeAllocator member named ranges
+	/// </summary>
+	/// <param name="block">Block of blocks whose last range was just freed</param>
+	/// <returns>block, taken out of blocks, if it has to be destroyed, nullptr if it is kept</returns>
+	template<typename Block>
+	std::unique_ptr<Block> retireEmptyBlock(std::vector<std::unique_ptr<Block>>& blocks, Block* block)
+	{
+		bool hasOtherEmpty = std::any_of(blocks.begin(), blocks.end(), [block](const auto& other) {
+			return other.get() != block && other->ranges.isEmpty();
+			});
+		if (!hasOtherEmpty)
+			return nullptr;
+
+		auto it = std::find_if(blocks.begin(), blocks.end(), [block](const auto& other) {
+			return other.get() == block;
+			});
+		auto retired = std::move(*it);
+		blocks.erase(it);
+		return retired;
+	}
+
+}  // namespace lve
@@ -0,0 +1,146 @@
+#include "lve_render_queue.hpp"
+
+//std
+#include <cassert>
+
+namespace lve {
+
+	LveBindCache::Stats& LveBindCache::Stats::operator+=(const Stats& other)
+	{
+		auto add = [](BindStats& to, const BindStats& from) {
+			to.issued += from.issued;
+			to.avoided += from.avoided;
+		};
+		add(pipelines, other.pipelines);
+		add(descriptorSets, other.descriptorSets);
+		add(meshes, other.meshes);
+		return *this;
+	}
+
+	void LveBindCache::begin(VkCommandBuffer commandBuffer)
+	{
+		this->commandBuffer = commandBuffer;
+		boundPipeline = nullptr;
+		for (auto& descriptorSet : boundDescriptorSets)
+		{
+			descriptorSet = VK_NULL_HANDLE;
+		}
+		boundVertexBuffer = VK_NULL_HANDLE;
+		boundIndexBuffer = VK_NULL_HANDLE;
+		boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		stats = {};
+	}
+
+	void LveBindCache::bindPipeline(LvePipeline& pipeline)
+	{
+		assert(commandBuffer != VK_NULL_HANDLE && "bind outside of a submit");
+		if (boundPipeline == &pipeline)
+		{
+			stats.pipelines.avoided++;
+			return;
+		}
+
+		pipeline.bind(commandBuffer);
+		boundPipeline = &pipeline;
+		stats.pipelines.issued++;
+	}
+
+	void LveBindCache::bindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet)
+	{
+		assert(commandBuffer != VK_NULL_HANDLE && "bind outside of a submit");
+		assert(set < MAX_DESCRIPTOR_SETS && "descriptor set index out of range");
+		// all pipelines of a queue share compatible layouts, so a bound set stays valid across pipeline binds
+		if (boundDescriptorSets[set] == descriptorSet)
+		{
+			stats.descriptorSets.avoided++;
+			return;
+		}
+
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			set,
+			1,
+			&descriptorSet,
+			0,
+			nullptr
+		);
+		boundDescriptorSets[set] = descriptorSet;
+		stats.descriptorSets.issued++;
+	}
+
+	void LveBindCache::bindMesh(LveModel& model)
+	{
+		assert(commandBuffer != VK_NULL_HANDLE && "bind outside of a submit");
+		if (boundVertexBuffer == model.getVertexBuffer() &&
+			boundIndexBuffer == model.getIndexBuffer() &&
+			boundIndexType == model.getIndexType())
+		{
+			stats.meshes.avoided++;
+			return;
+		}
+
+		model.bind(commandBuffer);
+		boundVertexBuffer = model.getVertexBuffer();
+		boundIndexBuffer = model.getIndexBuffer();
+		boundIndexType = model.getIndexType();
+		stats.meshes.issued++;
+	}
+
+	uint64_t LveRenderQueue::makeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod, float depth)
+	{
+		auto field = [](uint64_t value, uint32_t bits) { return value & ((uint64_t{ 1 } << bits) - 1); };
+
+		// sign, exponent and the top mantissa bits of the float: relative precision, no depth range needed
+		uint64_t depthKey = RadixSort::FloatKey(depth) >> (32 - DEPTH_BITS);
+
+		uint64_t key = field(pipeline, PIPELINE_BITS);
+		key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+		key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+		key = (key << LOD_BITS) | field(lod, LOD_BITS);
+		key = (key << DEPTH_BITS) | depthKey;
+		return key;
+	}
+
+	uint32_t LveRenderQueue::materialId(VkDescriptorSet descriptorSet)
+	{
+		auto [it, inserted] = materialIds.try_emplace(descriptorSet, static_cast<uint32_t>(materialIds.size()));
+		return it->second;
+	}
+
+	uint32_t LveRenderQueue::meshId(const LveModel* model)
+	{
+		auto [it, inserted] = meshIds.try_emplace(model, static_cast<uint32_t>(meshIds.size()));
+		return it->second;
+	}
+
+	void LveRenderQueue::clear()
+	{
+		packets.clear();
+		materialIds.clear();
+		meshIds.clear();
+	}
+
+	void LveRenderQueue::push(uint64_t key, uint32_t packet)
+	{
+		packets.push_back({ key, packet });
+	}
+
+	void LveRenderQueue::sort()
+	{
+		RadixSort::Sort(packets, sortScratch);
+		stats.packets = static_cast<uint32_t>(packets.size());
+	}
+
+	void LveRenderQueue::resetBindStats()
+	{
+		static_cast<LveBindCache::Stats&>(stats) = {};
+	}
+
+	void LveRenderQueue::addBindStats(const LveBindCache::Stats& bindStats)
+	{
+		stats += bindStats;
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_pipeline.hpp"
+#include "Helpers/RadixSort.hpp"
+
+//std
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	// Bind state of one command buffer: binds of state that is bound already are skipped.
+	// Threads recording their own command buffers each use their own cache.
+	class LveBindCache
+	{
+	public:
+		struct BindStats
+		{
+			uint32_t issued = 0;
+			// binds skipped because the state was bound already
+			uint32_t avoided = 0;
+		};
+
+		struct Stats
+		{
+			BindStats pipelines;
+			BindStats descriptorSets;
+			// vertex and index buffers of a model, models in the same arena buffers need no rebind
+			BindStats meshes;
+
+			Stats& operator+=(const Stats& other);
+		};
+
+		/// <summary>
+		/// Forget the state bound so far, the next bind of every kind is issued
+		/// </summary>
+		void begin(VkCommandBuffer commandBuffer);
+		void bindPipeline(LvePipeline& pipeline);
+		void bindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet);
+		void bindMesh(LveModel& model);
+
+		// binds since begin
+		const Stats& getStats() const { return stats; }
+
+	private:
+		static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		LvePipeline* boundPipeline = nullptr;
+		VkDescriptorSet boundDescriptorSets[MAX_DESCRIPTOR_SETS]{};
+		// models share arena buffers, a mesh bind is only needed when these change
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		Stats stats{};
+	};
+
+	// Draw packets of a pass ordered by a 64 bit sort key, most significant field first:
+	// pipeline (8 bits) | material (16) | mesh (16) | lod (4) | depth (20).
+	// Sorting puts packets that share a pipeline, then a texture, then a mesh next to each other,
+	// submitting them through an LveBindCache then skips every bind of state that is already bound.
+	// The queue only orders packet indices, what a packet is belongs to the render system.
+	class LveRenderQueue
+	{
+	public:
+		static constexpr uint32_t PIPELINE_BITS = 8;
+		static constexpr uint32_t MATERIAL_BITS = 16;
+		static constexpr uint32_t MESH_BITS = 16;
+		static constexpr uint32_t LOD_BITS = 4;
+		static constexpr uint32_t DEPTH_BITS = 20;
+		static_assert(PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + LOD_BITS + DEPTH_BITS == 64, "sort key fields have to fill 64 bits");
+
+		struct Stats : LveBindCache::Stats
+		{
+			uint32_t packets = 0;
+		};
+
+		LveRenderQueue() = default;
+
+		LveRenderQueue(const LveRenderQueue&) = delete;
+		void operator=(const LveRenderQueue&) = delete;
+
+		/// <summary>
+		/// Sort key of a packet. Fields wider than their bits are truncated, that only costs sort quality
+		/// </summary>
+		/// <param name="depth">view distance, keys of equal state sort front to back. Quantized logarithmically</param>
+		static uint64_t makeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod, float depth);
+
+		/// <summary>
+		/// Small id for the material field, stable until the next clear
+		/// </summary>
+		uint32_t materialId(VkDescriptorSet descriptorSet);
+		/// <summary>
+		/// Small id for the mesh field, stable until the next clear
+		/// </summary>
+		uint32_t meshId(const LveModel* model);
+
+		/// <summary>
+		/// Drop the packets and the material and mesh ids: ids only have to agree within one sort,
+		/// and freed descriptor sets or models must not hand their id to whatever reuses their address
+		/// </summary>
+		void clear();
+		void push(uint64_t key, uint32_t packet);
+		void sort();
+		// after sort: packets ascending by key, value is the packet pushed
+		const std::vector<RadixSort::Entry>& getPackets() const { return packets; }
+
+		/// <summary>
+		/// Start counting the binds of a new submit
+		/// </summary>
+		void resetBindStats();
+		/// <summary>
+		/// Count the binds of a cache that submitted packets of this queue, one call per command buffer
+		/// </summary>
+		void addBindStats(const LveBindCache::Stats& bindStats);
+
+		// binds of the last submit, packets of the last sort
+		const Stats& getStats() const { return stats; }
+
+	private:
+		std::vector<RadixSort::Entry> packets;
+		std::vector<RadixSort::Entry> sortScratch;
+
+		std::unordered_map<VkDescriptorSet, uint32_t> materialIds;
+		std::unordered_map<const LveModel*, uint32_t> meshIds;
+
+		Stats stats{};
+	};
+}
@@ -1,4 +1,5 @@
 #include "lve_renderer.hpp"
+#include "lve_uploader.hpp"
 
 #include <stdexcept>
 #include <array>
@@ -8,7 +9,7 @@ namespace lve {
 
 	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device)
 		: 
-		lveWindow{ window },
+		lveWindow{ &window },
 		lveDevice{ device },
 		currentImageIndex{ 0 },
 		currentFrameIndex{ 0 },
@@ -18,6 +19,18 @@ namespace lve {
 		createCommandBuffers();
 	}
 
+	LveRenderer::LveRenderer(LveDevice& device, VkExtent2D extent)
+		:
+		lveWindow{ nullptr },
+		lveDevice{ device },
+		currentImageIndex{ 0 },
+		currentFrameIndex{ 0 },
+		isFrameStarted{ false }
+	{
+		offscreenTarget = std::make_unique<LveOffscreenTarget>(lveDevice, extent);
+		createCommandBuffers();
+	}
+
 	LveRenderer::~LveRenderer() 
 	{
 		freeCommandBuffers();
@@ -25,10 +38,10 @@ namespace lve {
 
 	void LveRenderer::recreateSwapChain() 
 	{
-		auto extent = lveWindow.getExtend();
+		auto extent = lveWindow->getExtend();
 		while (extent.width == 0 || extent.height == 0)
 		{
-			extent = lveWindow.getExtend();
+			extent = lveWindow->getExtend();
 			glfwWaitEvents();
 		}
 
@@ -84,7 +97,11 @@ namespace lve {
 		globalFrameCounter++;
 		assert(!isFrameStarted && "Can`t call beginFrame while already in progress");
 
-		auto vkResult = lveSwapChain->acquireNextImage(&currentImageIndex);
+		lveDevice.getUploader().collect();
+
+		auto vkResult = isHeadless()
+			? offscreenTarget->acquireNextImage(&currentImageIndex)
+			: lveSwapChain->acquireNextImage(&currentImageIndex);
 
 		if (vkResult == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -123,11 +140,21 @@ namespace lve {
 			throw std::runtime_error("failed to record command buffer!" + VulkanHelpers::AsString(vkResult));
 		}
 
-		vkResult = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		// uploads recorded this frame must be ahead of the frame on the graphics queue
+		lveDevice.getUploader().flush();
 
-		if (vkResult == VK_ERROR_OUT_OF_DATE_KHR || vkResult == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized())
+		if (isHeadless())
 		{
-			lveWindow.resetWindowResizedFlag();
+			vkResult = offscreenTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		}
+		else
+		{
+			vkResult = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		}
+
+		if (!isHeadless() && (vkResult == VK_ERROR_OUT_OF_DATE_KHR || vkResult == VK_SUBOPTIMAL_KHR || lveWindow->wasWindowResized()))
+		{
+			lveWindow->resetWindowResizedFlag();
 			recreateSwapChain();
 		}
 		else if (vkResult != VK_SUCCESS)
@@ -139,18 +166,20 @@ namespace lve {
 		currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) 
+	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) 
 	{
 		assert(isFrameStarted && "Can`t call beginSwapChainRenderPass while frame is not in in progress");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can`t begin render pass on command buffer from a different frame");
 
+		auto extent = getExtent();
+
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = lveSwapChain->getRenderPass();
-		renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+		renderPassInfo.renderPass = getSwapChainRenderPass();
+		renderPassInfo.framebuffer = getCurrentFramebuffer();
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
+		renderPassInfo.renderArea.extent = extent;
 
 		std::array<VkClearValue, 2> clearValues{};
 		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
@@ -158,16 +187,18 @@ namespace lve {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents != VK_SUBPASS_CONTENTS_INLINE)
+			return;
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(lveSwapChain->getSwapChainExtent().width);
-		viewport.height = static_cast<float>(lveSwapChain->getSwapChainExtent().height);
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
-		VkRect2D scissor{ {0,0}, lveSwapChain->getSwapChainExtent() };
+		VkRect2D scissor{ {0,0}, extent };
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
@@ -179,4 +210,12 @@ namespace lve {
 
 		vkCmdEndRenderPass(commandBuffer);
 	}
+
+	std::vector<uint8_t> LveRenderer::readbackLastFrame()
+	{
+		assert(isHeadless() && "Readback is only supported by the headless renderer");
+		assert(!isFrameStarted && "Can`t read back while frame is in progress");
+
+		return offscreenTarget->readPixels(currentImageIndex);
+	}
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "lve_window.hpp"
 #include "lve_device.hpp"
 #include "lve_swap_chain.hpp"
+#include "lve_offscreen_target.hpp"
 
 #include <memory>
 #include <vector>
@@ -15,20 +16,37 @@ namespace lve {
 	public:
 
 		LveRenderer(LveWindow& window, LveDevice& device);
+		// headless renderer, draws into an LveOffscreenTarget instead of a swap chain
+		LveRenderer(LveDevice& device, VkExtent2D extent);
 		~LveRenderer();
 
 		LveRenderer(const LveRenderer&) = delete;
 		void operator=(const LveRenderer&) = delete;
 
-		VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
-		float getAspectRation() const { return lveSwapChain->extentAspectRatio(); };
+		VkRenderPass getSwapChainRenderPass() const {
+			return isHeadless() ? offscreenTarget->getRenderPass() : lveSwapChain->getRenderPass();
+		}
+		float getAspectRation() const {
+			return isHeadless() ? offscreenTarget->extentAspectRatio() : lveSwapChain->extentAspectRatio();
+		};
+		VkExtent2D getExtent() const {
+			return isHeadless() ? offscreenTarget->getExtent() : lveSwapChain->getSwapChainExtent();
+		}
 		bool isFrameInProgress() const { return isFrameStarted; };
+		bool isHeadless() const { return lveWindow == nullptr; }
 
 		VkCommandBuffer getCurrentCommandBuffer() const {
 			assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
 			return commandBuffers[currentFrameIndex];
 		}
 
+		VkFramebuffer getCurrentFramebuffer() const {
+			assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+			return isHeadless()
+				? offscreenTarget->getFrameBuffer(currentImageIndex)
+				: lveSwapChain->getFrameBuffer(currentImageIndex);
+		}
+
 		int getFrameIndex() const { 
 			assert(isFrameStarted && "Cannot get frame index when frame not in progress");
 			return currentFrameIndex;
@@ -42,18 +60,27 @@ namespace lve {
 
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		/// <param name="contents">VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS: the pass is only drawn through
+		/// vkCmdExecuteCommands (see LveParallelRecorder), viewport and scissor are left to the secondary buffers</param>
+		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+		/// <summary>
+		/// Headless only. Waits for the last submitted frame and reads it back
+		/// </summary>
+		/// <returns>RGBA8 pixels of getExtent() size</returns>
+		std::vector<uint8_t> readbackLastFrame();
+
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
 		void recreateSwapChain();
 
-		LveWindow& lveWindow;
+		LveWindow* lveWindow;
 		LveDevice& lveDevice;
 
 		std::unique_ptr<LveSwapChain> lveSwapChain;
+		std::unique_ptr<LveOffscreenTarget> offscreenTarget;
 		std::vector<VkCommandBuffer> commandBuffers;
 
 		uint32_t currentImageIndex;
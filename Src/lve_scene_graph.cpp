@@ -0,0 +1,292 @@
+#include "lve_scene_graph.hpp"
+
+//std
+#include <cassert>
+
+namespace lve {
+
+	LveSceneGraph::Link& LveSceneGraph::linkOf(LveEntity entity)
+	{
+		if (entity.index >= links.size())
+		{
+			links.resize(static_cast<size_t>(entity.index) + 1);
+		}
+		auto& link = links[entity.index];
+		if (link.entity != entity)
+		{
+			// children of the old owner find their parent dead on the next rebuild and become roots
+			link = Link{ entity, {}, 0 };
+		}
+		return link;
+	}
+
+	void LveSceneGraph::setParent(LveEntity child, LveEntity parent)
+	{
+		assert(!child.isNull() && "null entity can`t be linked");
+		for (auto ancestor = parent; !ancestor.isNull(); ancestor = getParent(ancestor))
+		{
+			assert(ancestor != child && "parent is a descendant of child");
+		}
+
+		auto& link = linkOf(child);
+		if (link.parent == parent)
+			return;
+
+		if (!link.parent.isNull() && links[link.parent.index].entity == link.parent)
+		{
+			links[link.parent.index].childCount--;
+		}
+		link.parent = parent;
+		if (!parent.isNull())
+		{
+			// may resize links, link is not used after it
+			linkOf(parent).childCount++;
+		}
+		orderChanged = true;
+	}
+
+	LveEntity LveSceneGraph::getParent(LveEntity entity) const
+	{
+		if (entity.index >= links.size() || links[entity.index].entity != entity)
+			return {};
+
+		return links[entity.index].parent;
+	}
+
+	void LveSceneGraph::remove(LveEntity entity)
+	{
+		if (entity.index >= links.size() || links[entity.index].entity != entity)
+			return;
+
+		setParent(entity, {});
+		if (links[entity.index].childCount > 0)
+		{
+			for (auto& link : links)
+			{
+				if (link.parent == entity)
+				{
+					link.parent = {};
+				}
+			}
+		}
+		links[entity.index] = {};
+		orderChanged = true;
+	}
+
+	void LveSceneGraph::updateOrder(LveRegistry& registry)
+	{
+		if (!orderChanged)
+			return;
+		orderChanged = false;
+
+		// nodes are the live entities with a parent or a child, children listed per parent (counting sort by parent index)
+		auto isNode = [&](const Link& link) {
+			return registry.isAlive(link.entity) && (!link.parent.isNull() || link.childCount > 0);
+		};
+		auto hasLiveParent = [&](const Link& link) {
+			return !link.parent.isNull() && registry.isAlive(link.parent) && links[link.parent.index].entity == link.parent;
+		};
+
+		std::vector<uint32_t> childStart(links.size() + 1, 0);
+		for (auto& link : links)
+		{
+			if (isNode(link) && hasLiveParent(link))
+			{
+				childStart[link.parent.index + 1]++;
+			}
+		}
+		for (size_t i = 1; i < childStart.size(); i++)
+		{
+			childStart[i] += childStart[i - 1];
+		}
+		std::vector<uint32_t> children(childStart.back());
+		std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+		for (auto& link : links)
+		{
+			if (isNode(link) && hasLiveParent(link))
+			{
+				children[fill[link.parent.index]++] = link.entity.index;
+			}
+		}
+
+		// entities that leave the graph kept their world matrix from it, their own has to be written again
+		auto& transforms = registry.pool<TransformComponent>();
+		for (auto entity : nodeEntities)
+		{
+			if (auto* transform = transforms.tryGet(entity))
+			{
+				transform->dirty = true;
+			}
+		}
+
+		nodeEntities.clear();
+		parentNodes.clear();
+		nodeIndices.assign(links.size(), NONE);
+
+		// depth first from every root, explicit stack so deep chains can`t overflow the call stack
+		std::vector<std::pair<uint32_t, uint32_t>> stack;
+		for (auto& link : links)
+		{
+			if (!isNode(link) || hasLiveParent(link))
+				continue;
+
+			stack.push_back({ link.entity.index, NONE });
+			while (!stack.empty())
+			{
+				auto [index, parentNode] = stack.back();
+				stack.pop_back();
+
+				auto node = static_cast<uint32_t>(nodeEntities.size());
+				nodeIndices[index] = node;
+				nodeEntities.push_back(links[index].entity);
+				parentNodes.push_back(parentNode);
+				// reversed, so children come out of the stack in link order
+				for (auto child = childStart[index + 1]; child > childStart[index]; child--)
+				{
+					stack.push_back({ children[child - 1], node });
+				}
+			}
+		}
+
+		auto nodeCount = nodeEntities.size();
+		subtreeSizes.assign(nodeCount, 1);
+		// children follow their parent, one backward pass adds every subtree to its parent
+		for (auto node = nodeCount; node-- > 0;)
+		{
+			if (parentNodes[node] != NONE)
+			{
+				subtreeSizes[parentNodes[node]] += subtreeSizes[node];
+			}
+		}
+
+		localWorld.assign(nodeCount, glm::mat4{ 1.f });
+		localNormal.assign(nodeCount, glm::mat3{ 1.f });
+		world.assign(nodeCount, glm::mat4{ 1.f });
+		normal.assign(nodeCount, glm::mat3{ 1.f });
+		localDirty.assign(nodeCount, 1);
+		dirtyDescendants.assign(nodeCount, 1);
+		changed.assign(nodeCount, 0);
+
+		// the local matrices were dropped with the old order
+		for (auto entity : nodeEntities)
+		{
+			if (auto* transform = transforms.tryGet(entity))
+			{
+				transform->dirty = true;
+			}
+		}
+	}
+
+	void LveSceneGraph::markDirty(uint32_t node)
+	{
+		localDirty[node] = 1;
+		for (auto parent = parentNodes[node]; parent != NONE && !dirtyDescendants[parent]; parent = parentNodes[parent])
+		{
+			dirtyDescendants[parent] = 1;
+		}
+	}
+
+	void LveSceneGraph::propagate(LveRegistry& registry, LveJobSystem& jobSystem)
+	{
+		stats = {};
+		stats.nodes = static_cast<uint32_t>(nodeEntities.size());
+		// looked up before the jobs, the registry must not create pools while they run
+		auto& worlds = registry.pool<WorldTransformComponent>();
+
+		// split subtrees bigger than SPLIT_SIZE: their root is updated here, the children go back on the stack.
+		// What is left are disjoint subtrees whose parents are final, independent jobs
+		jobs.clear();
+		splitStack.clear();
+		for (uint32_t root = 0; root < nodeEntities.size(); root += subtreeSizes[root])
+		{
+			splitStack.push_back({ root, false });
+		}
+		while (!splitStack.empty())
+		{
+			auto [node, parentChanged] = splitStack.back();
+			splitStack.pop_back();
+			if (!parentChanged && !localDirty[node] && !dirtyDescendants[node])
+				continue;
+
+			if (subtreeSizes[node] <= SPLIT_SIZE)
+			{
+				jobs.push_back({ node, parentChanged, 0 });
+				continue;
+			}
+
+			bool nodeChanged = updateNode(node, parentChanged, worlds);
+			stats.propagated += nodeChanged ? 1 : 0;
+			dirtyDescendants[node] = 0;
+			for (auto child = node + 1; child < node + subtreeSizes[node]; child += subtreeSizes[child])
+			{
+				splitStack.push_back({ child, nodeChanged });
+			}
+		}
+
+		jobSystem.parallelFor(static_cast<uint32_t>(jobs.size()), 1, [&](uint32_t begin, uint32_t end) {
+			for (auto job = begin; job < end; job++)
+			{
+				propagateSubtree(jobs[job], worlds);
+			}
+		});
+
+		stats.jobs = static_cast<uint32_t>(jobs.size());
+		for (auto& job : jobs)
+		{
+			stats.propagated += job.propagated;
+		}
+	}
+
+	bool LveSceneGraph::updateNode(uint32_t node, bool parentChanged, LveComponentPool<WorldTransformComponent>& worlds)
+	{
+		if (!parentChanged && !localDirty[node])
+			return false;
+
+		auto parent = parentNodes[node];
+		if (parent == NONE)
+		{
+			world[node] = localWorld[node];
+			normal[node] = localNormal[node];
+		}
+		else
+		{
+			// the inverse transpose of a product is the product of the inverse transposes
+			world[node] = world[parent] * localWorld[node];
+			normal[node] = normal[parent] * localNormal[node];
+		}
+		localDirty[node] = 0;
+
+		if (auto* target = worlds.tryGet(nodeEntities[node]))
+		{
+			target->world = world[node];
+			target->normal = normal[node];
+		}
+		return true;
+	}
+
+	void LveSceneGraph::propagateSubtree(SubtreeJob& job, LveComponentPool<WorldTransformComponent>& worlds)
+	{
+		auto end = job.node + subtreeSizes[job.node];
+		changed[job.node] = updateNode(job.node, job.parentChanged, worlds) ? 1 : 0;
+		job.propagated += changed[job.node];
+		dirtyDescendants[job.node] = 0;
+
+		// parents come first, changed of the parent is final when a node is reached
+		for (auto node = job.node + 1; node < end;)
+		{
+			bool parentChanged = changed[parentNodes[node]] != 0;
+			if (!parentChanged && !localDirty[node] && !dirtyDescendants[node])
+			{
+				// nothing moved in here
+				changed[node] = 0;
+				node += subtreeSizes[node];
+				continue;
+			}
+
+			changed[node] = updateNode(node, parentChanged, worlds) ? 1 : 0;
+			job.propagated += changed[node];
+			dirtyDescendants[node] = 0;
+			node++;
+		}
+	}
+}
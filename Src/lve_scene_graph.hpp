@@ -0,0 +1,137 @@
+#pragma once
+
+#include "lve_ecs.hpp"
+#include "lve_game_object.hpp"
+#include "lve_job_system.hpp"
+
+//libs
+#define GLM_FORCE_RADIANSE
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//std
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace lve {
+
+	// Parent/child links between entities. The TransformComponent of a child is relative to its parent, the
+	// WorldTransformComponent of every node is the product of the local matrices up to its root.
+	//
+	// Nodes are kept in one flat array in depth first order: a parent always precedes its children and every
+	// subtree is the contiguous range [node, node + subtreeSize). propagate is a single forward pass over it that
+	// jumps over subtrees without a dirty node, and hands subtrees whose parent is already final to the job system,
+	// so deep rigs cost one matrix product per moved node and no recursion.
+	// The order is rebuilt on the first update after the links changed.
+	class LveSceneGraph
+	{
+	public:
+		static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+		// subtrees up to this many nodes are propagated by one job, bigger ones are split at their children
+		static constexpr uint32_t SPLIT_SIZE = 1024;
+
+		struct Stats
+		{
+			uint32_t nodes = 0;
+			// nodes whose world matrix was recomputed
+			uint32_t propagated = 0;
+			uint32_t jobs = 0;
+		};
+
+		LveSceneGraph() = default;
+
+		LveSceneGraph(const LveSceneGraph&) = delete;
+		void operator=(const LveSceneGraph&) = delete;
+
+		/// <summary>
+		/// Attach child to parent, a null parent detaches it. The local transform of child is kept as it is,
+		/// so it jumps to the same offset from its new parent
+		/// </summary>
+		void setParent(LveEntity child, LveEntity parent);
+		/// <returns>null if entity has no parent</returns>
+		LveEntity getParent(LveEntity entity) const;
+		/// <summary>
+		/// Detach entity from its parent and its children from it, they become roots. Call before destroying a linked entity
+		/// </summary>
+		void remove(LveEntity entity);
+
+		/// <summary>
+		/// Rebuild the flat order if links changed since the last call. Rebuilding marks the TransformComponent of every old and new node dirty,
+		/// the local matrices of the new nodes and the world matrices of the dropped ones have to be written again
+		/// </summary>
+		void updateOrder(LveRegistry& registry);
+
+		/// <returns>NONE if entity is not linked to anything</returns>
+		uint32_t nodeOf(LveEntity entity) const
+		{
+			return entity.index < nodeIndices.size() && nodeIndices[entity.index] != NONE && nodeEntities[nodeIndices[entity.index]] == entity
+				? nodeIndices[entity.index]
+				: NONE;
+		}
+
+		// written by TransformSystem, mark the node dirty after
+		glm::mat4& localMatrix(uint32_t node) { return localWorld[node]; }
+		glm::mat3& localNormalMatrix(uint32_t node) { return localNormal[node]; }
+		void markDirty(uint32_t node);
+
+		/// <summary>
+		/// Recompute the world matrices of dirty nodes and their descendants into their WorldTransformComponents.
+		/// The calling thread takes part in the jobs and returns when all are done
+		/// </summary>
+		void propagate(LveRegistry& registry, LveJobSystem& jobSystem);
+
+		// of the last propagate
+		const Stats& getStats() const { return stats; }
+
+	private:
+		struct Link
+		{
+			// the entity the slot was linked for, a stale one means the slot is unused
+			LveEntity entity{};
+			LveEntity parent{};
+			uint32_t childCount = 0;
+		};
+
+		struct SubtreeJob
+		{
+			uint32_t node;
+			// the world matrix of the parent changed, the whole subtree is recomputed
+			bool parentChanged;
+			uint32_t propagated;
+		};
+
+		/// <summary>
+		/// Link slot of entity, reset when it belonged to an earlier owner of the slot
+		/// </summary>
+		Link& linkOf(LveEntity entity);
+		/// <returns>whether the world matrix of node changed</returns>
+		bool updateNode(uint32_t node, bool parentChanged, LveComponentPool<WorldTransformComponent>& worlds);
+		void propagateSubtree(SubtreeJob& job, LveComponentPool<WorldTransformComponent>& worlds);
+
+		// by entity index
+		std::vector<Link> links;
+		std::vector<uint32_t> nodeIndices;
+		bool orderChanged = false;
+
+		// by node, depth first order
+		std::vector<LveEntity> nodeEntities;
+		std::vector<uint32_t> parentNodes;
+		std::vector<uint32_t> subtreeSizes;
+		std::vector<glm::mat4> localWorld;
+		std::vector<glm::mat3> localNormal;
+		std::vector<glm::mat4> world;
+		std::vector<glm::mat3> normal;
+		std::vector<uint8_t> localDirty;
+		// a node below is dirty, set up the ancestors by markDirty
+		std::vector<uint8_t> dirtyDescendants;
+		// world matrix recomputed by the current propagate, read by the children
+		std::vector<uint8_t> changed;
+
+		// per propagate scratch
+		std::vector<std::pair<uint32_t, bool>> splitStack;
+		std::vector<SubtreeJob> jobs;
+
+		Stats stats{};
+	};
+}
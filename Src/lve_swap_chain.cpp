@@ -48,7 +48,7 @@ LveSwapChain::~LveSwapChain() {
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.getAllocator().free(depthImageAllocations[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
@@ -299,7 +299,7 @@ void LveSwapChain::createDepthResources() {
   VkExtent2D swapChainExtent = getSwapChainExtent();
 
   depthImages.resize(imageCount());
-  depthImageMemorys.resize(imageCount());
+  depthImageAllocations.resize(imageCount());
   depthImageViews.resize(imageCount());
 
   for (int i = 0; i < depthImages.size(); i++) {
@@ -323,7 +323,7 @@ void LveSwapChain::createDepthResources() {
         imageInfo,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         depthImages[i],
-        depthImageMemorys[i]);
+        depthImageAllocations[i]);
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -6,7 +6,7 @@
 #include <vulkan/vulkan.h>
 #include "lve_texture_storage.hpp"
 #include <stdexcept>
-#include "lve_buffer.hpp"
+#include "lve_uploader.hpp"
 #include "Definitions/DefaultSamplersNames.hpp"
 #include "lve_swap_chain.hpp"
 
@@ -48,6 +48,7 @@ namespace lve {
 
         cv.notify_all();
         unloadThread.join();
+        LveJobSystem::shared().wait(pendingDestroys);
         while (!unloadQueue.empty())
         {
             auto& item = unloadQueue.front();
@@ -114,18 +115,6 @@ namespace lve {
             throw std::runtime_error("failed to load image!");
         }
 
-        LveBuffer stagingBuffer{
-            lveDevice,
-            imageSize,
-            1,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)pixels);
-        stbi_image_free(pixels);
-
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -145,26 +134,19 @@ namespace lve {
             imageInfo,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             imageData.image,
-            imageData.imageMemory
+            imageData.imageAllocation
         );
 
-        lveDevice.transitionImageLayout(
-            imageData.image,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            mipLevels
-        );
-
-        lveDevice.copyBufferToImage(
-            stagingBuffer.getBuffer(),
+        lveDevice.getUploader().uploadImage(
+            pixels,
+            imageSize,
             imageData.image,
+            VK_FORMAT_R8G8B8A8_SRGB,
             static_cast<uint32_t>(imageData.texWidth),
             static_cast<uint32_t>(imageData.texHeight),
-            1,
-            0//original image
+            mipLevels
         );
-
-        lveDevice.generateMipmaps(imageData.image, VK_FORMAT_R8G8B8A8_SRGB, imageData.texWidth, imageData.texHeight, mipLevels);
+        stbi_image_free(pixels);
     }
 
     bool LveTextureStorage::loadTexture(
@@ -266,7 +248,7 @@ namespace lve {
         vkDestroySampler(lveDevice.device(), data.sampler, nullptr);
         vkDestroyImageView(lveDevice.device(), data.imageView, nullptr);
         vkDestroyImage(lveDevice.device(), data.image, nullptr);
-        vkFreeMemory(lveDevice.device(), data.imageMemory, nullptr);
+        lveDevice.getAllocator().free(data.imageAllocation);
     }
 
     const VkDescriptorSet LveTextureStorage::getDescriptorSet(
@@ -313,7 +295,10 @@ namespace lve {
                 auto& item = unloadQueue.front();
                 if (item.unloadAskFrame < currentFrame - LveSwapChain::MAX_FRAMES_IN_FLIGHT)
                 {
-                    destroyAndFreeTextureData(item);
+                    LveJobSystem::shared().runOnMainThread(
+                        [this, data = std::move(item)]() { destroyAndFreeTextureData(data); },
+                        &pendingDestroys
+                    );
                     unloadQueue.pop();
                 }
                 else
@@ -2,6 +2,7 @@
 
 #include "lve_device.hpp"
 #include "lve_descriptors.hpp"
+#include "lve_job_system.hpp"
 
 #include <string>
 #include <unordered_map>
@@ -18,7 +19,7 @@ namespace lve
 		{
 			VkImage image;
 			VkImageView imageView;
-			VkDeviceMemory imageMemory;
+			LveAllocation imageAllocation;
 			int texWidth;
 			int texHeight;
 			std::unordered_map<std::string, VkDescriptorSet> textureDescriptors;
@@ -73,8 +74,12 @@ namespace lve
 
 		std::shared_ptr<LveRenderer> lveRenderer;
 
+		// picks the textures no frame in flight uses anymore, the main thread destroys them:
+		// the descriptor pool and the device objects are only touched there
 		std::thread unloadThread;
 		std::queue<TextureData> unloadQueue;
+		// destructions queued with runOnMainThread
+		LveJobCounter pendingDestroys;
 		std::mutex qM;
 		std::condition_variable cv;
 		volatile bool requestDestruct = false;
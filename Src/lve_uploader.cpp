@@ -0,0 +1,515 @@
+#include "lve_uploader.hpp"
+
+#include "lve_device.hpp"
+#include "lve_job_system.hpp"
+#include "Helpers/VulkanHelpers.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+	LveUploader::LveUploader(LveDevice& device) : lveDevice{ device }
+	{
+		assert(LveJobSystem::shared().isMainThread() && "the uploader submits from the main thread of the job system");
+
+		auto indices = lveDevice.findPhysicalQueueFamilies();
+		graphicsFamily = indices.graphicsFamily;
+		transferFamily = indices.transferFamily;
+		dedicatedTransfer = indices.hasDedicatedTransfer();
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = graphicsFamily;
+
+		auto result = vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &graphicsPool);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload command pool!" + VulkanHelpers::AsString(result));
+		}
+
+		if (dedicatedTransfer)
+		{
+			poolInfo.queueFamilyIndex = transferFamily;
+			result = vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &transferPool);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create transfer command pool!" + VulkanHelpers::AsString(result));
+			}
+		}
+
+		ring = createStagingBuffer(STAGING_RING_SIZE);
+	}
+
+	LveUploader::~LveUploader()
+	{
+		if (flushRequested)
+		{
+			// the queued flush must not outlive the uploader
+			LveJobSystem::shared().runMainThreadJobs();
+		}
+
+		std::lock_guard lock{ mutex };
+		for (auto& batch : inFlight)
+		{
+			vkWaitForFences(lveDevice.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+			releaseBatch(batch);
+		}
+		inFlight.clear();
+
+		// recorded but never flushed
+		if (pending.transferCommands != VK_NULL_HANDLE)
+		{
+			vkEndCommandBuffer(pending.transferCommands);
+		}
+		if (pending.graphicsCommands != VK_NULL_HANDLE)
+		{
+			vkEndCommandBuffer(pending.graphicsCommands);
+		}
+		releaseBatch(pending);
+
+		auto device = lveDevice.device();
+		for (auto semaphore : freeSemaphores)
+		{
+			vkDestroySemaphore(device, semaphore, nullptr);
+		}
+		for (auto fence : freeFences)
+		{
+			vkDestroyFence(device, fence, nullptr);
+		}
+
+		vkDestroyBuffer(device, ring.buffer, nullptr);
+		lveDevice.getAllocator().free(ring.allocation);
+
+		// command buffers are freed together with their pools
+		vkDestroyCommandPool(lveDevice.device(), graphicsPool, nullptr);
+		if (transferPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(lveDevice.device(), transferPool, nullptr);
+		}
+	}
+
+	void LveUploader::uploadBuffer(
+		const void* data,
+		VkDeviceSize size,
+		VkBuffer dstBuffer,
+		VkDeviceSize dstOffset,
+		VkPipelineStageFlags dstStage,
+		VkAccessFlags dstAccess
+	)
+	{
+		std::lock_guard lock{ mutex };
+		auto staging = writeStaging(data, size);
+
+		auto commandBuffer = transferCommands();
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = staging.offset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(commandBuffer, staging.buffer, dstBuffer, 1, &copyRegion);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.buffer = dstBuffer;
+		barrier.offset = dstOffset;
+		barrier.size = size;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		if (!dedicatedTransfer)
+		{
+			barrier.dstAccessMask = dstAccess;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			return;
+		}
+
+		// release on the transfer queue, acquire on the graphics queue with the same barrier
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = transferFamily;
+		barrier.dstQueueFamilyIndex = graphicsFamily;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(graphicsCommands(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void LveUploader::uploadImage(
+		const void* pixels,
+		VkDeviceSize size,
+		VkImage image,
+		VkFormat format,
+		uint32_t width,
+		uint32_t height,
+		uint32_t mipLevels
+	)
+	{
+		std::lock_guard lock{ mutex };
+		auto staging = writeStaging(pixels, size);
+
+		auto commandBuffer = transferCommands();
+		lveDevice.transitionImageLayout(
+			commandBuffer,
+			image,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			mipLevels
+		);
+		lveDevice.copyBufferToImage(commandBuffer, staging.buffer, staging.offset, image, width, height, 1, 0);
+
+		if (dedicatedTransfer)
+		{
+			// the whole chain changes owner, mipmaps are blitted on the graphics queue
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = mipLevels;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(graphicsCommands(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		lveDevice.generateMipmaps(
+			graphicsCommands(),
+			image,
+			format,
+			static_cast<int32_t>(width),
+			static_cast<int32_t>(height),
+			mipLevels
+		);
+	}
+
+	LveUploader::Ticket LveUploader::flush()
+	{
+		std::lock_guard lock{ mutex };
+		return flushLocked();
+	}
+
+	LveUploader::Ticket LveUploader::flushLocked()
+	{
+		assert(LveJobSystem::shared().isMainThread() && "uploads are submitted from the main thread");
+		flushRequested = false;
+		if (pending.transferCommands == VK_NULL_HANDLE && pending.graphicsCommands == VK_NULL_HANDLE)
+		{
+			return nextTicket - 1;
+		}
+
+		auto device = lveDevice.device();
+
+		VkResult result;
+		if (!freeFences.empty())
+		{
+			pending.fence = freeFences.back();
+			freeFences.pop_back();
+		}
+		else
+		{
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			result = vkCreateFence(device, &fenceInfo, nullptr, &pending.fence);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create upload fence!" + VulkanHelpers::AsString(result));
+			}
+		}
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		if (pending.transferCommands != VK_NULL_HANDLE)
+		{
+			vkEndCommandBuffer(pending.transferCommands);
+
+			if (!freeSemaphores.empty())
+			{
+				pending.transferDone = freeSemaphores.back();
+				freeSemaphores.pop_back();
+			}
+			else
+			{
+				VkSemaphoreCreateInfo semaphoreInfo = {};
+				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+				result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &pending.transferDone);
+				if (result != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create upload semaphore!" + VulkanHelpers::AsString(result));
+				}
+			}
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &pending.transferCommands;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &pending.transferDone;
+
+			result = vkQueueSubmit(lveDevice.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit transfer command buffer!" + VulkanHelpers::AsString(result));
+			}
+		}
+
+		// even without graphics work the fence goes through the graphics queue: it also
+		// has to cover the semaphore wait before staging memory can be reused
+		if (pending.graphicsCommands != VK_NULL_HANDLE)
+		{
+			vkEndCommandBuffer(pending.graphicsCommands);
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = pending.graphicsCommands != VK_NULL_HANDLE ? 1 : 0;
+		submitInfo.pCommandBuffers = &pending.graphicsCommands;
+		submitInfo.waitSemaphoreCount = pending.transferDone != VK_NULL_HANDLE ? 1 : 0;
+		submitInfo.pWaitSemaphores = &pending.transferDone;
+		submitInfo.pWaitDstStageMask = &waitStage;
+
+		result = vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, pending.fence);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to submit upload command buffer!" + VulkanHelpers::AsString(result));
+		}
+
+		pending.ticket = nextTicket++;
+		auto ticket = pending.ticket;
+		inFlight.push_back(std::move(pending));
+		pending = Batch{};
+
+		return ticket;
+	}
+
+	void LveUploader::collect()
+	{
+		std::lock_guard lock{ mutex };
+		collectLocked();
+	}
+
+	void LveUploader::collectLocked()
+	{
+		while (!inFlight.empty())
+		{
+			auto& batch = inFlight.front();
+			if (vkGetFenceStatus(lveDevice.device(), batch.fence) != VK_SUCCESS)
+			{
+				return;
+			}
+
+			completedTicket = batch.ticket;
+			ringTail = std::max(ringTail, batch.ringEnd);
+			releaseBatch(batch);
+			inFlight.pop_front();
+		}
+	}
+
+	bool LveUploader::isComplete(Ticket ticket)
+	{
+		std::lock_guard lock{ mutex };
+		collectLocked();
+		return ticket <= completedTicket;
+	}
+
+	void LveUploader::wait(Ticket ticket)
+	{
+		std::lock_guard lock{ mutex };
+		for (auto& batch : inFlight)
+		{
+			if (batch.ticket > ticket)
+				break;
+
+			vkWaitForFences(lveDevice.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+		}
+
+		collectLocked();
+	}
+
+	LveUploader::StagingBuffer LveUploader::createStagingBuffer(VkDeviceSize size)
+	{
+		StagingBuffer staging{};
+		lveDevice.createBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			staging.buffer,
+			staging.allocation
+		);
+
+		return staging;
+	}
+
+	LveUploader::StagingRegion LveUploader::writeStaging(const void* data, VkDeviceSize size)
+	{
+		if (size <= STAGING_RING_SIZE)
+		{
+			VkDeviceSize position = 0;
+			bool reserved = reserveRing(size, position);
+			// ring full: retire finished batches, submit the pending one, then wait for the oldest
+			auto& jobSystem = LveJobSystem::shared();
+			while (!reserved)
+			{
+				collectLocked();
+				reserved = reserveRing(size, position);
+				if (reserved)
+					break;
+
+				if (pending.ringEnd > ringTail)
+				{
+					if (jobSystem.isMainThread())
+					{
+						flushLocked();
+					}
+					else if (!flushRequested)
+					{
+						// workers don`t submit, the main thread flushes at its next runMainThreadJobs or wait
+						flushRequested = true;
+						jobSystem.runOnMainThread([this]() { flush(); });
+					}
+				}
+				if (inFlight.empty())
+					break;
+
+				vkWaitForFences(lveDevice.device(), 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+			}
+
+			if (reserved)
+			{
+				std::memcpy(static_cast<char*>(ring.allocation.mapped) + position, data, static_cast<size_t>(size));
+				return StagingRegion{ ring.buffer, position };
+			}
+		}
+
+		overflowCount++;
+		auto staging = createStagingBuffer(size);
+		std::memcpy(staging.allocation.mapped, data, static_cast<size_t>(size));
+		pending.overflowBuffers.push_back(staging);
+
+		return StagingRegion{ staging.buffer, 0 };
+	}
+
+	bool LveUploader::reserveRing(VkDeviceSize size, VkDeviceSize& position)
+	{
+		uint64_t head = (ringHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+		if (ringTail == ringHead)
+		{
+			// nothing lives in the ring, start at its beginning so even a ring sized region fits
+			head = (ringHead + STAGING_RING_SIZE - 1) / STAGING_RING_SIZE * STAGING_RING_SIZE;
+			ringTail = head;
+		}
+
+		position = head % STAGING_RING_SIZE;
+		if (position + size > STAGING_RING_SIZE)
+		{
+			//regions never wrap, the rest of the ring is skipped
+			head += STAGING_RING_SIZE - position;
+			position = 0;
+		}
+
+		if (head + size - ringTail > STAGING_RING_SIZE)
+			return false;
+
+		ringHead = head + size;
+		pending.ringEnd = ringHead;
+		return true;
+	}
+
+	VkCommandBuffer LveUploader::beginCommands(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList)
+	{
+		VkCommandBuffer commandBuffer;
+		if (!freeList.empty())
+		{
+			commandBuffer = freeList.back();
+			freeList.pop_back();
+			vkResetCommandBuffer(commandBuffer, 0);
+		}
+		else
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = pool;
+			allocInfo.commandBufferCount = 1;
+
+			auto result = vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer);
+			if (result != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate upload command buffer!" + VulkanHelpers::AsString(result));
+			}
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		return commandBuffer;
+	}
+
+	VkCommandBuffer LveUploader::transferCommands()
+	{
+		if (!dedicatedTransfer)
+			return graphicsCommands();
+
+		if (pending.transferCommands == VK_NULL_HANDLE)
+		{
+			pending.transferCommands = beginCommands(transferPool, freeTransferCommands);
+		}
+
+		return pending.transferCommands;
+	}
+
+	VkCommandBuffer LveUploader::graphicsCommands()
+	{
+		if (pending.graphicsCommands == VK_NULL_HANDLE)
+		{
+			pending.graphicsCommands = beginCommands(graphicsPool, freeGraphicsCommands);
+		}
+
+		return pending.graphicsCommands;
+	}
+
+	void LveUploader::releaseBatch(Batch& batch)
+	{
+		if (batch.transferCommands != VK_NULL_HANDLE)
+		{
+			freeTransferCommands.push_back(batch.transferCommands);
+		}
+		if (batch.graphicsCommands != VK_NULL_HANDLE)
+		{
+			freeGraphicsCommands.push_back(batch.graphicsCommands);
+		}
+		if (batch.transferDone != VK_NULL_HANDLE)
+		{
+			freeSemaphores.push_back(batch.transferDone);
+		}
+		if (batch.fence != VK_NULL_HANDLE)
+		{
+			vkResetFences(lveDevice.device(), 1, &batch.fence);
+			freeFences.push_back(batch.fence);
+		}
+
+		for (auto& staging : batch.overflowBuffers)
+		{
+			vkDestroyBuffer(lveDevice.device(), staging.buffer, nullptr);
+			lveDevice.getAllocator().free(staging.allocation);
+		}
+
+		batch = Batch{};
+	}
+
+}  // namespace lve
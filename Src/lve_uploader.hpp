@@ -0,0 +1,161 @@
+#pragma once
+
+#include "lve_allocator.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	class LveDevice;
+
+	// Records CPU->GPU uploads into batches and submits them without waiting on the host.
+	// With a dedicated transfer queue copies run there and ownership of the resources is
+	// released to the graphics queue; the graphics side acquires them (and generates mipmaps)
+	// in a small submit that waits on the transfer semaphore. Every later graphics submit is
+	// ordered after those acquire barriers, so frames can use the resources right away.
+	//
+	// Staging data goes through one persistently mapped ring buffer. Each batch remembers
+	// where its ring regions end and the ring tail moves past them once the batch fence is
+	// signaled. When the ring is full, recording retires finished batches, submits the pending
+	// one and waits for the oldest batch in flight, so loading many assets in a row keeps
+	// cycling through the ring. Only uploads bigger than the ring, or that still don`t fit once
+	// nothing is left to wait for, get a temporary overflow buffer.
+	//
+	// Recording is thread safe. Submission is not: it stays on the main thread of
+	// LveJobSystem::shared(), which also submits frames. flush() has to be called there
+	// (LveRenderer does it before each frame submit); a job that fills the ring queues the
+	// flush with runOnMainThread instead of submitting itself.
+	class LveUploader {
+	public:
+		using Ticket = uint64_t;
+
+		LveUploader(LveDevice& device);
+		~LveUploader();
+
+		LveUploader(const LveUploader&) = delete;
+		LveUploader& operator=(const LveUploader&) = delete;
+
+		/// <summary>
+		/// Copy data into dstBuffer. data can be released right after the call
+		/// </summary>
+		/// <param name="dstStage">First stage that reads the buffer</param>
+		/// <param name="dstAccess">How that stage reads it</param>
+		void uploadBuffer(
+			const void* data,
+			VkDeviceSize size,
+			VkBuffer dstBuffer,
+			VkDeviceSize dstOffset,
+			VkPipelineStageFlags dstStage,
+			VkAccessFlags dstAccess
+		);
+
+		/// <summary>
+		/// Upload mip 0 of a 2d image, generate the rest of the chain and leave the image
+		/// in SHADER_READ_ONLY_OPTIMAL. Image must be in UNDEFINED layout
+		/// </summary>
+		void uploadImage(
+			const void* pixels,
+			VkDeviceSize size,
+			VkImage image,
+			VkFormat format,
+			uint32_t width,
+			uint32_t height,
+			uint32_t mipLevels
+		);
+
+		/// <summary>
+		/// Submit everything recorded since the last flush
+		/// </summary>
+		/// <returns>Ticket of the submitted batch, or of the last batch when nothing was recorded</returns>
+		Ticket flush();
+
+		/// <summary>
+		/// Release staging memory of finished batches. Never blocks
+		/// </summary>
+		void collect();
+
+		bool isComplete(Ticket ticket);
+		void wait(Ticket ticket);
+
+		bool hasDedicatedTransferQueue() const { return dedicatedTransfer; }
+		// uploads that did not fit into the staging ring
+		uint64_t getOverflowCount() const { return overflowCount; }
+
+		static constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+
+	private:
+		// satisfies bufferOffset rules of vkCmdCopyBufferToImage for every format we upload
+		static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+		struct StagingBuffer
+		{
+			VkBuffer buffer;
+			LveAllocation allocation;
+		};
+
+		struct StagingRegion
+		{
+			VkBuffer buffer;
+			VkDeviceSize offset;
+		};
+
+		struct Batch
+		{
+			Ticket ticket = 0;
+			VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+			VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+			VkSemaphore transferDone = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			// ring head after the last region of this batch
+			uint64_t ringEnd = 0;
+			std::vector<StagingBuffer> overflowBuffers;
+		};
+
+		StagingBuffer createStagingBuffer(VkDeviceSize size);
+		StagingRegion writeStaging(const void* data, VkDeviceSize size);
+		/// <returns>false if the ring has no room for size bytes right now</returns>
+		bool reserveRing(VkDeviceSize size, VkDeviceSize& position);
+		Ticket flushLocked();
+		VkCommandBuffer beginCommands(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+		VkCommandBuffer transferCommands();
+		VkCommandBuffer graphicsCommands();
+		void releaseBatch(Batch& batch);
+		void collectLocked();
+
+		LveDevice& lveDevice;
+
+		uint32_t graphicsFamily;
+		uint32_t transferFamily;
+		bool dedicatedTransfer;
+
+		VkCommandPool graphicsPool = VK_NULL_HANDLE;
+		VkCommandPool transferPool = VK_NULL_HANDLE;
+
+		StagingBuffer ring;
+		// monotonic byte counters, position in the ring is counter % STAGING_RING_SIZE
+		uint64_t ringHead = 0;
+		uint64_t ringTail = 0;
+		uint64_t overflowCount = 0;
+
+		// recycled between batches so steady state uploads create no Vulkan objects
+		std::vector<VkCommandBuffer> freeGraphicsCommands;
+		std::vector<VkCommandBuffer> freeTransferCommands;
+		std::vector<VkSemaphore> freeSemaphores;
+		std::vector<VkFence> freeFences;
+
+		std::mutex mutex;
+		Batch pending;
+		std::deque<Batch> inFlight;
+		// a flush is queued on the main thread
+		bool flushRequested = false;
+		Ticket nextTicket = 1;
+		Ticket completedTicket = 0;
+	};
+
+}  // namespace lve
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace lve {
@@ -11,4 +13,35 @@ namespace lve {
 		seed ^= std::hash<T>{}(v)+0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hash_combine(seed, rest), ...);
 	}
-}//namespace lve
\ No newline at end of file
+
+	// Hash of raw bytes, 8 at a time with a murmur3 finalizer.
+	// Meant for tightly packed POD keys where equal values have equal bytes.
+	inline uint64_t hashBytes(const void* data, size_t size)
+	{
+		constexpr uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+
+		auto bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = size * multiplier;
+		for (; size >= 8; bytes += 8, size -= 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes, 8);
+			hash = (hash ^ word) * multiplier;
+			hash ^= hash >> 29;
+		}
+
+		if (size > 0)
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, bytes, size);
+			hash = (hash ^ word) * multiplier;
+		}
+
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+}//namespace lve
@@ -0,0 +1,267 @@
+#include "lve_vertex_quantizer.hpp"
+
+//libs
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace lve {
+
+	static_assert(sizeof(LveVertexQuantizer::CompactVertex) == 20, "CompactVertex has to be tightly packed");
+	static_assert(sizeof(LveVertexQuantizer::Compact16Vertex) == 16, "Compact16Vertex has to be tightly packed");
+
+	namespace {
+
+		constexpr float UNORM16_MAX = 65535.f;
+
+		glm::vec2 octEncode(glm::vec3 n)
+		{
+			float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+			if (sum == 0.f)
+				return glm::vec2{ 0.f };
+
+			n /= sum;
+			glm::vec2 e{ n.x, n.y };
+			if (n.z < 0.f)
+			{
+				e = glm::vec2{
+					(1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+					(1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f)
+				};
+			}
+			return e;
+		}
+
+		// same as octDecode in the compact vertex shaders
+		glm::vec3 octDecode(glm::vec2 e)
+		{
+			glm::vec3 n{ e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y) };
+			float t = std::max(-n.z, 0.f);
+			n.x += n.x >= 0.f ? -t : t;
+			n.y += n.y >= 0.f ? -t : t;
+			return glm::normalize(n);
+		}
+
+		uint16_t quantizeUnorm16(float value, float min, float extent)
+		{
+			if (extent <= 0.f)
+				return 0;
+
+			return static_cast<uint16_t>(std::lround(std::clamp((value - min) / extent, 0.f, 1.f) * UNORM16_MAX));
+		}
+
+		int16_t quantizeSnorm16(float value)
+		{
+			return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+		}
+
+		// 0..254, 127 is zero, decoded as (v - 127) / 127
+		uint8_t quantizeOct8(float value)
+		{
+			return static_cast<uint8_t>(std::lround(std::clamp(value, -1.f, 1.f) * 127.f) + 127);
+		}
+
+		uint8_t quantizeUnorm8(float value)
+		{
+			return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+		}
+
+		void encodeShared(const LveModel::Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& extent, uint16_t* position, uint8_t* color, uint16_t* uv)
+		{
+			position[0] = quantizeUnorm16(vertex.position.x, boundsMin.x, extent.x);
+			position[1] = quantizeUnorm16(vertex.position.y, boundsMin.y, extent.y);
+			position[2] = quantizeUnorm16(vertex.position.z, boundsMin.z, extent.z);
+			position[3] = 0;
+
+			color[0] = quantizeUnorm8(vertex.color.r);
+			color[1] = quantizeUnorm8(vertex.color.g);
+			color[2] = quantizeUnorm8(vertex.color.b);
+			color[3] = 255;
+
+			uv[0] = glm::packHalf1x16(vertex.uv.x);
+			uv[1] = glm::packHalf1x16(vertex.uv.y);
+		}
+
+		void decodeShared(LveModel::Vertex& vertex, const glm::mat4& positionDecode, const uint16_t* position, const uint8_t* color, const uint16_t* uv)
+		{
+			glm::vec4 unorm{
+				position[0] / UNORM16_MAX,
+				position[1] / UNORM16_MAX,
+				position[2] / UNORM16_MAX,
+				1.f
+			};
+			vertex.position = glm::vec3(positionDecode * unorm);
+			vertex.color = glm::vec3{ color[0], color[1], color[2] } / 255.f;
+			vertex.uv = { glm::unpackHalf1x16(uv[0]), glm::unpackHalf1x16(uv[1]) };
+		}
+
+	}//namespace
+
+	uint32_t LveVertexQuantizer::vertexStride(LveModel::VertexFormat format)
+	{
+		switch (format)
+		{
+		case LveModel::VertexFormat::Full:
+			return sizeof(LveModel::Vertex);
+		case LveModel::VertexFormat::Compact:
+			return sizeof(CompactVertex);
+		case LveModel::VertexFormat::Compact16:
+			return sizeof(Compact16Vertex);
+		}
+
+		assert(false && "unknown vertex format");
+		return 0;
+	}
+
+	glm::mat4 LveVertexQuantizer::getPositionDecode(LveModel::VertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		if (format == LveModel::VertexFormat::Full)
+			return glm::mat4{ 1.f };
+
+		return glm::scale(glm::translate(glm::mat4{ 1.f }, boundsMin), boundsMax - boundsMin);
+	}
+
+	std::vector<uint8_t> LveVertexQuantizer::encode(
+		LveModel::VertexFormat format,
+		const LveModel::Vertex* vertices,
+		size_t vertexCount,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax
+	)
+	{
+		std::vector<uint8_t> encoded(vertexCount * vertexStride(format));
+		auto extent = boundsMax - boundsMin;
+
+		switch (format)
+		{
+		case LveModel::VertexFormat::Full:
+			std::memcpy(encoded.data(), vertices, encoded.size());
+			break;
+
+		case LveModel::VertexFormat::Compact:
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				CompactVertex packed{};
+				encodeShared(vertices[i], boundsMin, extent, packed.position, packed.color, packed.uv);
+
+				auto oct = octEncode(vertices[i].normal);
+				packed.normal[0] = quantizeSnorm16(oct.x);
+				packed.normal[1] = quantizeSnorm16(oct.y);
+				std::memcpy(encoded.data() + i * sizeof(CompactVertex), &packed, sizeof(CompactVertex));
+			}
+			break;
+
+		case LveModel::VertexFormat::Compact16:
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				Compact16Vertex packed{};
+				encodeShared(vertices[i], boundsMin, extent, packed.position, packed.color, packed.uv);
+
+				auto oct = octEncode(vertices[i].normal);
+				packed.position[3] = static_cast<uint16_t>(quantizeOct8(oct.x) | (quantizeOct8(oct.y) << 8));
+				std::memcpy(encoded.data() + i * sizeof(Compact16Vertex), &packed, sizeof(Compact16Vertex));
+			}
+			break;
+		}
+
+		return encoded;
+	}
+
+	LveModel::Vertex LveVertexQuantizer::decode(
+		LveModel::VertexFormat format,
+		const uint8_t* vertex,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax
+	)
+	{
+		LveModel::Vertex decoded{};
+		auto positionDecode = getPositionDecode(format, boundsMin, boundsMax);
+
+		switch (format)
+		{
+		case LveModel::VertexFormat::Full:
+			std::memcpy(&decoded, vertex, sizeof(LveModel::Vertex));
+			break;
+
+		case LveModel::VertexFormat::Compact:
+		{
+			CompactVertex packed;
+			std::memcpy(&packed, vertex, sizeof(CompactVertex));
+			decodeShared(decoded, positionDecode, packed.position, packed.color, packed.uv);
+			// snorm rule: max(c / 32767, -1)
+			decoded.normal = octDecode({
+				std::max(packed.normal[0] / 32767.f, -1.f),
+				std::max(packed.normal[1] / 32767.f, -1.f)
+			});
+			break;
+		}
+
+		case LveModel::VertexFormat::Compact16:
+		{
+			Compact16Vertex packed;
+			std::memcpy(&packed, vertex, sizeof(Compact16Vertex));
+			decodeShared(decoded, positionDecode, packed.position, packed.color, packed.uv);
+			decoded.normal = octDecode({
+				((packed.position[3] & 0xFF) - 127.f) / 127.f,
+				((packed.position[3] >> 8) - 127.f) / 127.f
+			});
+			break;
+		}
+		}
+
+		return decoded;
+	}
+
+	LveVertexQuantizer::ErrorBound LveVertexQuantizer::measureError(
+		LveModel::VertexFormat format,
+		const LveModel::Vertex* vertices,
+		size_t vertexCount,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax
+	)
+	{
+		auto encoded = encode(format, vertices, vertexCount, boundsMin, boundsMax);
+		auto stride = vertexStride(format);
+
+		ErrorBound bound{};
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			auto& source = vertices[i];
+			auto decoded = decode(format, encoded.data() + i * stride, boundsMin, boundsMax);
+
+			auto maxAbs = [](const auto& a, const auto& b) {
+				auto difference = glm::abs(a - b);
+				float result = 0.f;
+				for (int component = 0; component < difference.length(); component++)
+				{
+					result = std::max(result, difference[component]);
+				}
+				return result;
+			};
+
+			bound.position = std::max(bound.position, maxAbs(source.position, decoded.position));
+			bound.color = std::max(bound.color, maxAbs(glm::clamp(source.color, 0.f, 1.f), decoded.color));
+			bound.uv = std::max(bound.uv, maxAbs(source.uv, decoded.uv));
+
+			// shaders normalize the decoded normal
+			float normalLength = glm::length(source.normal);
+			float decodedLength = glm::length(decoded.normal);
+			if (normalLength > 0.f && decodedLength > 0.f)
+			{
+				// atan2 stays accurate for the tiny angles acos loses in rounding
+				auto a = source.normal / normalLength;
+				auto b = decoded.normal / decodedLength;
+				float angle = std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+				bound.normalDegrees = std::max(bound.normalDegrees, glm::degrees(angle));
+			}
+		}
+
+		return bound;
+	}
+
+}//namespace lve
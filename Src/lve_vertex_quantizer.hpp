@@ -0,0 +1,83 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+//libs
+#include <glm/glm.hpp>
+
+//std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Encoding of LveModel::Vertex into the packed VertexFormat layouts.
+	// Positions are stored as unorm16 inside the mesh bounds; getPositionDecode() maps them back and is
+	// folded into the model matrix, so shaders only unpack normals. Normals use octahedral encoding.
+	class LveVertexQuantizer
+	{
+	public:
+		// 20 bytes
+		struct CompactVertex
+		{
+			uint16_t position[4];
+			int16_t normal[2];
+			uint8_t color[4];
+			uint16_t uv[2];
+		};
+
+		// 16 bytes, position[3] holds the oct normal as two snorm8 values
+		struct Compact16Vertex
+		{
+			uint16_t position[4];
+			uint8_t color[4];
+			uint16_t uv[2];
+		};
+
+		// max abs difference between source and decoded vertices
+		struct ErrorBound
+		{
+			// object space units
+			float position = 0.f;
+			float normalDegrees = 0.f;
+			float color = 0.f;
+			float uv = 0.f;
+		};
+
+		static uint32_t vertexStride(LveModel::VertexFormat format);
+
+		/// <summary>
+		/// Maps decoded unorm positions to object space, identity for Full
+		/// </summary>
+		static glm::mat4 getPositionDecode(LveModel::VertexFormat format, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+		/// <param name="boundsMin, boundsMax">have to contain every vertex position</param>
+		/// <returns>vertexCount * vertexStride(format) bytes</returns>
+		static std::vector<uint8_t> encode(
+			LveModel::VertexFormat format,
+			const LveModel::Vertex* vertices,
+			size_t vertexCount,
+			const glm::vec3& boundsMin,
+			const glm::vec3& boundsMax
+		);
+
+		/// <summary>
+		/// What the vertex shader of format sees for one encoded vertex, in object space
+		/// </summary>
+		static LveModel::Vertex decode(
+			LveModel::VertexFormat format,
+			const uint8_t* vertex,
+			const glm::vec3& boundsMin,
+			const glm::vec3& boundsMax
+		);
+
+		static ErrorBound measureError(
+			LveModel::VertexFormat format,
+			const LveModel::Vertex* vertices,
+			size_t vertexCount,
+			const glm::vec3& boundsMin,
+			const glm::vec3& boundsMax
+		);
+	};
+
+}//namespace lve
@@ -1,14 +1,92 @@
 #include "first_app.hpp"
+#include "Benchmarks/Benchmarks.hpp"
+#include "lve_job_system.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
-int main() {
-	lve::FirstApp app{};
+static lve::FirstApp::Settings parseSettings(int argc, char* argv[])
+{
+	lve::FirstApp::Settings settings{};
+	for (int i = 1; i < argc; i++)
+	{
+		auto nextValue = [&]() -> const char* {
+			if (i + 1 >= argc)
+			{
+				throw std::invalid_argument(std::string("missing value for ") + argv[i]);
+			}
+			return argv[++i];
+		};
+
+		if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			settings.headless = true;
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0)
+		{
+			settings.frameLimit = static_cast<uint32_t>(std::stoul(nextValue()));
+		}
+		else if (std::strcmp(argv[i], "--width") == 0)
+		{
+			settings.width = static_cast<uint32_t>(std::stoul(nextValue()));
+		}
+		else if (std::strcmp(argv[i], "--height") == 0)
+		{
+			settings.height = static_cast<uint32_t>(std::stoul(nextValue()));
+		}
+		else if (std::strcmp(argv[i], "--output") == 0)
+		{
+			settings.outputPath = nextValue();
+		}
+		else if (std::strcmp(argv[i], "--vertex-format") == 0)
+		{
+			std::string format = nextValue();
+			if (format == "full")
+				settings.vertexFormat = lve::LveModel::VertexFormat::Full;
+			else if (format == "compact")
+				settings.vertexFormat = lve::LveModel::VertexFormat::Compact;
+			else if (format == "compact16")
+				settings.vertexFormat = lve::LveModel::VertexFormat::Compact16;
+			else
+				throw std::invalid_argument("unknown vertex format: " + format + " (full, compact, compact16)");
+		}
+		else if (std::strcmp(argv[i], "--gpu-culling") == 0)
+		{
+			settings.gpuCulling = true;
+		}
+		else if (std::strcmp(argv[i], "--lights") == 0)
+		{
+			settings.extraLights = static_cast<uint32_t>(std::stoul(nextValue()));
+		}
+		else if (std::strcmp(argv[i], "--record-threads") == 0)
+		{
+			settings.recordThreads = static_cast<uint32_t>(std::stoul(nextValue()));
+		}
+		else
+		{
+			throw std::invalid_argument(std::string("unknown argument: ") + argv[i]);
+		}
+	}
 
+	return settings;
+}
+
+int main(int argc, char* argv[]) {
 	try
 	{
+		// created here so its main thread is this one
+		lve::LveJobSystem::shared();
+
+		if (argc >= 3 && std::strcmp(argv[1], "--bench") == 0)
+		{
+			return lve::runBenchmark(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+		}
+
+		lve::FirstApp app{ parseSettings(argc, argv) };
 		app.run();
 	}
 	catch (const std::exception &e)
@@ -18,4 +96,4 @@ int main() {
 	}
 
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}